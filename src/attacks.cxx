@@ -17,20 +17,27 @@
     along with this program; if not, write to the Free Software
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
+#include <stdio.h>
+#include <stdlib.h>
+
 #include "attacks.h"
 #include "board.h"
 #include "log.h"
+#include "random.h"
 
 BitBoard    Attacks::BlackPawn[64];
 BitBoard    Attacks::WhitePawn[64];
-BitBoard    Attacks::BishopA1H8[64][256];
-BitBoard    Attacks::BishopA8H1[64][256];
 BitBoard    Attacks::King[64];
 BitBoard    Attacks::Knight[64];
-BitBoard    Attacks::RookRank[64][256];
-BitBoard    Attacks::RookFile[64][256];
 BitBoard    Attacks::Rook[64];
 BitBoard    Attacks::Bishop[64];
+BitBoard    Attacks::RookOnRank[64];
+BitBoard    Attacks::RookOnFile[64];
+BitBoard    Attacks::BishopOnA1H8[64];
+BitBoard    Attacks::BishopOnA8H1[64];
+Magic       Attacks::RookMagic[64];
+Magic       Attacks::BishopMagic[64];
+BitBoard    Attacks::SlidingAttacks[ 0x19000 + 0x1480 ];
 BitBoard    Attacks::BlackPawnCouldAttack[64];
 BitBoard    Attacks::WhitePawnCouldAttack[64];
 BitBoard    Attacks::SquaresBetween[64][64];
@@ -39,12 +46,147 @@ int         Attacks::KingDistance[64][64];
 char        Attacks::Direction[64][64];
 char        Attacks::DirectionEx[64][64];   // Extended info
 
+// Directions (file and rank increments) for sliding pieces, terminated by a null direction
+static const int RankDeltas[][2]        = { {+1, 0}, {-1, 0}, {0, 0} };
+static const int FileDeltas[][2]        = { { 0,+1}, { 0,-1}, {0, 0} };
+static const int DiagA1H8Deltas[][2]    = { {+1,+1}, {-1,-1}, {0, 0} };
+static const int DiagA8H1Deltas[][2]    = { {+1,-1}, {-1,+1}, {0, 0} };
+static const int RookDeltas[][2]        = { {+1, 0}, {-1, 0}, { 0,+1}, { 0,-1}, {0, 0} };
+static const int BishopDeltas[][2]      = { {+1,+1}, {-1,-1}, {+1,-1}, {-1,+1}, {0, 0} };
+
+/*
+    Computes sliding attacks the slow way, by walking each direction until the
+    edge of the board or an occupied square.
+*/
+BitBoard Attacks::slidingAttacks( int square, Uint64 occupied, const int (* deltas)[2] )
+{
+    BitBoard result;
+
+    result.clear();
+
+    for( int d=0; deltas[d][0] != 0 || deltas[d][1] != 0; d++ ) {
+        int file = FileOfSquare(square) + deltas[d][0];
+        int rank = RankOfSquare(square) + deltas[d][1];
+
+        while( isValidSquare( file, rank ) ) {
+            int sq = FileRankToSquare( file, rank );
+
+            result.setBit( sq );
+
+            if( (occupied >> sq) & 1 ) {
+                break;
+            }
+
+            file += deltas[d][0];
+            rank += deltas[d][1];
+        }
+    }
+
+    return result;
+}
+
+#ifndef USE_PEXT
+static Uint64 randomUint64( Random & random )
+{
+    Uint32 lo = random.get();
+    Uint32 hi = random.get();
+
+    return BitBoard( lo, hi ).data;
+}
+#endif
+
+/*
+    Fills the attack tables of a sliding piece, and (unless pext is used) finds a magic
+    number for each square, i.e. a number that maps all relevant occupancies to table
+    entries without destructive collisions. Only sparse numbers are tried, as they
+    are much more likely to work.
+*/
+void Attacks::initializeMagics( Magic * magics, BitBoard * table, const int (* deltas)[2] )
+{
+    static BitBoard reference[4096];
+#ifndef USE_PEXT
+    static Uint64   occupancy[4096];
+    static int      epoch[4096];    // Attempt that last used each entry, saves clearing the table at each attempt
+    static int      attempt = 0;
+
+    Random random;
+#endif
+
+    for( int square=0; square<64; square++ ) {
+        Magic & m = magics[square];
+
+        // Pieces on the edges never block anything, unless the piece is itself on that edge
+        Uint64 edges = 0;
+
+        for( int i=0; i<64; i++ ) {
+            if( (RankOfSquare(i) == 0 || RankOfSquare(i) == 7) && RankOfSquare(i) != RankOfSquare(square) ) edges |= BitBoard::Set[i].data;
+            if( (FileOfSquare(i) == 0 || FileOfSquare(i) == 7) && FileOfSquare(i) != FileOfSquare(square) ) edges |= BitBoard::Set[i].data;
+        }
+
+        m.mask = slidingAttacks( square, 0, deltas ).data & ~edges;
+        m.shift = 64 - bitCount( m.mask );
+        m.magic = 0;
+        m.attacks = table;
+
+        // Enumerate all subsets of the mask (Carry-Rippler trick)
+        int n = 0;
+        Uint64 b = 0;
+
+        do {
+            reference[n] = slidingAttacks( square, b, deltas );
+#ifdef USE_PEXT
+            m.attacks[ m.index( b ) ] = reference[n];
+#else
+            occupancy[n] = b;
+#endif
+            n++;
+            b = (b - m.mask) & m.mask;
+        } while( b != 0 );
+
+#ifndef USE_PEXT
+        int i = 0;
+
+        while( i < n ) {
+            // Note: getBitBoard() is not used because it takes numbers from a fixed
+            // table that is reserved for the Zobrist keys
+            do {
+                m.magic = randomUint64( random ) & randomUint64( random ) & randomUint64( random );
+            } while( bitCount( (m.mask * m.magic) >> 56 ) < 6 );
+
+            attempt++;
+
+            for( i=0; i<n; i++ ) {
+                unsigned index = m.index( occupancy[i] );
+
+                if( epoch[index] < attempt ) {
+                    epoch[index] = attempt;
+                    m.attacks[index] = reference[i];
+                }
+                else if( m.attacks[index] != reference[i] ) {
+                    break;
+                }
+            }
+        }
+#endif
+
+        table += n;
+    }
+}
+
 /*
 */
 void Attacks::initialize()
 {
     int i, j;
 
+#if defined(USE_PEXT) && defined(__GNUC__)
+    if( ! __builtin_cpu_supports( "bmi2" ) ) {
+        printf( "*** Fatal: this program requires a processor with the BMI2 instruction set\n" );
+        Log::write( "*** Fatal: processor does not support BMI2\n" );
+        exit( 1 );
+    }
+#endif
+
     for( i=0; i<64; i++ ) {
         int rank = RankOfSquare(i);
         int file = FileOfSquare(i);
@@ -82,113 +224,20 @@ void Attacks::initialize()
         setBitByFileRank( WhitePawn[i], file-1, rank+1 );
     }
 
-    // Rook: ranks
-    for( i=0; i<64; i++ ) {
-        int rank = RankOfSquare(i);
-        int file = FileOfSquare(i);
-
-        for( int r=0; r<256; r++ ) {
-            RookRank[i][r].clear();
-
-            for( j = file-1; j >= 0; j-- ) {
-                RookRank[i][r].setBit( rank*8+j );             
-                if( r & (1 << j) ) break;
-            }
-            for( j = file+1; j < 8; j++ ) {
-                RookRank[i][r].setBit( rank*8+j );
-                if( r & (1 << j) ) break;
-            }
-        }
-    }
-
-    // Rook: files
-    for( i=0; i<64; i++ ) {
-        int rank = i / 8;
-        int file = i % 8;
-
-        for( int r=0; r<256; r++ ) {
-            RookFile[i][r].clear();
-
-            for( j = rank-1; j >= 0; j-- ) {
-                RookFile[i][r].setBit( file+8*j );             
-                if( r & (1 << j) ) break;
-            }
-            for( j = rank+1; j < 8; j++ ) {
-                RookFile[i][r].setBit( file+8*j );
-                if( r & (1 << j) ) break;
-            }
-        }
-    }
-
-    // Bishop: A1-H8 diagonal
-    for( i=0; i<64; i++ ) {
-        int rank = RankOfSquare(i);
-        int file = FileOfSquare(i);
-        int dpos = 0;
-        int dlen = 0;
-
-        // Compute position within diagonal
-        while( isValidSquare( rank-dpos, file-dpos ) ) dpos++;
-        dpos--;
-
-        // Move to beginning of diagonal
-        rank -= dpos;
-        file -= dpos;
-
-        // Compute diagonal length
-        while( isValidSquare( rank+dlen, file+dlen ) ) dlen++;
-
-        for( int r=0; r<256; r++ ) {
-            BishopA1H8[i][r].clear();
-
-            for( j = dpos-1; j >= 0; j-- ) {
-                setBitByFileRank( BishopA1H8[i][r], file+j, rank+j );
-                if( r & (1 << j) ) break;
-            }
-            for( j = dpos+1; j < dlen; j++ ) {
-                setBitByFileRank( BishopA1H8[i][r], file+j, rank+j );
-                if( r & (1 << j) ) break;
-            }
-        }
-    }
-
-    // Bishop: A8-H1 diagonal
+    // Rook and bishop (regardless of interposing pieces)
     for( i=0; i<64; i++ ) {
-        int rank = RankOfSquare(i);
-        int file = FileOfSquare(i);
-        int dpos = 0;
-        int dlen = 0;
+        RookOnRank[i] = slidingAttacks( i, 0, RankDeltas );
+        RookOnFile[i] = slidingAttacks( i, 0, FileDeltas );
+        BishopOnA1H8[i] = slidingAttacks( i, 0, DiagA1H8Deltas );
+        BishopOnA8H1[i] = slidingAttacks( i, 0, DiagA8H1Deltas );
 
-        // Compute position within diagonal
-        while( isValidSquare( rank+dpos, file-dpos ) ) dpos++;
-        dpos--;
-
-        // Move to beginning of diagonal
-        rank += dpos;
-        file -= dpos;
-
-        // Compute diagonal length
-        while( isValidSquare( rank-dlen, file+dlen ) ) dlen++;
-
-        for( int r=0; r<256; r++ ) {
-            BishopA8H1[i][r].clear();
-
-            for( j = dpos-1; j >= 0; j-- ) {
-                setBitByFileRank( BishopA8H1[i][r], file+j, rank-j );
-                if( r & (1 << j) ) break;
-            }
-            for( j = dpos+1; j < dlen; j++ ) {
-                setBitByFileRank( BishopA8H1[i][r], file+j, rank-j );
-                if( r & (1 << j) ) break;
-            }
-        }
+        Rook[i] = RookOnRank[i] | RookOnFile[i];
+        Bishop[i] = BishopOnA1H8[i] | BishopOnA8H1[i];
     }
 
-    // Rook and bishop (regardless of interposing pieces)
-    for( i=0; i<64; i++ ) {
-        Rook[i] = RookFile[i][0] | RookRank[i][0];
-        Bishop[i] = BishopA1H8[i][0] | BishopA8H1[i][0];
-    }
+    // Sliding attacks (rooks first, then bishops in the same table)
+    initializeMagics( RookMagic, SlidingAttacks, RookDeltas );
+    initializeMagics( BishopMagic, SlidingAttacks + 0x19000, BishopDeltas );
 
     // Pawns that can attack a square, possibly by advancing first
     for( i=0; i<64; i++ ) {
@@ -20,6 +20,14 @@
 #ifndef ATTACKS_H_
 #define ATTACKS_H_
 
+// Define USE_PEXT (and compile with -mbmi2) to index sliding attacks with the
+// BMI2 "pext" instruction instead of magic multiplication
+// #define USE_PEXT
+
+#ifdef USE_PEXT
+#include <immintrin.h>
+#endif
+
 #include "bitboard.h"
 
 enum {
@@ -42,18 +50,40 @@ enum {
     DirA8H1_H1,         // On A8-H1 diagonal, closer to H1
 };
 
+/*
+    Sliding attacks are computed with "magic" bitboards: the occupied squares that
+    can block a piece (mask) are mapped to an index into a table of attacks, either
+    by multiplying them with a magic number or (with USE_PEXT) by extracting them
+    with the pext instruction. Magic numbers are searched for at startup.
+*/
+struct Magic
+{
+    Uint64      mask;       // Squares that can block the piece (edges excluded)
+    Uint64      magic;
+    BitBoard *  attacks;    // Attacks for each index
+    unsigned    shift;
+
+    unsigned index( Uint64 occupied ) const {
+#ifdef USE_PEXT
+        return (unsigned) _pext_u64( occupied, mask );
+#else
+        return (unsigned) (((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
 struct Attacks
 {
     static BitBoard     BlackPawn[64];
     static BitBoard     WhitePawn[64];
-    static BitBoard     BishopA1H8[64][256];
-    static BitBoard     BishopA8H1[64][256];
     static BitBoard     King[64];
     static BitBoard     Knight[64];
-    static BitBoard     RookRank[64][256];
-    static BitBoard     RookFile[64][256];
     static BitBoard     Rook[64];
     static BitBoard     Bishop[64];
+    static BitBoard     RookOnRank[64];     // Rook and bishop attacks on each line (regardless of interposing pieces)
+    static BitBoard     RookOnFile[64];
+    static BitBoard     BishopOnA1H8[64];
+    static BitBoard     BishopOnA8H1[64];
     static BitBoard     BlackPawnCouldAttack[64];
     static BitBoard     WhitePawnCouldAttack[64];
     static BitBoard     SquaresBetween[64][64];
@@ -66,6 +96,22 @@ struct Attacks
     static char         Direction[64][64];
     static char         DirectionEx[64][64];    // Extended info
     
+    static Magic        RookMagic[64];
+    static Magic        BishopMagic[64];
+
+    // Sliding attacks from the specified square, with the specified occupied squares
+    static BitBoard getRookAttacks( int square, const BitBoard & occupied ) {
+        const Magic & m = RookMagic[square];
+
+        return m.attacks[ m.index( occupied.data ) ];
+    }
+
+    static BitBoard getBishopAttacks( int square, const BitBoard & occupied ) {
+        const Magic & m = BishopMagic[square];
+
+        return m.attacks[ m.index( occupied.data ) ];
+    }
+
     // Initialization
     static void     initialize();
 
@@ -75,6 +121,12 @@ struct Attacks
 
 private:
     static void     setSquareBetweenBit( int src, int dst, int file, int rank );
+
+    static BitBoard slidingAttacks( int square, Uint64 occupied, const int (* deltas)[2] );
+
+    static void     initializeMagics( Magic * magics, BitBoard * table, const int (* deltas)[2] );
+
+    static BitBoard SlidingAttacks[ 0x19000 + 0x1480 ];     // Rook and bishop attacks (see Magic)
 };
 
 #endif // ATTACKS_H_
@@ -171,6 +171,36 @@ const BitBoard BitBoard::Clr[64] =
    ~(((Uint64)1) << 63)
 };
 
+bool cpuHasPopCount = false;
+
+void BitBoard::initialize( bool useCpuFeatures )
+{
+    cpuHasPopCount = false;
+
+#if defined(CPU_X86_64)
+    if( useCpuFeatures ) {
+#if defined(_MSC_VER)
+        int info[4];
+
+        __cpuid( info, 1 );
+
+        cpuHasPopCount = ((info[2] >> 23) & 1) != 0;
+#else
+        cpuHasPopCount = __builtin_cpu_supports( "popcnt" ) != 0;
+#endif
+    }
+
+#if defined(__POPCNT__)
+    Log::write( "Bit count: POPCNT (compiled in)\n" );
+#else
+    Log::write( "Bit count: %s\n", cpuHasPopCount ? "POPCNT" : "portable 64-bit" );
+#endif
+    Log::write( "Bit search: TZCNT/BSF\n" );
+#else
+    Log::write( "Bit count and search: portable 32-bit\n" );
+#endif
+}
+
 void BitBoard::dump( const char * header ) const
 {
     FILE * f = Log::file();
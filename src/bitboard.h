@@ -27,13 +27,47 @@
 #include <stdio.h>
 #include "platform.h"
 
+#if defined(CPU_X86_64) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 extern CACHE_ALIGN const unsigned int lsz64_tbl[64];
 
+// True if the processor has the POPCNT instruction (set by BitBoard::initialize)
+extern bool cpuHasPopCount;
+
 /*
     Bit count function by Gerd Isenberg.
+
+    On x86-64 the POPCNT instruction is used if the processor supports it
+    (or unconditionally if the compiler is allowed to use it, e.g. with -mpopcnt),
+    otherwise bits are counted in parallel on the whole 64-bit word.
 */
 inline int bitCount( Uint64 bb )
 {
+#if defined(CPU_X86_64)
+#if defined(__POPCNT__)
+    return __builtin_popcountll( bb );
+#else
+    if( cpuHasPopCount ) {
+#if defined(_MSC_VER)
+        return (int) __popcnt64( bb );
+#else
+        Uint64 result;
+
+        __asm__( "popcntq %1, %0" : "=r" (result) : "rm" (bb) );
+
+        return (int) result;
+#endif
+    }
+
+    bb = bb - ((bb >> 1) & MK_U64(0x5555555555555555));
+    bb = (bb & MK_U64(0x3333333333333333)) + ((bb >> 2) & MK_U64(0x3333333333333333));
+    bb = (bb + (bb >> 4)) & MK_U64(0x0F0F0F0F0F0F0F0F);
+
+    return (int) ((bb * MK_U64(0x0101010101010101)) >> 56);
+#endif
+#else
    unsigned w = (unsigned) (bb >> 32);
    unsigned v = (unsigned) bb;
 
@@ -46,6 +80,7 @@ inline int bitCount( Uint64 bb )
    v = ((v+w) * 0x01010101) >> 24;
 
    return v;
+#endif
 }
 
 /**
@@ -219,13 +254,48 @@ public:
 
     int bitScanForward() const;
 
+    // Detects the processor features used by the bit functions (if allowed)
+    static void initialize( bool useCpuFeatures = true );
+
 public:
     Uint64  data;
 };
 
 /*
     Bit search functions by Gerd Isenberg.
+
+    On x86-64 the index of the lowest bit is found with a single instruction:
+    the encoding used for TZCNT runs as BSF on processors that lack it, and both
+    return the same result for non-empty bitboards, so no check is needed.
+    Resetting the lowest bit compiles to BLSR when the compiler is allowed
+    to use BMI1 (e.g. with -mbmi).
 */
+#if defined(CPU_X86_64)
+
+inline unsigned int bitSearch( BitBoard bb )
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+
+    _BitScanForward64( &index, bb.data );
+
+    return index;
+#else
+    return (unsigned int) __builtin_ctzll( bb.data );
+#endif
+}
+
+inline unsigned int bitSearchAndReset( BitBoard & bb )
+{
+    unsigned int result = bitSearch( bb );
+
+    bb.data &= bb.data - 1;
+
+    return result;
+}
+
+#else
+
 inline unsigned int bitSearch( BitBoard bb )
 {
    Uint64 b = bb.data ^ (bb.data - 1);
@@ -241,6 +311,8 @@ inline unsigned int bitSearchAndReset( BitBoard & bb )
     return lsz64_tbl[(fold * 0x78291ACF) >> (32-6)];
 }
 
+#endif
+
 inline int bitScanForward( BitBoard bb )
 {
     return bb.data != 0 ? bitSearch(bb) : -1;
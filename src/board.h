@@ -24,16 +24,6 @@
 
 #include "bitboard.h"
 
-extern BitBoard SetTA1H8[64];
-extern BitBoard SetDA1H8[64];
-extern BitBoard SetDA8H1[64];
-
-extern int boardTA1H8[64];
-extern int boardDA1H8[64];
-extern int shiftDA1H8[64];
-extern int boardDA8H1[64];
-extern int shiftDA8H1[64];
-
 enum Side
 {
     Black = 0,
@@ -114,9 +104,6 @@ struct Board
     static char * getSquareName( char * name, int square );
 
     static const char * squareName( int square );
-
-    // Initialization
-	static void initialize();
 };
 
 #endif // BOARD_H_
@@ -38,9 +38,11 @@ enum {
     cmd_Result,
     cmd_SetBoard,
     cmd_SetClock,
+    cmd_SetCores,
     cmd_SetFixedDepth,
     cmd_SetFixedTime,
     cmd_SetLevel,
+    cmd_SetMemory,
     cmd_SetOpponentClock,
     cmd_SetOpponentIsComputer,
     cmd_SetPonderingOff,
@@ -55,14 +57,20 @@ enum {
 
     // Kiwi extensions
     cmd_KiwiAddToBookTree,
+    cmd_KiwiBenchmark,
     cmd_KiwiBestMove,
     cmd_KiwiEvaluateSuite,
     cmd_KiwiExportBookTree,
     cmd_KiwiGenBB,
+    cmd_KiwiHashTest,
     cmd_KiwiLoadBook,
+    cmd_KiwiLoadHashTable,
     cmd_KiwiHelp,
     cmd_KiwiPerft,
+    cmd_KiwiPerftDivide,
+    cmd_KiwiPerftSuite,
     cmd_KiwiRunSuite,
+    cmd_KiwiSaveHashTable,
     cmd_KiwiSetOption,
     cmd_KiwiTest,
     cmd_KiwiAnalyze,
@@ -20,50 +20,80 @@
 #include "counters.h"
 #include "log.h"
 
-unsigned Counters::callsToGenMoves      = 0;
-unsigned Counters::callsToSideInCheck   = 0;
-unsigned Counters::callsToEvaluation    = 0;
-
-unsigned Counters::posGenerated         = 0;
-unsigned Counters::posInvalid           = 0;
-unsigned Counters::posSearched          = 0;
-
-unsigned Counters::pawnHashProbes       = 0;
-unsigned Counters::pawnHashProbesFailed = 0;
-unsigned Counters::pawnHashStores       = 0;
-
-unsigned Counters::hashStores           = 0;
-unsigned Counters::hashProbes           = 0;
-unsigned Counters::hashProbesFailed     = 0;
-
-unsigned Counters::firstFailedHigh      = 0;
-unsigned Counters::secondFailedHigh     = 0;
-unsigned Counters::anyFailedHigh        = 0;
-
-unsigned Counters::nullMoveAttempts     = 0;
-unsigned Counters::nullMoveCutOffs      = 0;
-
-unsigned Counters::miscCounter1 = 0;
-unsigned Counters::miscCounter2 = 0;
+THREAD_LOCAL unsigned Counters::callsToGenMoves      = 0;
+THREAD_LOCAL unsigned Counters::callsToSideInCheck   = 0;
+THREAD_LOCAL unsigned Counters::callsToEvaluation    = 0;
+THREAD_LOCAL unsigned Counters::evalLazyProbes       = 0;
+THREAD_LOCAL unsigned Counters::evalLazyCuts         = 0;
+
+THREAD_LOCAL unsigned Counters::posGenerated         = 0;
+THREAD_LOCAL unsigned Counters::posInvalid           = 0;
+THREAD_LOCAL unsigned Counters::posSearched          = 0;
+THREAD_LOCAL unsigned Counters::quiesceNodes         = 0;
+
+THREAD_LOCAL unsigned Counters::movesStaged          = 0;
+THREAD_LOCAL unsigned Counters::movesStagedQuiet     = 0;
+
+THREAD_LOCAL unsigned Counters::pawnHashProbes       = 0;
+THREAD_LOCAL unsigned Counters::pawnHashProbesFailed = 0;
+THREAD_LOCAL unsigned Counters::pawnHashStores       = 0;
+THREAD_LOCAL unsigned Counters::evalCacheProbes      = 0;
+THREAD_LOCAL unsigned Counters::evalCacheProbesFailed = 0;
+
+THREAD_LOCAL unsigned Counters::hashStores           = 0;
+THREAD_LOCAL unsigned Counters::hashStoresSamePosition = 0;
+THREAD_LOCAL unsigned Counters::hashStoresEmpty      = 0;
+THREAD_LOCAL unsigned Counters::hashStoresOlderSearch = 0;
+THREAD_LOCAL unsigned Counters::hashStoresLessDeep   = 0;
+THREAD_LOCAL unsigned Counters::hashProbes           = 0;
+THREAD_LOCAL unsigned Counters::hashProbesFailed     = 0;
+
+THREAD_LOCAL unsigned Counters::quiesceHashProbes    = 0;
+THREAD_LOCAL unsigned Counters::quiesceHashProbesFailed = 0;
+
+THREAD_LOCAL unsigned Counters::firstFailedHigh      = 0;
+THREAD_LOCAL unsigned Counters::secondFailedHigh     = 0;
+THREAD_LOCAL unsigned Counters::anyFailedHigh        = 0;
+
+THREAD_LOCAL unsigned Counters::nullMoveAttempts     = 0;
+THREAD_LOCAL unsigned Counters::nullMoveCutOffs      = 0;
+
+THREAD_LOCAL unsigned Counters::miscCounter1 = 0;
+THREAD_LOCAL unsigned Counters::miscCounter2 = 0;
 
 void Counters::reset()
 {
     callsToGenMoves      = 0;
     callsToSideInCheck   = 0;
     callsToEvaluation    = 0;
+    evalLazyProbes       = 0;
+    evalLazyCuts         = 0;
 
     posGenerated         = 0;
     posInvalid           = 0;
     posSearched          = 0;
+    quiesceNodes         = 0;
+
+    movesStaged          = 0;
+    movesStagedQuiet     = 0;
     
     pawnHashProbes       = 0;
     pawnHashProbesFailed = 0;
     pawnHashStores       = 0;
+    evalCacheProbes      = 0;
+    evalCacheProbesFailed = 0;
 
     hashStores           = 0;
+    hashStoresSamePosition = 0;
+    hashStoresEmpty      = 0;
+    hashStoresOlderSearch = 0;
+    hashStoresLessDeep   = 0;
     hashProbes           = 0;
     hashProbesFailed     = 0;
 
+    quiesceHashProbes    = 0;
+    quiesceHashProbesFailed = 0;
+
     firstFailedHigh      = 0;
     secondFailedHigh     = 0;
     anyFailedHigh        = 0;
@@ -82,6 +112,12 @@ void Counters::dump()
     fprintf( f, "Calls to SideInCheck   : %u\n", callsToSideInCheck );
     fprintf( f, "Calls to Evaluation    : %u\n", callsToEvaluation );
 
+    if( evalLazyProbes > 0 ) {
+        double f1 = (evalLazyCuts * 100.0) / evalLazyProbes;
+
+        fprintf( f, "Lazy evaluation cuts   : %u / %u (%05.2f%%)\n", evalLazyCuts, evalLazyProbes, f1 );
+    }
+
     if( nullMoveAttempts > 0 ) {
         double f1 = (nullMoveCutOffs * 100.0) / nullMoveAttempts;
 
@@ -91,10 +127,26 @@ void Counters::dump()
     fprintf( f, "Positions generated    : %u\n", posGenerated );
     fprintf( f, "Invalid moves generated: %u\n", posInvalid );
     fprintf( f, "Positions searched     : %u\n", posSearched );
+    fprintf( f, "Quiescence nodes       : %u\n", quiesceNodes );
+
+    if( movesStaged > 0 ) {
+        double f1 = ((movesStaged - movesStagedQuiet) * 100.0) / movesStaged;
+
+        fprintf( f, "Quiet moves not needed : %u / %u (%05.2f%%)\n", movesStaged - movesStagedQuiet, movesStaged, f1 );
+    }
+
     fprintf( f, "Hash probes failed     : %u / %u\n", hashProbesFailed, hashProbes );
+    fprintf( f, "Hash stores            : %u (same %u, empty %u, older %u, less deep %u)\n", hashStores, hashStoresSamePosition, hashStoresEmpty, hashStoresOlderSearch, hashStoresLessDeep );
+    fprintf( f, "QS hash probes failed  : %u / %u\n", quiesceHashProbesFailed, quiesceHashProbes );
     fprintf( f, "Pawn hash probes failed: %u / %u\n", pawnHashProbesFailed, pawnHashProbes );
     fprintf( f, "Pawn hash stores       : %u\n", pawnHashStores );
 
+    if( evalCacheProbes > 0 ) {
+        double f1 = ((evalCacheProbes - evalCacheProbesFailed) * 100.0) / evalCacheProbes;
+
+        fprintf( f, "Eval cache hits        : %u / %u (%05.2f%%)\n", evalCacheProbes - evalCacheProbesFailed, evalCacheProbes, f1 );
+    }
+
     if( anyFailedHigh > 0 ) {
         double f1 = (firstFailedHigh * 100.0) / anyFailedHigh;
         double f2 = (secondFailedHigh * 100.0) / anyFailedHigh;
@@ -22,33 +22,54 @@
 
 #include <stdio.h>
 
+#include "platform.h"
+
+/*
+    Note: counters are kept separately by each search thread.
+*/
 struct Counters
 {
-    static unsigned callsToGenMoves;
-    static unsigned callsToSideInCheck;
-    static unsigned callsToEvaluation;
+    static THREAD_LOCAL unsigned callsToGenMoves;
+    static THREAD_LOCAL unsigned callsToSideInCheck;
+    static THREAD_LOCAL unsigned callsToEvaluation;
+    static THREAD_LOCAL unsigned evalLazyProbes;        // Evaluations with a window (see Position::getEvaluation())
+    static THREAD_LOCAL unsigned evalLazyCuts;          // ...that returned a bound without a full evaluation
+
+    static THREAD_LOCAL unsigned nullMoveAttempts;
+    static THREAD_LOCAL unsigned nullMoveCutOffs;
+
+    static THREAD_LOCAL unsigned posGenerated;
+    static THREAD_LOCAL unsigned posInvalid;
+    static THREAD_LOCAL unsigned posSearched;
+    static THREAD_LOCAL unsigned quiesceNodes;
+
+    static THREAD_LOCAL unsigned movesStaged;           // Search nodes with staged move generation
+    static THREAD_LOCAL unsigned movesStagedQuiet;      // ...of which generated the non-tactical moves
 
-    static unsigned nullMoveAttempts;
-    static unsigned nullMoveCutOffs;
+    static THREAD_LOCAL unsigned firstFailedHigh;
+    static THREAD_LOCAL unsigned secondFailedHigh;
+    static THREAD_LOCAL unsigned anyFailedHigh;
 
-    static unsigned posGenerated;
-    static unsigned posInvalid;
-    static unsigned posSearched;
+    static THREAD_LOCAL unsigned pawnHashProbes;
+    static THREAD_LOCAL unsigned pawnHashProbesFailed;
+    static THREAD_LOCAL unsigned pawnHashStores;
 
-    static unsigned firstFailedHigh;
-    static unsigned secondFailedHigh;
-    static unsigned anyFailedHigh;
+    static THREAD_LOCAL unsigned evalCacheProbes;
+    static THREAD_LOCAL unsigned evalCacheProbesFailed;
 
-    static unsigned pawnHashProbes;
-    static unsigned pawnHashProbesFailed;
-    static unsigned pawnHashStores;
+    static THREAD_LOCAL unsigned hashStores;
+    static THREAD_LOCAL unsigned hashStoresSamePosition;    // Replacement rules used by HashTable::store()
+    static THREAD_LOCAL unsigned hashStoresEmpty;
+    static THREAD_LOCAL unsigned hashStoresOlderSearch;
+    static THREAD_LOCAL unsigned hashStoresLessDeep;
+    static THREAD_LOCAL unsigned hashProbes;
+    static THREAD_LOCAL unsigned hashProbesFailed;
 
-    static unsigned hashStores;
-    static unsigned hashProbes;
-    static unsigned hashProbesFailed;
+    static THREAD_LOCAL unsigned quiesceHashProbes;
+    static THREAD_LOCAL unsigned quiesceHashProbesFailed;
 
-    static unsigned miscCounter1;
-    static unsigned miscCounter2;
+    static THREAD_LOCAL unsigned miscCounter1;
+    static THREAD_LOCAL unsigned miscCounter2;
 
     static void reset();
 
@@ -28,6 +28,7 @@
 #include "board.h"
 #include "log.h"
 #include "mask.h"
+#include "material.h"
 #include "pgn.h"
 #include "pgn_lex.h"
 #include "recognizer.h"
@@ -37,6 +38,7 @@
 #include "zobrist.h"
 
 void testRecognizers(); // Defined in recognizer_test
+void testHashTable( int numOfThreads ); // Defined in hash_test.cxx
 
 #ifndef EOF_AS_INPUT
 #error Alessandro, remember to define EOF_AS_INPUT!
@@ -71,8 +73,19 @@ int Engine::extendPawnEndgame       = 2*FullPlyDepth; // From 0.6a... not tested
 int Engine::pruneMarginAtFrontier       = 200;
 int Engine::pruneMarginAtPreFrontier    = 500;
 
-int Engine::sizeOfHashTable             = 64 * 1024 * 1024; // Number of entries (must be a power of two)
-int Engine::sizeOfPawnHashTable         =  2 * 1024 * 1024; // Number of entries
+int Engine::numOfSearchThreads          = 1;
+int Engine::mtdProbeSpread              = 0;
+
+Uint64 Engine::sizeOfHashTable          = 64 * 1024 * 1024; // Size in bytes (must be a power of two)
+Uint64 Engine::sizeOfPawnHashTable      =  2 * 1024 * 1024; // Size in bytes
+Uint64 Engine::sizeOfEvalCache          =  2 * 1024 * 1024; // Size in bytes
+Uint64 Engine::sizeOfPerftHashTable     = 64 * 1024 * 1024; // Size in bytes
+Uint64 Engine::memoryBudget             = 0;
+int Engine::hashClearThreads            = 0;
+int Engine::lazyHashClear               = 0;
+
+int Engine::useCpuFeatures              = 1;
+int Engine::useCopyMake                 = 0;
 
 int Engine::scoreMarginAt1stCheck   =   0;  // At  50% time, score margin can be negative here!
 int Engine::scoreMarginAt2ndCheck   =  25;  // At 100% time
@@ -85,7 +98,11 @@ int Engine::resignThreshold         = -700;
 
 //
 HashTable *     Engine::hashTable       = 0;
-PawnHashTable * Engine::pawnHashTable   = 0;
+bool            Engine::hashTableRestored = false;
+THREAD_LOCAL PawnHashTable * Engine::pawnHashTable = 0;
+THREAD_LOCAL EvalCache * Engine::evalCache = 0;
+THREAD_LOCAL QuiesceHashTable * Engine::quiesceHashTable = 0;
+THREAD_LOCAL Position * Engine::positionStack = 0;
 
 unsigned    Engine::fixedSearchDepth;
 int         Engine::searchMode;
@@ -100,7 +117,7 @@ int         Engine::movesUntilTimeCheck;
 
 int         Engine::state;
 
-Engine::Rep3Info    Engine::rep3History[ MaxMovesPerGame + MaxSearchPly ];
+THREAD_LOCAL Engine::Rep3Info Engine::rep3History[ MaxMovesPerGame + MaxSearchPly ];
 MoveInfo            Engine::moveHistory[ MaxMovesPerGame ];
 Position            Engine::gameHistory[ MaxMovesPerGame + MaxSearchPly ];
 int                 Engine::gameHistoryIdx;
@@ -124,6 +141,7 @@ bool            Engine::opponentIsComputer = false;
 
 volatile bool   Engine::searchMustBeInterrupted;
 unsigned        Engine::searchStartTime;
+THREAD_LOCAL int Engine::searchThreadId = 0;
 Adapter *       Engine::interfaceAdapter = 0;
 bool            Engine::showThinking;
 unsigned        Engine::showThinkingLastUpdate = 0;
@@ -143,6 +161,8 @@ struct OptionInfo
 
 const char *    HashSizeOption      = "ttable.size";
 const char *    PawnHashSizeOption  = "pawntable.size";
+const char *    EvalCacheSizeOption = "evalcache.size";
+const char *    PerftHashSizeOption = "perft.hashsize";
 
 static bool handleIntegerOption( const char * name, const char * value, void * extra )
 {
@@ -178,12 +198,31 @@ static bool handleIntegerOption( const char * name, const char * value, void * e
     return result;
 }
 
+static bool handleSearchThreads( const char * name, const char * value, void * extra )
+{
+    bool result = handleIntegerOption( name, value, &Engine::numOfSearchThreads );
+
+    if( Engine::numOfSearchThreads < 1 ) {
+        Engine::numOfSearchThreads = 1;
+    }
+    else if( Engine::numOfSearchThreads > Engine::MaxSearchThreads ) {
+        printf( "*** Warning: maximum number of threads is %d\n", Engine::MaxSearchThreads );
+        Engine::numOfSearchThreads = Engine::MaxSearchThreads;
+    }
+
+    return result;
+}
+
+/*
+    Sizes are in bytes, or in megabytes/gigabytes with the "M"/"G" suffix, and are 64-bit:
+    for example "set ttable.size 32G" gives the main hash table 32G / 16 = 2G entries.
+*/
 static bool handleSizeInMegabytes( const char * name, const char * value, void * extra )
 {
     bool result = false;
 
     if( isdigit(*value) ) {
-        int n = 0;
+        Uint64 n = 0;
 
         while( isdigit(*value) ) {
             n = n*10 + *value - '0';
@@ -192,7 +231,12 @@ static bool handleSizeInMegabytes( const char * name, const char * value, void *
 
         if( *value == 'm' || *value == 'M' ) {
             // Value is specified in megabytes
-            n *= 1024*1024;
+            n <<= 20;
+            value++;
+        }
+        else if( *value == 'g' || *value == 'G' ) {
+            // Value is specified in gigabytes
+            n <<= 30;
             value++;
         }
 
@@ -212,6 +256,17 @@ static bool handleSizeInMegabytes( const char * name, const char * value, void *
                 else if( strcmp(name,PawnHashSizeOption) == 0 ) {
                     Engine::sizeOfPawnHashTable = n;
                 }
+                else if( strcmp(name,EvalCacheSizeOption) == 0 ) {
+                    Engine::sizeOfEvalCache = n;
+                }
+                else if( strcmp(name,PerftHashSizeOption) == 0 ) {
+                    // Not part of the memory budget
+                    Engine::sizeOfPerftHashTable = n;
+                    return true;
+                }
+
+                // Explicit sizes take precedence over the "memory" command
+                Engine::memoryBudget = 0;
 
                 result = true;
             }
@@ -233,8 +288,21 @@ OptionInfo optionInfo[] = {
 
     HashSizeOption,         handleSizeInMegabytes,  0,
     PawnHashSizeOption,     handleSizeInMegabytes,  0,
+    EvalCacheSizeOption,    handleSizeInMegabytes,  0,
+    PerftHashSizeOption,    handleSizeInMegabytes,  0,
+    "ttable.clearthreads",  handleIntegerOption,    &Engine::hashClearThreads,
+    "ttable.lazyclear",     handleIntegerOption,    &Engine::lazyHashClear,
+
+    "cpu.features",         handleIntegerOption,    &Engine::useCpuFeatures,
+
+    "movegen.legal",        handleIntegerOption,    &Position::useLegalMoveGenerator,
+
+    "eval.lazymargin",      handleIntegerOption,    &Position::lazyEvalMargin,
 
+    "search.copymake",      handleIntegerOption,    &Engine::useCopyMake,
     "search.maxfactor",     handleIntegerOption,    &Engine::maxSearchDepthFactor,
+    "search.threads",       handleSearchThreads,    0,
+    "search.mtdprobes",     handleIntegerOption,    &Engine::mtdProbeSpread,
 
     "prune.frontier",       handleIntegerOption,    &Engine::pruneMarginAtFrontier,
     "prune.pre-frontier",   handleIntegerOption,    &Engine::pruneMarginAtPreFrontier,
@@ -287,22 +355,95 @@ int Engine::handleSetOptionCommand( const char * key, const char * value )
     // Reinitialize all the stuff that was cached and that may depend on
     // the parameter that was modified
     if( result == 0 ) {
+        BitBoard::initialize( useCpuFeatures != 0 );
         Score::initialize();
+        Material::initialize();
 
-        if( sizeOfHashTable != (int) hashTable->getSize() ) {
-            delete hashTable;
-            hashTable = new HashTable( sizeOfHashTable / sizeof(HashTable::Entry) );
-        }
+        Uint64 size = hashTable->getSize();
+
+        updateTableSizes();
 
-        if( sizeOfPawnHashTable != (int) pawnHashTable->getSize() ) {
-            delete pawnHashTable;
-            pawnHashTable = new PawnHashTable( sizeOfPawnHashTable / sizeof(HashTable::Entry) );
+        if( size != hashTable->getSize() ) {
+            printf( "Hash table size: %uM (%uK entries)\n", (unsigned) (sizeOfHashTable >> 20), (unsigned) (hashTable->getSize() >> 10) );
         }
+
+        // Cached evaluations may be stale now
+        clearEvalTables();
     }
 
     return result;
 }
 
+static Uint64 roundDownToPowerOfTwo( Uint64 n )
+{
+    while( (n & (n-1)) != 0 ) {
+        n &= n-1;
+    }
+
+    return n;
+}
+
+unsigned Engine::getPawnHashTableEntries()
+{
+    return (unsigned) roundDownToPowerOfTwo( sizeOfPawnHashTable / sizeof(PawnHashEntry) );
+}
+
+unsigned Engine::getEvalCacheEntries()
+{
+    return (unsigned) roundDownToPowerOfTwo( sizeOfEvalCache / sizeof(Uint64) );
+}
+
+/*
+    Brings the size of all tables in line with the current settings. The main table
+    keeps its entries, the others are simply reallocated.
+
+    Note: tables cannot change while searching, so this is called before each search.
+*/
+void Engine::updateTableSizes()
+{
+    if( memoryBudget != 0 ) {
+        // The eval caches and the pawn tables (one of each per thread) get 1/32 of the budget each,
+        // the main table gets what's left (all sizes are powers of two)
+        Uint64 part = roundDownToPowerOfTwo( memoryBudget / 32 );
+
+        sizeOfEvalCache = roundDownToPowerOfTwo( part / numOfSearchThreads );
+
+        if( sizeOfEvalCache < 256*1024 ) {
+            sizeOfEvalCache = 256*1024;
+        }
+
+        sizeOfPawnHashTable = roundDownToPowerOfTwo( part / numOfSearchThreads );
+
+        if( sizeOfPawnHashTable < 256*1024 ) {
+            sizeOfPawnHashTable = 256*1024;
+        }
+
+        Uint64 used = (sizeOfEvalCache + sizeOfPawnHashTable)*numOfSearchThreads;
+
+        sizeOfHashTable = memoryBudget > used ? roundDownToPowerOfTwo( memoryBudget - used ) : 0;
+
+        if( sizeOfHashTable < 1024*1024 ) {
+            sizeOfHashTable = 1024*1024;
+        }
+    }
+
+    if( sizeOfHashTable != hashTable->getSize() * sizeof(HashTable::Entry) ) {
+        if( ! hashTable->resize( sizeOfHashTable / sizeof(HashTable::Entry) ) ) {
+            sizeOfHashTable = hashTable->getSize() * sizeof(HashTable::Entry);
+        }
+    }
+
+    if( getPawnHashTableEntries() != pawnHashTable->getSize() ) {
+        delete pawnHashTable;
+        pawnHashTable = new PawnHashTable( getPawnHashTableEntries() );
+    }
+
+    if( getEvalCacheEntries() != evalCache->getSize() ) {
+        delete evalCache;
+        evalCache = new EvalCache( getEvalCacheEntries() );
+    }
+}
+
 void Engine::initialize()
 {
     Log::write( "%s starting...\n\n", myName );
@@ -378,11 +519,12 @@ void Engine::initialize()
     }
 
     // Initialize bitboards and other stuff
+    BitBoard::initialize( useCpuFeatures != 0 );
     Attacks::initialize();
-	Board::initialize();
     Mask::initialize();
     Score::initialize();
     Zobrist::initialize();
+    Material::initialize();
     Recognizer::initialize();
 
     // Dump some configuration data into the configuration file
@@ -400,13 +542,26 @@ void Engine::initialize()
     LOG(( "pruneAtFrontier        = %d\n", pruneMarginAtFrontier ));
     LOG(( "pruneAtPreFrontier     = %d\n", pruneMarginAtPreFrontier ));
     LOG(( "safetyTimePerMove      = %d\n", safetyTimePerMove ));
-    LOG(( "sizeOfHashTable        = %dM\n", sizeOfHashTable / (1024*1024) ));
-    LOG(( "sizeOfPawnHashTable    = %dM\n", sizeOfPawnHashTable / (1024*1024) ));
+    LOG(( "numOfSearchThreads     = %d (%d processors)\n", numOfSearchThreads, System::getNumberOfProcessors() ));
+    LOG(( "mtdProbeSpread         = %d\n", mtdProbeSpread ));
+    LOG(( "sizeOfHashTable        = %uM (%uK entries)\n", (unsigned) (sizeOfHashTable >> 20), (unsigned) ((sizeOfHashTable / sizeof(HashTable::Entry)) >> 10) ));
+    LOG(( "sizeOfPawnHashTable    = %uM\n", (unsigned) (sizeOfPawnHashTable >> 20) ));
+    LOG(( "sizeOfEvalCache        = %uK\n", (unsigned) (sizeOfEvalCache >> 10) ));
+    LOG(( "sizeOfPerftHashTable   = %uM\n", (unsigned) (sizeOfPerftHashTable >> 20) ));
+    LOG(( "hashClearThreads       = %d\n", hashClearThreads ));
+    LOG(( "lazyHashClear          = %d\n", lazyHashClear ));
+    LOG(( "useCpuFeatures         = %d\n", useCpuFeatures ));
+    LOG(( "useLegalMoveGenerator  = %d\n", Position::useLegalMoveGenerator ));
+    LOG(( "useCopyMake            = %d\n", useCopyMake ));
+    LOG(( "lazyEvalMargin         = %d\n", Position::lazyEvalMargin ));
     LOG(( "\n" ));
 
     // Initialize hash tables
     hashTable = new HashTable( sizeOfHashTable / sizeof(HashTable::Entry) );
-    pawnHashTable = new PawnHashTable( sizeOfPawnHashTable / sizeof(HashTable::Entry) );
+    pawnHashTable = new PawnHashTable( getPawnHashTableEntries() );
+    evalCache = new EvalCache( getEvalCacheEntries() );
+    quiesceHashTable = new QuiesceHashTable( QuiesceHashTableSize );
+    positionStack = new Position[ PositionStackSize ];
 
     // Load opening book
     openingBook = new Book;
@@ -427,6 +582,7 @@ void Engine::initialize()
 
 int Engine::updatePrincipalVariation( const Position & position, Move * pv, int pvofs, int pvlen  )
 {
+    HashTable::Entry    item;
     HashTable::Entry *  entry;
     Position            pos( position );
 
@@ -444,7 +600,7 @@ int Engine::updatePrincipalVariation( const Position & position, Move * pv, int
 
     // Try to get the rest of the PV from the hash table
     while( pvlen > 0 ) {
-        entry = hashTable->probe(pos);
+        entry = hashTable->probe( pos, item );
 
         if( entry == 0 )
             break;
@@ -505,6 +661,7 @@ void Engine::setMoveToPlay( Move move, int score, int depth, int maxdepth, int n
     gameMoveToPlay.depth = depth;
     gameMoveToPlay.maxdepth = maxdepth;
     gameMoveToPlay.nodes = nodes;
+    gameMoveToPlay.hashfull = hashTable->getHashFull();
     gameMoveToPlay.time = searchTime;
     gameMoveToPlay.pv[0] = move;
     gameMoveToPlay.pvlen = 1 + updatePrincipalVariation( gamePosition, gameMoveToPlay.pv, 1, MoveInfo::MaxMovesInPV-1 );
@@ -729,7 +886,7 @@ int Engine::handleInput()
             case cmd_DisplaySearchStatus:
                 if( state == state_Analyzing || state == state_Pondering || state == state_Thinking ) {
                     rootMoveStat.time = timeSpentInSearch();
-                    rootMoveStat.nodes = Counters::posSearched;
+                    rootMoveStat.nodes = getNodesSearched();
                     interfaceAdapter->showCurrentSearchMove( gamePosition, rootMoveStat );
                 }
                 break;
@@ -771,6 +928,7 @@ int Engine::handleInput()
                 break;
             // Prepare for new game
             case cmd_New:
+                joinHelperThreads();
                 resetBoard( 0 );
                 if( state != state_Analyzing && state != state_AnalysisComplete ) {
                     state = state_Waiting;
@@ -806,10 +964,21 @@ int Engine::handleInput()
                 break;
             // Set board to specified FEN position
             case cmd_SetBoard:
+                joinHelperThreads();
                 resetBoard( command.strParam(0) );
                 searchMustBeInterrupted = true;
                 yield = true;
                 break;
+            // Set memory for tables (megabytes), applied before the next search
+            case cmd_SetMemory:
+                memoryBudget = (Uint64) command.intParam(0) << 20;
+                break;
+            // Set number of search threads
+            case cmd_SetCores:
+                numOfSearchThreads = command.intParam(0);
+                if( numOfSearchThreads < 1 ) numOfSearchThreads = 1;
+                if( numOfSearchThreads > MaxSearchThreads ) numOfSearchThreads = MaxSearchThreads;
+                break;
             // Set clock
             case cmd_SetClock:
                 timeOnClock = command.intParam(0) * 10;
@@ -876,6 +1045,7 @@ int Engine::handleInput()
                 break;
             // Undo last full move (i.e. two half moves)
             case cmd_UndoLastFullMove:
+                joinHelperThreads();
                 if( hasPonderMoveOnBoard() ) {
                     // Undo the ponder move first
                     undoMove( 1 );
@@ -891,6 +1061,7 @@ int Engine::handleInput()
                     undoMove( 1 );
                 }
                 else if( state == state_Analyzing || state == state_AnalysisComplete ) {
+                    joinHelperThreads();
                     undoMove( 1 );
                     searchMustBeInterrupted = true;
                     state = state_Analyzing;
@@ -921,16 +1092,35 @@ int Engine::handleInput()
             case cmd_KiwiGenBB:
                 generateBitbases();
                 break;
+            // Search a few positions at fixed depth and report the speed
+            case cmd_KiwiBenchmark:
+                if( state == state_Observing ) {
+                    runBenchmark( command.intParamCount() > 0 ? command.intParam(0) : 0 );
+                }
+                else {
+                    printf( "*** Error: bench command received in state: %d\n", state );
+                }
+                break;
+            // Stress test the hash table with concurrent threads
+            case cmd_KiwiHashTest:
+                testHashTable( command.intParamCount() > 0 ? command.intParam(0) : 0 );
+                break;
             // Display help
             case cmd_KiwiHelp:
                 printf( "Welcome to %s by %s.\n\n", myName, myAuthor );
                 printf( "Please use the standard WinBoard/XBoard command set to talk with the engine,\n" );
                 printf( "or one of the following commands:\n\n" );
+                printf( "bench      [depth]\n" );
                 printf( "bookadd    [filename] [min moves per game] [max plies to consider]\n" );
                 printf( "bookload   [filename]\n" );
                 printf( "booksave   [filename] [min occurences of a book position]\n" );
+                printf( "hashtest   [threads]\n" );
+                printf( "divide     [depth]\n" );
                 printf( "perft      [depth]\n" );
+                printf( "perftsuite [filename] [max depth] [optional: output file, .json or .csv]\n" );
                 printf( "suite      [filename] [seconds per move] [optional: max depth]\n" );
+                printf( "ttload     [filename] (in force mode, before or after setting the position)\n" );
+                printf( "ttsave     [filename] (in force mode)\n" );
                 break;
             // Load book
             case cmd_KiwiLoadBook:
@@ -948,6 +1138,31 @@ int Engine::handleInput()
                     }
                 }
                 break;
+            // Load a hash table snapshot (kept until the next search, even if a new position is set)
+            case cmd_KiwiLoadHashTable:
+                if( state != state_Observing ) {
+                    printf( "*** Error: ttload command received in state: %d\n", state );
+                }
+                else if( hashTable->restore( command.strParam(0) ) == 0 ) {
+                    hashTableRestored = true;
+                    printf( "Hash table loaded successfully\n" );
+                }
+                else {
+                    printf( "Error: unable to load hash table.\n" );
+                }
+                break;
+            // Save a hash table snapshot
+            case cmd_KiwiSaveHashTable:
+                if( state != state_Observing ) {
+                    printf( "*** Error: ttsave command received in state: %d\n", state );
+                }
+                else if( hashTable->backup( command.strParam(0) ) == 0 ) {
+                    printf( "Hash table saved successfully\n" );
+                }
+                else {
+                    printf( "Error: unable to save hash table.\n" );
+                }
+                break;
             // Run perft() on current position
             case cmd_KiwiPerft:
                 {
@@ -958,11 +1173,32 @@ int Engine::handleInput()
                     perft( fen, command.intParam(0) );
                 }
                 break;
+            // Run perft() on current position, with the nodes below each move
+            case cmd_KiwiPerftDivide:
+                {
+                    char fen[200];
+
+                    gamePosition.getBoard( fen );
+
+                    perftDivide( fen, command.intParam(0) );
+                }
+                break;
+            // Run perft() on all positions of a suite
+            case cmd_KiwiPerftSuite:
+                perftRunSuite( command.strParam(0),
+                    command.intParam(0),
+                    command.strParamCount() > 1 ? command.strParam(1) : 0 );
+                break;
             // Run test suite
             case cmd_KiwiRunSuite:
-                runTestSuiteEPD( command.strParam(0), 
-                    command.intParam(0),
-                    command.intParamCount() > 1 ? command.intParam(1) : MaxSearchPly );
+                if( state == state_Observing ) {
+                    runTestSuiteEPD( command.strParam(0), 
+                        command.intParam(0),
+                        command.intParamCount() > 1 ? command.intParam(1) : MaxSearchPly );
+                }
+                else {
+                    printf( "*** Error: suite command received in state: %d\n", state );
+                }
                 break;
             // Set engine option
             case cmd_KiwiSetOption:
@@ -974,6 +1210,7 @@ int Engine::handleInput()
                 break;
             // Set position and analyze
             case cmd_KiwiAnalyze:
+                joinHelperThreads();
                 resetBoard( command.strParam(0) );
                 searchMustBeInterrupted = true;
                 yield = true;
@@ -1103,7 +1340,7 @@ int Engine::runTestSuiteEPD( const char * name, int secondsPerMove, int maxDepth
         }
 
         if( timeSpent > 0 ) {
-            Log::write( "NPS = %u K\n", Counters::posSearched / timeSpent );
+            Log::write( "NPS = %u K\n", getNodesSearched() / timeSpent );
         }
 
         printf( "%d/%d\n", solved, num );
@@ -1271,6 +1508,84 @@ int Engine::runEvalSuiteEPD( const char * name )
     return 0;
 }
 
+/*
+    Searches a few positions to a fixed depth and reports the overall speed.
+
+    Since the hash table is cleared before each position, the search tree is
+    the same on every run, which makes it easy to measure changes that only
+    affect speed (e.g. memory layout, prefetching).
+*/
+int Engine::runBenchmark( int depth )
+{
+    static const char * positions[] = {
+        Position::startPosition,
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+        "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ -",
+        "2r2rk1/1bqnbppp/p2ppn2/1p6/3NP3/1BN1BP2/PPPQ2PP/2KR3R w - -",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -",
+        "8/PPP4k/8/8/8/8/4Kppp/8 w - -",
+        0
+    };
+
+    if( depth <= 0 ) {
+        depth = 9;
+    }
+
+    printf( "bench: depth=%d\n", depth );
+
+    // Search without time limits and ignore input until done
+    int currentState = state;
+
+    state = state_Analyzing;
+
+    inputCheckWhileSearching = false;
+
+    unsigned totalNodes = 0;
+    unsigned totalTime = 0;
+
+    for( int i=0; positions[i] != 0; i++ ) {
+        resetBoard( positions[i] );
+
+        Counters::reset();
+
+        gameMoveToPlay.reset();
+
+        Position pos( gamePosition );
+
+        searchStartTime = System::getTickCount();
+        searchMustBeInterrupted = false;
+
+        searchPosition( pos, 0, depth );
+
+        unsigned t = System::getTickCount() - searchStartTime;
+        unsigned n = getNodesSearched();
+
+        // Note: the other counters are those of the main thread only
+        double hits = Counters::hashProbes > 0 ? ((Counters::hashProbes - Counters::hashProbesFailed) * 100.0) / Counters::hashProbes : 0;
+        double noquiet = Counters::movesStaged > 0 ? ((Counters::movesStaged - Counters::movesStagedQuiet) * 100.0) / Counters::movesStaged : 0;
+        double lazy = Counters::evalLazyProbes > 0 ? (Counters::evalLazyCuts * 100.0) / Counters::evalLazyProbes : 0;
+        double cached = Counters::evalCacheProbes > 0 ? ((Counters::evalCacheProbes - Counters::evalCacheProbesFailed) * 100.0) / Counters::evalCacheProbes : 0;
+
+        printf( "  position %d: nodes=%u, qnodes=%u, hash hits=%.1f%%, no quiet moves=%.1f%%, lazy eval=%.1f%%, eval cache=%.1f%%, time=%u.%03u\n", i+1, n, Counters::quiesceNodes, hits, noquiet, lazy, cached, t / 1000, t % 1000 );
+
+        totalNodes += n;
+        totalTime += t;
+    }
+
+    if( totalTime == 0 ) totalTime = 1;
+
+    printf( "bench complete: total=%u nodes in %u.%03u seconds (%u KNps)\n\n", totalNodes, totalTime / 1000, totalTime % 1000, totalNodes / totalTime );
+
+    Log::write( "Benchmark: depth=%d, nodes=%u, time=%u ms, KNps=%u\n", depth, totalNodes, totalTime, totalNodes / totalTime );
+
+    // Restore previous state
+    state = currentState;
+
+    inputCheckWhileSearching = true;
+
+    return 0;
+}
+
 int Engine::test()
 {
     /*
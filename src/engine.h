@@ -22,6 +22,7 @@
 
 #include "adapter.h"
 #include "book.h"
+#include "evalcache.h"
 #include "hash.h"
 #include "move.h"
 #include "movelist.h"
@@ -43,6 +44,7 @@ struct MoveInfo
     int         maxdepth;           // Max search depth (after extensions)
     unsigned    time;               // Time spent in search (hundredths of second)
     unsigned    nodes;              // Nodes searched
+    unsigned    hashfull;           // Hash table usage (permille)
     Move        pv[MaxMovesInPV];   // Principal variation
     int         pvlen;              // Length of principal variation
 
@@ -100,6 +102,15 @@ public:
         // Max ply reached during a search
         MaxSearchPly        = 63,
 
+        // Plies in the position stack used by copy-make (max search depth plus some buffer for quiesce nodes)
+        PositionStackSize   = 400 + MaxSearchPly,
+
+        // Max number of search threads (main thread included)
+        MaxSearchThreads    = 64,
+
+        // Entries in the quiescence hash table of each search thread (256K, to fit in L2 cache)
+        QuiesceHashTableSize = 16*1024,
+
         // Time/depth control modes
         mode_FixedTime      = 0,        // Search stops after a fixed time
         mode_FixedDepth,                // Search stops after reaching a fixed depth
@@ -139,9 +150,22 @@ public:
     static int  pruneMarginAtFrontier;      // Futility pruning (depth < 2)
     static int  pruneMarginAtPreFrontier;   // Futility pruning (depth < 3)
 
+    // Parallel search
+    static int  numOfSearchThreads;     // Number of search threads (main thread included)
+    static int  mtdProbeSpread;         // If not zero, helper threads probe MTD(f) bounds this far apart (instead of searching on their own)
+
     // Hash table
-    static int  sizeOfHashTable;        // Number of entries (must be a power of two)
-    static int  sizeOfPawnHashTable;    // Number of entries (must be a power of two)
+    static Uint64 sizeOfHashTable;      // Size in bytes (must be a power of two), there are 16 bytes per entry (8 with COMPACT_HASH)
+    static Uint64 sizeOfPawnHashTable;  // Size in bytes (must be a power of two)
+    static Uint64 sizeOfEvalCache;      // Size in bytes (must be a power of two), there is a cache for each thread
+    static Uint64 sizeOfPerftHashTable; // Size in bytes (must be a power of two), allocated only while running perft
+    static Uint64 memoryBudget;         // If not zero, the sizes above are computed from this (see "memory" command)
+    static int  hashClearThreads;       // Threads used to clear the hash table (zero for one per processor)
+    static int  lazyHashClear;          // If not zero, the hash table is aged instead of cleared between games
+
+    // Processor
+    static int  useCpuFeatures;         // If zero, optional instructions (e.g. POPCNT) are not used even if available
+    static int  useCopyMake;            // If not zero, moves are played on a copy of the position instead of make/unmake
 
     // Resign threshold
     static int  resignThreshold;
@@ -181,6 +205,10 @@ public:
         return pawnHashTable;
     }
 
+    static EvalCache * getEvalCache() {
+        return evalCache;
+    }
+
     static int main( Adapter * adapter );
 
     static Adapter * getInterfaceAdapter() {
@@ -190,10 +218,13 @@ public:
     static int resetBoard( const char * fen );
     
 private:
+    // Game and search path info: this is plain data because each
+    // search thread keeps its own copy of the search path
     struct Rep3Info
     {
-        BitBoard    hashCode;
+        Uint64      hashCode;
         unsigned    repCount;
+        int         materialScore;
     };
 
     static void think();
@@ -205,9 +236,11 @@ private:
     // Test
     static int test();
     static int perft( const char * fen, int max_depth );
-    static int perftRunSuite();
+    static int perftDivide( const char * fen, int depth );
+    static int perftRunSuite( const char * name, int max_depth, const char * output = 0 );
     static int runTestSuiteEPD( const char * name, int secondsPerMove, int maxDepth );
     static int runEvalSuiteEPD( const char * name );
+    static int runBenchmark( int depth );
 
     // Game
     static int handleThinkingComplete();
@@ -224,7 +257,13 @@ private:
     static void updateThinkingDisplay();
     static void setMoveToPlay( Move m, int score, int depth, int maxdepth, int nodes );
     static void initializeSearch();
+    static void clearHashTables( bool pawns );
+    static void clearEvalTables();
+    static void updateTableSizes();
+    static unsigned getPawnHashTableEntries();
+    static unsigned getEvalCacheEntries();
     static int getFullMovesPlayedFor( int side );
+    static unsigned getNodesSearched();
 
     // Book
     static Move getBookMove( Book & book, const Position & pos );
@@ -235,10 +274,15 @@ private:
     static bool         showThinking;
     static unsigned     showThinkingLastUpdate;
     static HashTable *  hashTable;          // Main hashtable (for search)
-    static PawnHashTable * pawnHashTable;   // Pawn hashtable (for evaluation)
+    static bool         hashTableRestored;  // True if a snapshot has been loaded and not yet searched
+    static THREAD_LOCAL PawnHashTable * pawnHashTable;  // Pawn hashtable (for evaluation), one per search thread
+    static THREAD_LOCAL EvalCache * evalCache;  // Evaluation cache, one per search thread
+    static THREAD_LOCAL QuiesceHashTable * quiesceHashTable; // Quiescence hashtable, one per search thread
+    static THREAD_LOCAL Position * positionStack;   // Positions for copy-make (indexed by ply), one stack per search thread
     static volatile bool searchMustBeInterrupted;
     static unsigned     searchStartTime;
-    static Rep3Info     rep3History[MaxMovesPerGame+MaxSearchPly];
+    static THREAD_LOCAL int searchThreadId; // Zero for the main thread
+    static THREAD_LOCAL Rep3Info rep3History[MaxMovesPerGame+MaxSearchPly];
     static MoveInfo     moveHistory[MaxMovesPerGame];
     static Position     gameHistory[MaxMovesPerGame+MaxSearchPly];
     static int          gameHistoryIdx; // Same as number of half moves played since start position
@@ -261,12 +305,43 @@ private:
 
     static bool isSearchOver();
 
+    // Starts loading all table entries for the specified position into the cache,
+    // so they are (hopefully) available by the time they are probed
+    static void prefetchTables( const Position & pos ) {
+        hashTable->prefetch( pos );
+        prefetchEvalTables( pos );
+    }
+
+    // Same as above, for the tables used by the evaluation only
+    static void prefetchEvalTables( const Position & pos ) {
+        pawnHashTable->prefetch( pos );
+        evalCache->prefetch( pos );
+    }
+
+    // Returns where to play the moves of a node at the specified ply (see MoveMaker),
+    // null for make/unmake
+    static Position * getChildPosition( int ply ) {
+        return (useCopyMake && ply+1 < PositionStackSize) ? &positionStack[ply+1] : 0;
+    }
+
     static int negaMaxQuiesceMT( Position & pos, int gamma, int ply, int checks_depth = 0 );
     static int negaMaxMT( Position & pos, int gamma, int ply, int depth );
     static int negaMaxMT_AtRoot( Position & pos, int gamma, int depth, RootMoveList & moves );
     static int initializeSearch( const Position & pos, int initial_score, RootMoveList & moves );
     static int searchMTDf( Position & pos, int f, int depth, RootMoveList & moves );
     static int searchPosition( Position & pos, int f, int depth );
+
+    // Parallel search (helper threads)
+    static void startHelperThreads( const Position & pos, const RootMoveList & moves, int f, int maxdepth );
+    static void stopHelperThreads();
+    static void joinHelperThreads();
+    static void clearHelperTables();
+    static void updateHelperNodes();
+    static void helperThreadMain( void * param );
+    static void helperProbeLoop( void * param );
+    static void beginParallelProbes( int depth, int fractDepth, int f );
+    static void endParallelProbes();
+    static void mergeParallelProbes( int gamma, int g, RootMoveList & moves, int & lower, int & upper );
 };
 
 #endif // ENGINE_H_
@@ -187,8 +187,9 @@ int Engine::playMove( Move move, MoveInfo * info )
         }
 
         // Update 3-position repetition history
-        rep3History[ gameHistoryIdx ].hashCode = gamePosition.hashCode;
+        rep3History[ gameHistoryIdx ].hashCode = gamePosition.hashCode.data;
         rep3History[ gameHistoryIdx ].repCount = 0;
+        rep3History[ gameHistoryIdx ].materialScore = gamePosition.materialScore;
 
         int n = gameHistoryIdx - 4;
         int e = gameHistoryIdx - gamePosition.getHalfMoveClock();
@@ -220,16 +221,65 @@ int Engine::undoMove( int numOfHalfMoves )
 
     ponderMove = Move::Null;
 
-    hashTable->reset();
+    clearHashTables( false );
 
     return 0;
 }
 
+static int getHashClearThreads()
+{
+    return Engine::hashClearThreads > 0 ? Engine::hashClearThreads : System::getNumberOfProcessors();
+}
+
+/*
+    In lazy mode the main hash table is not cleared, but its entries are made
+    older than those of the next search, so they are the first to be replaced.
+
+    A snapshot loaded with "ttload" is left alone until it has been searched,
+    so that it can be loaded either before or after setting the position.
+*/
+void Engine::clearHashTables( bool pawns )
+{
+    if( hashTableRestored ) {
+        // Nothing to do
+    }
+    else if( lazyHashClear ) {
+        hashTable->bumpSearchId( getHashClearThreads() );
+    }
+    else {
+        unsigned t = System::getTickCount();
+
+        hashTable->reset( getHashClearThreads() );
+
+        t = System::getTickCount() - t;
+
+        if( t >= 100 ) {
+            Log::write( "Hash table cleared in %u ms\n", t );
+        }
+    }
+
+    if( pawns ) {
+        clearEvalTables();
+    }
+}
+
+/*
+    Clears the tables that hold evaluation results (of all search threads), which
+    must also be done when the evaluation parameters change.
+*/
+void Engine::clearEvalTables()
+{
+    pawnHashTable->reset();
+    evalCache->reset();
+    quiesceHashTable->reset();
+
+    clearHelperTables();
+}
+
 int Engine::resetBoard( const char * fen )
 {
     // Cleanup hash tables
-    hashTable->reset();
-    pawnHashTable->reset();
+    clearHashTables( true );
 
     Position pos;
 
@@ -246,8 +296,9 @@ int Engine::resetBoard( const char * fen )
     gameHistoryIdx = 0;
     gameHistory[ 0 ] = pos;
     moveHistory[ 0 ].reset();
-    rep3History[ 0 ].hashCode = pos.hashCode;
+    rep3History[ 0 ].hashCode = pos.hashCode.data;
     rep3History[ 0 ].repCount = 0;
+    rep3History[ 0 ].materialScore = pos.materialScore;
 
     numOfMovesNotInBook = 0;
 
@@ -443,6 +494,8 @@ int Engine::handleThinkingComplete()
         }
 
         Recognizer::dumpStats();
+
+        hashTable->dumpStats();
     }
     else {
         // ...else we changed state because of some external input, ignore
@@ -464,6 +517,8 @@ void Engine::initializeSearch()
 
     ponderMove = Move::Null;
 
+    hashTableRestored = false;
+
     Recognizer::clearStats();
 }
 
@@ -629,11 +684,12 @@ void Engine::think()
 
     dumpPosition( gamePosition );
 
+    // Age the hash table first, as it may have to be cleared (see HashTable::bumpSearchId())
+    hashTable->bumpSearchId( getHashClearThreads() );
+
     // Initialize search parameters
     initializeSearch();
 
-    hashTable->bumpSearchId();
-
     int depth = (searchMode == mode_FixedDepth) ? fixedSearchDepth : MaxSearchPly;
     int score = 0;
 
@@ -739,9 +795,10 @@ void Engine::analyze()
 
     Recognizer::dumpStats();
 
+    hashTable->dumpStats();
+
     // Cleanup hash tables on exit, as by default neither think() nor ponder() do it
-    hashTable->reset();
-    pawnHashTable->reset();
+    clearHashTables( true );
 }
 
 static void printBB( const char * name, const BitBoard & bb )
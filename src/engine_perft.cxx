@@ -17,19 +17,165 @@
     along with this program; if not, write to the Free Software
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
 #include "engine.h"
 #include "log.h"
+#include "movemaker.h"
+#include "san.h"
+#include "system.h"
 #include "undoinfo.h"
-#include "san.h"
 
-static unsigned perft_nodes[Engine::MaxSearchPly];
+/*
+    Perft hash table: an entry stores the number of leaf nodes found at some depth
+    below a position. Entries are shared by all the perft threads without locks,
+    the key is stored xor'ed with the data so that an entry overwritten by two
+    threads at the same time is detected and ignored.
+*/
+struct PerftHashEntry
+{
+    Uint64  lock;   // Hash code of the position xor data
+    Uint64  data;   // Leaf nodes (upper 56 bits) and depth (lower 8 bits)
+};
+
+static PerftHashEntry * perft_hash;
+static Uint64           perft_hash_mask;
+static size_t           perft_hash_size;    // Size in bytes
+
+static bool perft_probe( const Position & pos, int depth, Uint64 & nodes )
+{
+    PerftHashEntry * entry = &perft_hash[ pos.hashCode.data & perft_hash_mask ];
+
+    Uint64 data = entry->data;
+
+    if( (entry->lock ^ data) == pos.hashCode.data && (int)(data & 0xFF) == depth ) {
+        nodes = data >> 8;
+        return true;
+    }
+
+    return false;
+}
 
-static void perft_search( Position & pos, int depth )
+static void perft_store( const Position & pos, int depth, Uint64 nodes )
+{
+    PerftHashEntry * entry = &perft_hash[ pos.hashCode.data & perft_hash_mask ];
+
+    Uint64 data = (nodes << 8) | (Uint64) depth;
+
+    entry->lock = pos.hashCode.data ^ data;
+    entry->data = data;
+}
+
+/*
+    Work shared by the perft threads: the moves at the root are handed out one
+    at a time to the first thread that asks for one.
+*/
+struct PerftWorker
+{
+    void *          handle;
+    Position        root;
+    Position *      stack;      // Positions for copy-make, null for make/unmake
+    unsigned        errors;     // Positions where the move generators differ
+};
+
+static PerftWorker  perft_workers[ Engine::MaxSearchThreads ];
+static MoveList     perft_root_moves;
+static Uint64       perft_root_nodes[ MoveList::MaxMoveCount ];
+static int          perft_depth;
+static int          perft_next_move;
+static void *       perft_lock = 0;
+static int          perft_threads;
+
+/*
+    Checks that the legal move generator returns exactly the same moves as the
+    pseudo-legal generators, once illegal moves are removed from the latter
+    (in the same order too).
+*/
+static void perft_check( PerftWorker & worker, Position & pos, MoveList & legal )
+{
+    MoveList    movelist;
+    MoveList    valid;
+    UndoInfo    undoinfo( pos );
+
+    if( pos.boardFlags & Position::SideToPlayInCheck ) {
+        pos.generateCheckEscapes( movelist );
+    }
+    else {
+        pos.generateMoves( movelist );
+    }
+
+    for( int i=0; i<movelist.count(); i++ ) {
+        Move    m = movelist.get(i);
+
+        if( pos.doMove( m ) == 0 ) {
+            valid.add( movelist.get(i) );
+        }
+
+        pos.undoMove( m, undoinfo );
+    }
+
+    bool ok = valid.count() == legal.count();
+
+    for( int j=0; ok && j<valid.count(); j++ ) {
+        ok = valid.get(j) == legal.get(j);
+    }
+
+    if( ! ok ) {
+        if( worker.errors < 10 ) {
+            char fen[200];
+
+            pos.getBoard( fen );
+
+            printf( "*** Error: generators differ (%d legal, %d expected) in %s\n", legal.count(), valid.count(), fen );
+        }
+
+        worker.errors++;
+    }
+}
+
+/*
+    Returns the number of leaf nodes "depth" plies below the specified position
+    (depth must be at least one). If "next" is not null, moves are played with
+    copy-make on the positions it points to (one per ply).
+
+    With the legal move generator the last ply is counted in bulk, i.e. moves
+    are counted without playing them.
+*/
+static Uint64 perft_count( PerftWorker & worker, Position & pos, int depth, Position * next )
 {
-    if( depth >= 0 ) {
-        MoveList    movelist;
-        UndoInfo    undoinfo( pos );
+    Uint64      nodes = 0;
+
+    if( depth > 1 && perft_hash != 0 && perft_probe( pos, depth, nodes ) ) {
+        return nodes;
+    }
+
+    MoveList    movelist;
+    MoveMaker   moveMaker( pos, next );
+
+    if( Position::useLegalMoveGenerator ) {
+        pos.generateLegalMoves( movelist );
+
+        if( Position::useLegalMoveGenerator > 1 ) {
+            perft_check( worker, pos, movelist );
+        }
 
+        if( depth == 1 ) {
+            return movelist.count();
+        }
+
+        for( int i=0; i<movelist.count(); i++ ) {
+            Move    m = movelist.get(i);
+
+            moveMaker.doMove( m );
+
+            nodes += perft_count( worker, moveMaker.position(), depth-1, next ? next+1 : 0 );
+
+            moveMaker.undoMove( m );
+        }
+    }
+    else {
         if( pos.boardFlags & Position::SideToPlayInCheck ) {
             pos.generateCheckEscapes( movelist );
         }
@@ -40,110 +186,488 @@ static void perft_search( Position & pos, int depth )
         for( int i=0; i<movelist.count(); i++ ) {
             Move    m = movelist.get(i);
 
-            if( pos.doMove( m ) == 0 ) {
-                ++perft_nodes[depth];
-
-                perft_search( pos, depth-1 );
+            if( moveMaker.doMove( m ) == 0 ) {
+                nodes += (depth == 1) ? 1 : perft_count( worker, moveMaker.position(), depth-1, next ? next+1 : 0 );
             }
 
-            pos.undoMove( m, undoinfo );
+            moveMaker.undoMove( m );
         }
     }
+
+    if( depth > 1 && perft_hash != 0 ) {
+        perft_store( pos, depth, nodes );
+    }
+
+    return nodes;
+}
+
+/*
+    Thread procedure: counts the nodes below the root moves until there are none left.
+*/
+static void perft_thread( void * param )
+{
+    PerftWorker * worker = (PerftWorker *) param;
+
+    MoveMaker   moveMaker( worker->root, worker->stack );
+
+    while( 1 ) {
+        System::acquireLock( perft_lock );
+        int i = perft_next_move++;
+        System::releaseLock( perft_lock );
+
+        if( i >= perft_root_moves.count() ) {
+            break;
+        }
+
+        Move    m = perft_root_moves.get(i);
+
+        moveMaker.doMove( m );
+
+        perft_root_nodes[i] = (perft_depth == 1) ? 1 : perft_count( *worker, moveMaker.position(), perft_depth-1, worker->stack ? worker->stack+1 : 0 );
+
+        moveMaker.undoMove( m );
+    }
 }
 
 /*
-    The perft() function performs a full traversal of the move tree down to the
-    specified depth.
-
-    It is used to test and benchmark the move generation code, and can be verified
-    against known results.
-
-    *** Position::startPosition
-    1) = 20
-    2) = 400
-    3) = 8902
-    4) = 197281
-    5) = 4865609
-    6) = 119060324
-
-    *** "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -"
-    1) = 48
-    2) = 2039
-    3) = 97862
-    4) = 4085603
-    5) = 193690690
-
-
-    *** "8/PPP4k/8/8/8/8/4Kppp/8 w - -"
-    1) = 18
-    2) = 290
-    3) = 5044
-    4) = 89363
-    5) = 1745545
-    6) = 34336777
-    7) = 749660761
-
-    *** "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -"
-
-    1) = 14
-    2) = 191
-    3) = 2812
-    4) = 43238
-    5) = 674624
-    6) = 11030083
-    7) = 178633661
+    Prepares a perft run on the specified position: gets the legal moves at the
+    root (they are shared by the threads), the hash table and the threads.
 */
-int Engine::perft( const char * fen, int max_depth )
-{
-    printf( "perft: depth=%d, FEN=%s\n", max_depth, fen );
+static void perft_begin( const Position & pos, int max_depth )
+{
+    Position    root( pos );
+
+    perft_root_moves.reset();
 
-    Position pos;
+    if( Position::useLegalMoveGenerator ) {
+        root.generateLegalMoves( perft_root_moves );
+    }
+    else {
+        MoveList    movelist;
+        UndoInfo    undoinfo( root );
 
-    pos.setBoard( fen );
+        if( root.boardFlags & Position::SideToPlayInCheck ) {
+            root.generateCheckEscapes( movelist );
+        }
+        else {
+            root.generateMoves( movelist );
+        }
+
+        for( int i=0; i<movelist.count(); i++ ) {
+            Move    m = movelist.get(i);
 
+            if( root.doMove( m ) == 0 ) {
+                perft_root_moves.add( movelist.get(i) );
+            }
+
+            root.undoMove( m, undoinfo );
+        }
+    }
+
+    // The hash table only saves time, so make do with less memory or even none
+    perft_hash_size = (size_t) Engine::sizeOfPerftHashTable;
+    perft_hash = (PerftHashEntry *) System::allocateLargestBlock( perft_hash_size, 1024*1024 );
+
+    if( perft_hash == 0 ) {
+        printf( "*** Warning: cannot allocate perft hash table, continuing without\n" );
+    }
+    else if( perft_hash_size < Engine::sizeOfPerftHashTable ) {
+        printf( "*** Warning: not enough memory for perft hash table, using %uM\n", (unsigned) (perft_hash_size >> 20) );
+    }
+
+    perft_hash_mask = perft_hash_size / sizeof(PerftHashEntry) - 1;
+
+    if( perft_lock == 0 ) {
+        perft_lock = System::createLock();
+    }
+
+    perft_threads = Engine::numOfSearchThreads;
+
+    for( int i=0; i<perft_threads; i++ ) {
+        bool copyMake = Engine::useCopyMake && max_depth < Engine::PositionStackSize;
+
+        perft_workers[i].root = pos;
+        perft_workers[i].stack = copyMake ? new Position[ max_depth+1 ] : 0;
+        perft_workers[i].errors = 0;
+    }
+}
+
+/*
+    Returns the number of leaf nodes at the specified depth, the count for each
+    root move is left in perft_root_nodes.
+*/
+static Uint64 perft_run( int depth )
+{
     int i;
 
-    for( i=0; i<8; i++ ) {
-        perft_nodes[i] = 0;
+    perft_depth = depth;
+    perft_next_move = 0;
+
+    for( i=1; i<perft_threads; i++ ) {
+        perft_workers[i].handle = System::startThread( perft_thread, &perft_workers[i] );
+    }
+
+    perft_thread( &perft_workers[0] );
+
+    for( i=1; i<perft_threads; i++ ) {
+        if( perft_workers[i].handle != 0 ) {
+            System::waitThread( perft_workers[i].handle );
+        }
+    }
+
+    Uint64 nodes = 0;
+
+    for( i=0; i<perft_root_moves.count(); i++ ) {
+        nodes += perft_root_nodes[i];
+    }
+
+    return nodes;
+}
+
+/*
+    Releases what was allocated by perft_begin(), returns the number of positions
+    where the move generators differ.
+*/
+static unsigned perft_end()
+{
+    unsigned errors = 0;
+
+    for( int i=0; i<perft_threads; i++ ) {
+        errors += perft_workers[i].errors;
+
+        delete [] perft_workers[i].stack;
+        perft_workers[i].stack = 0;
+    }
+
+    if( perft_hash != 0 ) {
+        System::freeLargeBlock( perft_hash, perft_hash_size );
+        perft_hash = 0;
+    }
+
+    if( errors > 0 ) {
+        printf( "*** Error: move generators differ in %u positions\n", errors );
+    }
+
+    return errors;
+}
+
+static void perft_print_header( const char * what, const char * fen, int depth )
+{
+    printf( "%s: depth=%d, FEN=%s (%s move generator, %s, %d thread%s)\n", what, depth, fen,
+        Position::useLegalMoveGenerator ? "legal" : "pseudo-legal",
+        Engine::useCopyMake ? "copy-make" : "make/unmake",
+        Engine::numOfSearchThreads, Engine::numOfSearchThreads > 1 ? "s" : "" );
+}
+
+/*
+    Prints the number of leaf nodes below each root move, as computed by the
+    last call to perft_run().
+*/
+static void perft_print_divide( const Position & pos )
+{
+    for( int i=0; i<perft_root_moves.count(); i++ ) {
+        char    san[16];
+
+        SAN::moveToText( san, pos, perft_root_moves.get(i) );
+
+        printf( "  %-8s %" PRIu64 "\n", san, perft_root_nodes[i] );
     }
+}
+
+/*
+    The perft() function performs a full traversal of the move tree down to the
+    specified depth.
+
+    It is used to test and benchmark the move generation code, and can be verified
+    against known results (see data/perftsuite.epd and perftRunSuite()).
+
+    The moves at the root are shared by all search threads (see "search.threads"),
+    and positions already counted are found in a hash table (see "perft.hashsize").
+    Counters are 64-bit, so deep counts such as 749660761 (depth 7 of the
+    "8/PPP4k/8/8/8/8/4Kppp/8 w - -" endgame) are safe.
+*/
+int Engine::perft( const char * fen, int max_depth )
+{
+    perft_print_header( "perft", fen, max_depth );
+
+    Position pos;
+
+    pos.setBoard( fen );
 
-    max_depth--;
+    perft_begin( pos, max_depth );
 
+    // Count the nodes at each depth, each iteration gets the results
+    // of the previous one from the hash table
     unsigned t = System::getTickCount();
 
-    perft_search( pos, max_depth );
+    Uint64 c = 0;
 
-    t = System::getTickCount() - t;
+    for( int depth=1; depth<=max_depth; depth++ ) {
+        Uint64 nodes = perft_run( depth );
 
-    unsigned c = 0;
+        c += nodes;
 
-    for( i=max_depth; i>=0; i-- ) {
-        c += perft_nodes[i];
-        printf( "  depth=%d, nodes=%d\n", max_depth-i+1, perft_nodes[i] );
+        printf( "  depth=%d, nodes=%" PRIu64 "\n", depth, nodes );
     }
 
+    t = System::getTickCount() - t;
+
     if( t == 0 ) t = 1;
 
-    printf( "perft complete: total=%d nodes in %d.%03d seconds (%d KNps)\n\n", c, t / 1000, t % 1000, c / t );
+    perft_end();
+
+    printf( "perft complete: total=%" PRIu64 " nodes in %u.%03u seconds (%u KNps)\n\n", c, t / 1000, t % 1000, (unsigned) (c / t) );
 
     return 0;
 }
 
-int Engine::perftRunSuite()
+/*
+    Same as perft() for the specified depth only, but also shows the number of
+    nodes below each root move: comparing them with the output of another program
+    tells which move leads to a wrong count.
+*/
+int Engine::perftDivide( const char * fen, int depth )
 {
-    // Start position
-    perft( Position::startPosition, 6 );
+    perft_print_header( "divide", fen, depth );
 
-    // Interesting position, helped me catch a nasty bug in the check evasion generator
-    // (caused by a wrongly computed Attacks::SquaresBetween array)
-    perft( "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -", 5 );
+    Position pos;
+
+    pos.setBoard( fen );
+
+    perft_begin( pos, depth );
+
+    unsigned t = System::getTickCount();
+
+    Uint64 c = perft_run( depth );
+
+    t = System::getTickCount() - t;
+
+    if( t == 0 ) t = 1;
+
+    perft_print_divide( pos );
 
-    // Endgame position
-    perft( "8/PPP4k/8/8/8/8/4Kppp/8 w - -", 6 );
+    perft_end();
 
-    // This spotted another (last?!?) bug in the check evasion generator, when the
-    // piece that gives check is a pawn that can be captured en-passant...
-    perft( "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -", 6 );
+    printf( "divide complete: %d moves, %" PRIu64 " nodes in %u.%03u seconds (%u KNps)\n\n", perft_root_moves.count(), c, t / 1000, t % 1000, (unsigned) (c / t) );
 
     return 0;
 }
+
+/*
+    Writes a string field of the suite output, in quotes. JSON escapes quotes and
+    backslashes (e.g. in Windows paths) with a backslash, CSV doubles the quotes.
+*/
+static void perft_write_string( FILE * o, const char * s, bool json )
+{
+    fputc( '"', o );
+
+    for( ; *s != '\0'; s++ ) {
+        if( json && (*s == '"' || *s == '\\') ) {
+            fputc( '\\', o );
+        }
+        else if( json && (unsigned char) *s < 0x20 ) {
+            fprintf( o, "\\u%04x", (unsigned char) *s );
+            continue;
+        }
+        else if( ! json && *s == '"' ) {
+            fputc( '"', o );
+        }
+
+        fputc( *s, o );
+    }
+
+    fputc( '"', o );
+}
+
+/*
+    Runs perft on all the positions of an EPD file, where the expected node counts
+    follow the position as ";D1 20 ;D2 400 ..." (the format of the well-known
+    perftsuite.epd file, see data/perftsuite.epd).
+
+    Each position is searched up to the deepest count available or "max_depth",
+    whichever comes first. When a count is wrong the position is "divided" at that
+    depth, so the offending root move can be found.
+
+    If "output" is not null, results are also saved to that file, in JSON format
+    if the name ends with ".json" and as comma-separated values otherwise. There is
+    a record per position, with the deepest depth searched, the nodes at that depth,
+    the total time spent on the position and the speed (all depths included).
+*/
+int Engine::perftRunSuite( const char * name, int max_depth, const char * output )
+{
+    FILE *  f;
+    FILE *  o = 0;
+    char    b[1024];
+    bool    json = false;
+
+    f = fopen( name, "r" );
+
+    if( f == NULL ) {
+        printf( "*** Error: cannot open file!\n" );
+        return -1;
+    }
+
+    if( output != 0 ) {
+        size_t l = strlen( output );
+
+        json = l >= 5 && strcmp( output + l - 5, ".json" ) == 0;
+
+        o = fopen( output, "w" );
+
+        if( o == NULL ) {
+            printf( "*** Error: cannot create output file!\n" );
+            fclose( f );
+            return -1;
+        }
+
+        if( json ) {
+            fprintf( o, "{\n  \"suite\": " );
+            perft_write_string( o, name, json );
+            fprintf( o, ",\n  \"movegen\": \"%s\",\n  \"copymake\": %d,\n  \"threads\": %d,\n  \"positions\": [\n",
+                Position::useLegalMoveGenerator ? "legal" : "pseudo-legal", useCopyMake, numOfSearchThreads );
+        }
+        else {
+            fprintf( o, "fen,depth,nodes,expected,ms,knps,result\n" );
+        }
+    }
+
+    int     num = 0;        // Positions searched
+    int     failed = 0;     // Positions with a wrong count
+    Uint64  totalNodes = 0;
+    unsigned totalTime = 0;
+
+    while( fgets( b, sizeof(b), f ) != NULL ) {
+        b[ sizeof(b)-1 ] = '\0';
+
+        // Split the position from the expected counts
+        char * s = strchr( b, ';' );
+
+        if( s == 0 ) {
+            continue;
+        }
+
+        *s++ = '\0';
+
+        char * fen = b;
+        size_t l = strlen( fen );
+
+        while( l > 0 && isspace( fen[l-1] ) ) {
+            fen[--l] = '\0';
+        }
+
+        Uint64  expected[ MaxSearchPly ];
+        int     depths = 0;
+
+        while( s != 0 ) {
+            int     d;
+            Uint64  n = 0;
+
+            while( isspace(*s) ) s++;
+
+            if( *s == 'D' && sscanf( s+1, "%d", &d ) == 1 && d == depths+1 && d < MaxSearchPly ) {
+                s = strchr( s, ' ' );
+
+                while( s != 0 && isspace(*s) ) s++;
+
+                while( s != 0 && isdigit(*s) ) {
+                    n = n*10 + *s - '0';
+                    s++;
+                }
+
+                expected[ depths++ ] = n;
+            }
+
+            s = (s != 0) ? strchr( s, ';' ) : 0;
+
+            if( s != 0 ) s++;
+        }
+
+        if( depths > max_depth ) {
+            depths = max_depth;
+        }
+
+        if( depths == 0 ) {
+            continue;
+        }
+
+        num++;
+
+        Position pos;
+
+        pos.setBoard( fen );
+
+        perft_begin( pos, depths );
+
+        unsigned t = System::getTickCount();
+
+        int     depth;
+        Uint64  nodes = 0;
+        Uint64  allNodes = 0;
+        bool    ok = true;
+
+        for( depth=1; ok && depth<=depths; depth++ ) {
+            nodes = perft_run( depth );
+
+            allNodes += nodes;
+
+            ok = nodes == expected[depth-1];
+        }
+
+        depth--;
+
+        t = System::getTickCount() - t;
+
+        unsigned knps = (unsigned) (allNodes / (t > 0 ? t : 1));
+
+        if( ok ) {
+            printf( "%d) %s: depth=%d, nodes=%" PRIu64 " in %u.%03u seconds (%u KNps)\n", num, fen, depth, nodes, t / 1000, t % 1000, knps );
+        }
+        else {
+            failed++;
+
+            printf( "%d) %s: *** Error at depth=%d, nodes=%" PRIu64 ", expected %" PRIu64 "\n", num, fen, depth, nodes, expected[depth-1] );
+
+            perft_print_divide( pos );
+        }
+
+        if( perft_end() > 0 ) {
+            ok = false;
+        }
+
+        totalNodes += allNodes;
+        totalTime += t;
+
+        if( o != 0 ) {
+            const char * result = ok ? "ok" : "fail";
+
+            if( json ) {
+                fprintf( o, "%s    { \"fen\": ", num > 1 ? ",\n" : "" );
+                perft_write_string( o, fen, json );
+                fprintf( o, ", \"depth\": %d, \"nodes\": %" PRIu64 ", \"expected\": %" PRIu64 ", \"ms\": %u, \"knps\": %u, \"result\": \"%s\" }",
+                    depth, nodes, expected[depth-1], t, knps, result );
+            }
+            else {
+                perft_write_string( o, fen, json );
+                fprintf( o, ",%d,%" PRIu64 ",%" PRIu64 ",%u,%u,%s\n", depth, nodes, expected[depth-1], t, knps, result );
+            }
+        }
+    }
+
+    fclose( f );
+
+    unsigned knps = (unsigned) (totalNodes / (totalTime > 0 ? totalTime : 1));
+
+    if( o != 0 ) {
+        if( json ) {
+            fprintf( o, "\n  ],\n  \"total\": { \"positions\": %d, \"failed\": %d, \"nodes\": %" PRIu64 ", \"ms\": %u, \"knps\": %u }\n}\n",
+                num, failed, totalNodes, totalTime, knps );
+        }
+
+        fclose( o );
+    }
+
+    printf( "perft suite complete: %d positions, %d failed, %" PRIu64 " nodes in %u.%03u seconds (%u KNps)\n\n",
+        num, failed, totalNodes, totalTime / 1000, totalTime % 1000, knps );
+
+    return failed;
+}
@@ -17,11 +17,13 @@
     along with this program; if not, write to the Free Software
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
+#include "counters.h"
 #include "engine.h"
 #include "log.h"
 #include "move.h"
 #include "movelist.h"
 #include "movehandler.h"
+#include "movemaker.h"
 #include "position.h"
 #include "recognizer.h"
 #include "san.h"
@@ -31,8 +33,10 @@
 const bool haveRecognizersInQuiesce = true;
 const bool haveChecksInQuiesce      = true;
 const bool haveHashInQuiesce        = true;
+const bool haveQuiesceHashTable     = true;  // Use a separate (small) table instead of the main one
+const bool havePrefetchInQuiesce    = true;
 
-extern int nodesUntilInputCheck;
+extern THREAD_LOCAL int nodesUntilInputCheck;
 
 static int getRelativeEvaluation( const Position & pos )
 {
@@ -45,8 +49,32 @@ static int getRelativeEvaluation( const Position & pos )
     return result;
 }
 
+/*
+    Same as above, but the result may be a bound if the score is far from gamma
+    (see Position::getEvaluation()).
+
+    The bound is only allowed on the side that becomes a lower bound at the root,
+    i.e. when the stand pat fails high at even plies and when it fails low at odd
+    plies. Loose upper bounds at the root made the benchmark search about 30% more
+    nodes, as MTD(f) needs more passes to converge, while loose lower bounds did
+    not change the node count at all.
+*/
+static int getRelativeEvaluation( const Position & pos, int gamma, int ply )
+{
+    int lowerBound = (ply & 1) ? gamma-1 : Score::Min;
+    int upperBound = (ply & 1) ? Score::Max : gamma;
+
+    if( pos.sideToPlay == Black ) {
+        return -pos.getEvaluation( -upperBound, -lowerBound );
+    }
+
+    return pos.getEvaluation( lowerBound, upperBound );
+}
+
 int Engine::negaMaxQuiesceMT( Position & pos, int gamma, int ply, int checks_depth )
 {
+    Counters::quiesceNodes++;
+
     // Check for input every now and then
     if( --nodesUntilInputCheck <= 0 ) {
         isSearchOver();
@@ -72,7 +100,7 @@ int Engine::negaMaxQuiesceMT( Position & pos, int gamma, int ply, int checks_dep
         int e = gameHistoryIdx + ply - hmc;
 
         while( n >= e ) {
-            if( pos.hashCode == rep3History[ n ].hashCode ) {
+            if( pos.hashCode.data == rep3History[ n ].hashCode ) {
                 // Found, update repetition count and exit from the loop
                 repCount = 1 + rep3History[ n ].repCount;
 
@@ -98,13 +126,32 @@ int Engine::negaMaxQuiesceMT( Position & pos, int gamma, int ply, int checks_dep
     }
 
     if( haveHashInQuiesce ) {
-        HashTable::Entry * hashEntry = hashTable->probe( pos );
+        bool found = false;
+        bool upperBound = false;
+        int value = 0;
+
+        if( haveQuiesceHashTable ) {
+            const QuiesceHashTable::Entry * entry = quiesceHashTable->probe( pos );
 
-        if( hashEntry != 0 ) {
-            // Position found in the hash table
-            int value = hashEntry->getValue();
+            if( entry != 0 ) {
+                found = true;
+                upperBound = entry->isUpperBound() != 0;
+                value = entry->getValue();
+            }
+        }
+        else {
+            HashTable::Entry   hashItem;
+            HashTable::Entry * hashEntry = hashTable->probe( pos, hashItem );
+
+            if( hashEntry != 0 ) {
+                found = true;
+                upperBound = hashEntry->isUpperBound() != 0;
+                value = hashEntry->getValue();
+            }
+        }
 
-            // If score is mate, we must convert it from relative to absolute (for the current ply)
+        if( found ) {
+            // Position found in the hash table: if score is mate, we must convert it from relative to absolute (for the current ply)
             if( value < Score::MateLo ) {
                 value += ply;
             }
@@ -112,7 +159,7 @@ int Engine::negaMaxQuiesceMT( Position & pos, int gamma, int ply, int checks_dep
                 value -= ply;
             }
 
-            if( hashEntry->isUpperBound() ) {
+            if( upperBound ) {
                 if( value < gamma ) {
                     return value;
                 }
@@ -130,7 +177,7 @@ int Engine::negaMaxQuiesceMT( Position & pos, int gamma, int ply, int checks_dep
     int result = Score::Min;
 
     if( ! inCheck ) {
-        result = getRelativeEvaluation( pos );
+        result = getRelativeEvaluation( pos, gamma, ply );
 
         if( result >= gamma ) {
             return result;
@@ -156,26 +203,31 @@ int Engine::negaMaxQuiesceMT( Position & pos, int gamma, int ply, int checks_dep
 
     // Generate and check moves
     Move        curr;
-    UndoInfo    parent( pos );
+    MoveMaker   moveMaker( pos, getChildPosition( ply ) );
+    Position &  child = moveMaker.position();
 
     MoveHandler moveHandler( pos, ply, GenerateForQuiesce );
 
     while( ! moveHandler.getNextMove( curr ) ) {
-        if( pos.doMove( curr ) == 0 ) {
-            int temp = -negaMaxQuiesceMT( pos, 1-gamma, ply+1, checks_depth-1 );
+        if( moveMaker.doMove( curr ) == 0 ) {
+            if( havePrefetchInQuiesce ) {
+                haveQuiesceHashTable ? prefetchEvalTables( child ) : prefetchTables( child );
+            }
+
+            int temp = -negaMaxQuiesceMT( child, 1-gamma, ply+1, checks_depth-1 );
 
             if( temp > result ) {
                 result = temp;
 
                 // Check if result is good enough to produce a cutoff
                 if( result >= gamma ) {
-                    pos.undoMove( curr, parent );
+                    moveMaker.undoMove( curr );
                     break;
                 }
             }
         }
 
-        pos.undoMove( curr, parent );
+        moveMaker.undoMove( curr );
     }
 
     // If there was no cutoff so far, search checks
@@ -206,24 +258,28 @@ int Engine::negaMaxQuiesceMT( Position & pos, int gamma, int ply, int checks_dep
 
             if( ! possible ) continue;
 
-            if( pos.doMove( curr ) == 0 ) {
-                if( pos.isSideToMoveInCheck() ) {
+            if( moveMaker.doMove( curr ) == 0 ) {
+                if( havePrefetchInQuiesce ) {
+                    haveQuiesceHashTable ? prefetchEvalTables( child ) : prefetchTables( child );
+                }
+
+                if( child.isSideToMoveInCheck() ) {
                     // The move gives check, search it
-                    int temp = -negaMaxQuiesceMT( pos, 1-gamma, ply+1, checks_depth-1 );
+                    int temp = -negaMaxQuiesceMT( child, 1-gamma, ply+1, checks_depth-1 );
 
                     if( temp > result ) {
                         result = temp;
 
                         // Check if result is good enough to produce a cutoff
                         if( result >= gamma ) {
-                            pos.undoMove( curr, parent );
+                            moveMaker.undoMove( curr );
                             break;
                         }
                     }
                 }
             }
 
-            pos.undoMove( curr, parent );
+            moveMaker.undoMove( curr );
         }
     }
 
@@ -236,11 +292,16 @@ int Engine::negaMaxQuiesceMT( Position & pos, int gamma, int ply, int checks_dep
 
     if( result >= gamma ) {
         if( haveHashInQuiesce ) {
-            hashTable->store( pos,
-                curr,
-                result,
-                HashTable::Entry::LowerBound,
-                0 );
+            if( haveQuiesceHashTable ) {
+                quiesceHashTable->store( pos, result, HashTable::Entry::LowerBound );
+            }
+            else {
+                hashTable->store( pos,
+                    curr,
+                    result,
+                    HashTable::Entry::LowerBound,
+                    0 );
+            }
         }
     }
 
@@ -32,6 +32,7 @@
 #include "move.h"
 #include "movelist.h"
 #include "movehandler.h"
+#include "movemaker.h"
 #include "position.h"
 #include "recognizer.h"
 #include "san.h"
@@ -43,10 +44,12 @@ const bool  isFutilityEnabled       = true;
 const bool  haveHistoryPruning      = true;
 const bool  haveRecognizersInSearch = true;
 const bool  haveRootMoveOrdering    = true;
+const bool  haveTablePrefetch       = true;
 
-int nodesUntilInputCheck     = NodesBetweenInputChecks;
-int maxSearchPly;            // Max search depth for current iteration (plies)
-int maxDepthReached;
+// Note: search variables are kept separately by each search thread
+THREAD_LOCAL int nodesUntilInputCheck   = NodesBetweenInputChecks;
+THREAD_LOCAL int maxSearchPly;          // Max search depth for current iteration (plies)
+THREAD_LOCAL int maxDepthReached;
 
 // Define FULL_NODE_EVAL to get static evaluation at each node, which costs
 // time but improves null move and futility
@@ -68,7 +71,7 @@ struct HistoryInfo
     int fail_high;
 };
 
-HistoryInfo histTable[12*64];
+THREAD_LOCAL HistoryInfo histTable[12*64];
 
 void clearHistTable()
 {
@@ -77,13 +80,24 @@ void clearHistTable()
 
 bool Engine::isSearchOver()
 {
+    // Helper threads leave time and input management to the main thread
+    if( searchThreadId != 0 ) {
+        nodesUntilInputCheck = NodesBetweenInputChecks;
+
+        updateHelperNodes();
+
+        return searchMustBeInterrupted;
+    }
+
     if( isTimeOut() ) {
         searchMustBeInterrupted = true;
     }
     else {
         nodesUntilInputCheck = NodesBetweenInputChecks;
 
-        if( inputCheckWhileSearching ) {
+        // Note: once the search has been interrupted, input is left to the main
+        // loop, which runs after the helper threads have been stopped
+        if( inputCheckWhileSearching && ! searchMustBeInterrupted ) {
             if( System::isInputAvailable() ) {
                 handleInput();
             }
@@ -148,7 +162,7 @@ int Engine::negaMaxMT( Position & pos, int gamma, int depth, int ply )
         int e = gameHistoryIdx + ply - hmc;
 
         while( n >= e ) {
-            if( pos.hashCode == rep3History[ n ].hashCode ) {
+            if( pos.hashCode.data == rep3History[ n ].hashCode ) {
                 // Found, update repetition count and exit from the loop
                 repCount = 1 + rep3History[ n ].repCount;
 
@@ -170,12 +184,12 @@ int Engine::negaMaxMT( Position & pos, int gamma, int depth, int ply )
     }
 
     // Update search path info
-    gameHistory[ gameHistoryIdx + ply ].materialScore = pos.materialScore;
-
-    rep3History[ gameHistoryIdx + ply ].hashCode = pos.hashCode;
+    rep3History[ gameHistoryIdx + ply ].hashCode = pos.hashCode.data;
     rep3History[ gameHistoryIdx + ply ].repCount = repCount;
+    rep3History[ gameHistoryIdx + ply ].materialScore = pos.materialScore;
 
     // Initialize variables
+    HashTable::Entry    hashItem;
     HashTable::Entry *  hashEntry;
     Move                hashMove    = Move::Null;
 
@@ -183,7 +197,7 @@ int Engine::negaMaxMT( Position & pos, int gamma, int depth, int ply )
     bool    hasMateThreat = false;
 
     // Lookup the current position in the transposition table
-    hashEntry = hashTable->probe( pos );
+    hashEntry = hashTable->probe( pos, hashItem );
 
     if( hashEntry != 0 ) {
         Move m = hashEntry->getMove();
@@ -255,7 +269,9 @@ int Engine::negaMaxMT( Position & pos, int gamma, int depth, int ply )
     bool        sideHasFewPieces = (side == Black ? pos.numOfBlackPieces() : pos.numOfWhitePieces()) < 2;
 
 #ifdef FULL_NODE_EVAL
-    int eval = side == Black ? -pos.getEvaluation() : +pos.getEvaluation();
+    // The evaluation is only compared with gamma (null move) and with gamma minus
+    // at most 300 (futility), so outside of that window a bound is enough
+    int eval = side == Black ? -pos.getEvaluation( -gamma, 301-gamma ) : +pos.getEvaluation( gamma-301, gamma );
 #endif
 
     /*
@@ -310,6 +326,10 @@ int Engine::negaMaxMT( Position & pos, int gamma, int depth, int ply )
         if( ! skip ) {
             pos.doNullMove();
 
+            if( haveTablePrefetch ) {
+                prefetchTables( pos );
+            }
+
             int res;
 
             // Null-moving right into quiesce doesn't seem to work very well for me,
@@ -351,7 +371,7 @@ int Engine::negaMaxMT( Position & pos, int gamma, int depth, int ply )
     {
         negaMaxMT( pos, gamma, depth-(2*FullPlyDepth), ply );
 
-        hashEntry = hashTable->probe( pos );
+        hashEntry = hashTable->probe( pos, hashItem );
 
         if( hashEntry != 0 ) {
             Move m = hashEntry->getMove();
@@ -387,16 +407,22 @@ int Engine::negaMaxMT( Position & pos, int gamma, int depth, int ply )
     int         validMoves  = 0;
     bool        failedHigh  = false;
     int         result      = Score::Min;
+    MoveMaker   moveMaker( pos, getChildPosition( ply ) );
+    Position &  child       = moveMaker.position();
 
     while( ! moveHandler.getNextMove( curr ) )
     {
-        if( pos.doMove( curr ) != 0 ) {
+        if( moveMaker.doMove( curr ) != 0 ) {
             // Move not valid, skip
             Counters::posInvalid++;
-            pos.undoMove( curr, undoinfo );
+            moveMaker.undoMove( curr );
             continue;
         }
 
+        if( haveTablePrefetch ) {
+            prefetchTables( child );
+        }
+
         validMoves++;
 
         // Compute extensions
@@ -404,20 +430,20 @@ int Engine::negaMaxMT( Position & pos, int gamma, int depth, int ply )
 
         int to = curr.getTo();
 
-        if( (RankOfSquare(to) == 1 || RankOfSquare(to) == 6) && PieceType( pos.board.piece[ to ] ) == Pawn ) {
+        if( (RankOfSquare(to) == 1 || RankOfSquare(to) == 6) && PieceType( child.board.piece[ to ] ) == Pawn ) {
             depthExtension += extendPawnOn7th;
         }
 
         if( ply >= 2 && curr.isCapture() ) {
-            int trade = gameHistory[ gameHistoryIdx ].materialScore - pos.materialScore;
+            int trade = rep3History[ gameHistoryIdx ].materialScore - child.materialScore;
 
             if( trade >= -20 && trade <= +20 ) {
                 depthExtension += extendRecapture;
             }
 
             // Extend greatly if entering into a pawn endgame
-            if( pos.numOfWhitePieces() == 0 && pos.numOfBlackPieces() == 0 ) {
-                int mat = iabs( gameHistory[ gameHistoryIdx + ply - 1 ].materialScore - pos.materialScore );
+            if( child.numOfWhitePieces() == 0 && child.numOfBlackPieces() == 0 ) {
+                int mat = iabs( rep3History[ gameHistoryIdx + ply - 1 ].materialScore - child.materialScore );
 
                 if( mat > Score::Pawn ) {
                     depth += 2*FullPlyDepth;
@@ -429,7 +455,7 @@ int Engine::negaMaxMT( Position & pos, int gamma, int depth, int ply )
             depthExtension = maxExtensionPerPly;
         }
 
-        unsigned givesCheck = pos.boardFlags & Position::SideToPlayInCheck;
+        unsigned givesCheck = child.boardFlags & Position::SideToPlayInCheck;
 
         /*
             Futility pruning.
@@ -457,17 +483,17 @@ int Engine::negaMaxMT( Position & pos, int gamma, int depth, int ply )
 #ifdef FULL_NODE_EVAL
             int approximateValue = eval + ((depth < 2*FullPlyDepth) ? 100 : 300);
 #else
-            int materialScore = pos.blackToMove() ? -pos.materialScore : +pos.materialScore;
+            int materialScore = child.blackToMove() ? -child.materialScore : +child.materialScore;
             int approximateValue = materialScore + ((depth < 2*FullPlyDepth) ? pruneMarginAtFrontier : pruneMarginAtPreFrontier);
 #endif
 
             if( approximateValue < gamma ) {
-                pos.undoMove( curr, undoinfo );
+                moveMaker.undoMove( curr );
                 continue;
             }
         }
 
-        int hpiece = (pos.board.piece[ curr.getTo() ] >> 1) - 1;
+        int hpiece = (child.board.piece[ curr.getTo() ] >> 1) - 1;
 
         int hindex = hpiece * 64 + curr.getTo();
 
@@ -490,11 +516,11 @@ int Engine::negaMaxMT( Position & pos, int gamma, int depth, int ply )
         unsigned nodes = Counters::callsToEvaluation + Counters::posSearched;
 
 re_search:
-        int temp = -negaMaxMT( pos, 1-gamma, depth+depthExtension-FullPlyDepth, ply+1 );
+        int temp = -negaMaxMT( child, 1-gamma, depth+depthExtension-FullPlyDepth, ply+1 );
 
         // Exit now if search must be interrupted
         if( searchMustBeInterrupted ) {
-            pos.undoMove( curr, undoinfo );
+            moveMaker.undoMove( curr );
             return 0;
         }
 
@@ -525,13 +551,13 @@ re_search:
                 if( validMoves == 1 ) ++Counters::firstFailedHigh;
                 if( validMoves == 2 ) ++Counters::secondFailedHigh;
 
-                pos.undoMove( curr, undoinfo );
+                moveMaker.undoMove( curr );
 
                 break;
             }
         }
 
-        pos.undoMove( curr, undoinfo );
+        moveMaker.undoMove( curr );
     }
 
     if( validMoves == 0 ) {
@@ -616,6 +642,13 @@ int Engine::searchMTDf( Position & pos, int f, int depth, RootMoveList & moveLis
     // Convert depth in the "fractional" format used by negaMaxMT()
     int fractDepth = depth * FullPlyDepth + initialExtensionBonus;
 
+    // If enabled, helper threads probe other windows around f while we search
+    bool parallelProbes = (searchThreadId == 0) && (mtdProbeSpread != 0) && (numOfSearchThreads > 1);
+
+    if( parallelProbes ) {
+        beginParallelProbes( depth, fractDepth, f );
+    }
+
     do {
         g = negaMaxMT_AtRoot( pos, gamma, fractDepth, moveList );
 
@@ -624,7 +657,25 @@ int Engine::searchMTDf( Position & pos, int f, int depth, RootMoveList & moveLis
         }
 
         // Update bounds
-        if( g < gamma ) {
+        if( parallelProbes ) {
+            // Bounds may have been narrowed by the helpers too: keep the next
+            // probe inside the window and use the best known bound as score
+            mergeParallelProbes( gamma, g, moveList, lower, upper );
+
+            gamma = (g < gamma) ? g : g + 1;
+
+            if( gamma <= lower ) {
+                gamma = lower + 1;
+            }
+            else if( gamma > upper ) {
+                gamma = upper;
+            }
+
+            if( lower >= upper ) {
+                g = lower;
+            }
+        }
+        else if( g < gamma ) {
             upper = g;
             gamma = g;
         }
@@ -633,13 +684,19 @@ int Engine::searchMTDf( Position & pos, int f, int depth, RootMoveList & moveLis
             gamma = g + 1;
         }
 
-        // Save the move found
-        setMoveToPlay( moveList.moves[0].move, g, depth, maxDepthReached, Counters::posSearched );
+        // Save the move found (helper threads only share their results thru the hash table)
+        if( searchThreadId == 0 ) {
+            setMoveToPlay( moveList.moves[0].move, g, depth, maxDepthReached, getNodesSearched() );
+        }
 
         // Keep the score
         result = g;
     } while( lower < upper );
 
+    if( parallelProbes ) {
+        endParallelProbes();
+    }
+
     return result;
 }
 
@@ -647,6 +704,9 @@ int Engine::initializeSearch( const Position & pos, int initial_score, RootMoveL
 {
     int i;
 
+    // Apply changes to the size of tables requested since the last search
+    updateTableSizes();
+
     // Reset search tables
     MoveHandler::resetKillerTable();
     MoveHandler::resetHistoryTable();
@@ -658,7 +718,8 @@ int Engine::initializeSearch( const Position & pos, int initial_score, RootMoveL
 
     // Lookup the position in the hash table: that will suggest which move to consider first
     Move hashMove = Move::Null;
-    HashTable::Entry * entry = getHashTable()->probe( pos );
+    HashTable::Entry   item;
+    HashTable::Entry * entry = getHashTable()->probe( pos, item );
 
     if( entry !=  0 ) {
         Move m = entry->getMove();
@@ -765,6 +826,9 @@ int Engine::searchPosition( Position & pos, int initial_score, int maxdepth )
 
     int f = initial_score;
 
+    // Let the helper threads (if any) search along with us
+    startHelperThreads( pos, moveList, f, maxdepth );
+
     // Start searching...
     for( int depth=3; depth <= maxdepth; depth++ ) {
         int i;
@@ -780,6 +844,9 @@ int Engine::searchPosition( Position & pos, int initial_score, int maxdepth )
         if( searchMustBeInterrupted ) {
             Log::write( "  s: interrupted!\n" );
 
+            // Make sure the helper threads do not touch the hash table anymore
+            stopHelperThreads();
+
 #if 1
             /*
                 Perform a cleanup of the hash table, removing all PV's related
@@ -803,7 +870,8 @@ int Engine::searchPosition( Position & pos, int initial_score, int maxdepth )
                 p.doMove( moveList.moves[i].move );
 
                 while( true ) {
-                    HashTable::Entry * entry = hashTable->probe(p);
+                    HashTable::Entry   item;
+                    HashTable::Entry * entry = hashTable->probe( p, item );
 
                     if( entry == 0 )
                         break;
@@ -880,6 +948,8 @@ int Engine::searchPosition( Position & pos, int initial_score, int maxdepth )
             break;
     }
 
+    stopHelperThreads();
+
     return f;
 }
 
@@ -898,10 +968,14 @@ int Engine::negaMaxMT_AtRoot( Position & pos, int gamma, int depth, RootMoveList
     UndoInfo    undoInfo( pos );
 
     // Search all valid moves at the current depth
-    rootMoveStat.reset();
+    bool        isMainThread = (searchThreadId == 0);
+
+    if( isMainThread ) {
+        rootMoveStat.reset();
 
-    rootMoveStat.moves_total = moveList.count;
-    rootMoveStat.depth = depth / FullPlyDepth;
+        rootMoveStat.moves_total = moveList.count;
+        rootMoveStat.depth = depth / FullPlyDepth;
+    }
 
     for( int j=0; j<moveList.count; j++ ) {
         totalNodes += moveList.moves[j].nodes;
@@ -910,12 +984,18 @@ int Engine::negaMaxMT_AtRoot( Position & pos, int gamma, int depth, RootMoveList
     for( int i=0; i<moveList.count; i++ ) {
         Move move = moveList.moves[i].move;
 
-        rootMoveStat.moves_remaining = moveList.count - 1 - i;
-        rootMoveStat.current_move = move;
+        if( isMainThread ) {
+            rootMoveStat.moves_remaining = moveList.count - 1 - i;
+            rootMoveStat.current_move = move;
+        }
 
         // Play move and search it
         pos.doMove( move );
 
+        if( haveTablePrefetch ) {
+            prefetchTables( pos );
+        }
+
         unsigned nodes = Counters::callsToEvaluation + Counters::posSearched;
 
         int s = -negaMaxMT( pos, 1-gamma, depth-FullPlyDepth, 1 );
@@ -957,7 +1037,7 @@ int Engine::negaMaxMT_AtRoot( Position & pos, int gamma, int depth, RootMoveList
     }
 
     // If a move caused a fail high (or we don't have any move), bring it to the top
-    if( failedHigh || (gameMoveToPlay.pvlen == 0) ) {
+    if( failedHigh || (isMainThread && gameMoveToPlay.pvlen == 0) ) {
         int bestIndex = 0;
 
         while( moveList.moves[ bestIndex ].move != bestMove ) {
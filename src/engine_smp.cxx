@@ -0,0 +1,450 @@
+/*
+    Kiwi
+    Parallel search
+
+    Copyright (c) 1999-2004,2005 Alessandro Scotti
+    http://www.ascotti.org/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include <assert.h>
+#include <string.h>
+
+#include "counters.h"
+#include "engine.h"
+#include "log.h"
+#include "movehandler.h"
+#include "score.h"
+
+/*
+    The parallel search is a "lazy" SMP: helper threads run their own iterative
+    deepening on the root position, with no synchronization at all except for
+    the main hash table, which is shared by all threads. Helpers fill the hash table
+    with useful information for the main thread, which is the only one that
+    manages time, input and the move to play.
+
+    To make threads diverge a bit, odd helpers start from a deeper iteration.
+
+    Optionally (see mtdProbeSpread), helpers can work for the main thread instead:
+    at each iteration they fire null-window probes spread around the current MTD(f)
+    guess, and all probes (including those of the main thread) narrow a shared
+    [lower, upper] window as soon as they complete.
+*/
+
+extern THREAD_LOCAL int nodesUntilInputCheck;
+extern THREAD_LOCAL int maxSearchPly;
+
+extern void clearHistTable();
+
+struct HelperThread
+{
+    void *          handle;
+    int             id;
+    PawnHashTable * pawnHashTable;
+    unsigned        pawnHashTableSize;
+    EvalCache *     evalCache;
+    unsigned        evalCacheSize;
+    QuiesceHashTable * quiesceHashTable;
+    Position *      positionStack;
+    Position        root;
+    RootMoveList    moves;
+    int             score;
+    int             maxDepth;
+    const void *    history;    // Search path of the main thread
+    volatile unsigned nodes;    // Nodes searched (updated every now and then)
+};
+
+static HelperThread helperThreads[ Engine::MaxSearchThreads ];
+static int          numOfHelperThreads = 0;    // Threads started by the last search
+
+// Shared MTD(f) window for parallel probes
+struct ProbeWindow
+{
+    int         iteration;  // Incremented at each iteration, used to discard stale results
+    bool        active;     // True while the main thread is in the iteration
+    int         depth;
+    int         fractDepth;
+    int         lower;
+    int         upper;
+    int         guess;      // Latest score found
+    Move        lowerMove;  // Move that established the lower bound
+};
+
+static ProbeWindow  probeWindow;
+static void *       probeLock = 0;
+static void *       probeCondition = 0;    // Signaled when the window changes (or helpers must stop)
+
+void Engine::helperThreadMain( void * param )
+{
+    HelperThread * helper = (HelperThread *) param;
+
+    searchThreadId = helper->id;
+    pawnHashTable = helper->pawnHashTable;
+    evalCache = helper->evalCache;
+    quiesceHashTable = helper->quiesceHashTable;
+    positionStack = helper->positionStack;
+
+    // Reset search tables (they are local to this thread)
+    MoveHandler::resetKillerTable();
+    MoveHandler::resetHistoryTable();
+
+    clearHistTable();
+
+    Counters::reset();
+
+    nodesUntilInputCheck = NodesBetweenInputChecks;
+
+    // Get a copy of the game history for detecting repetitions
+    memcpy( rep3History, helper->history, (gameHistoryIdx + 1) * sizeof(Rep3Info) );
+
+    if( mtdProbeSpread != 0 ) {
+        helperProbeLoop( helper );
+        updateHelperNodes();
+        return;
+    }
+
+    // Search
+    int f = helper->score;
+
+    for( int depth = 3 + (helper->id & 1); depth <= helper->maxDepth; depth++ ) {
+        int score = searchMTDf( helper->root, f, depth, helper->moves );
+
+        if( searchMustBeInterrupted ) {
+            break;
+        }
+
+        f = score;
+    }
+
+    updateHelperNodes();
+}
+
+void Engine::helperProbeLoop( void * param )
+{
+    HelperThread * helper = (HelperThread *) param;
+
+    int lastIteration = 0;
+    int lastGamma = 0;
+
+    int offset = ((helper->id + 1) / 2) * mtdProbeSpread;
+
+    while( true ) {
+        // Pick a window to probe: helpers alternate above and below the current guess
+        int iteration = 0;
+        int depth = 0;
+        int fractDepth = 0;
+        int gamma = 0;
+
+        System::acquireLock( probeLock );
+
+        while( ! searchMustBeInterrupted ) {
+            iteration = probeWindow.iteration;
+            depth = probeWindow.depth;
+            fractDepth = probeWindow.fractDepth;
+            gamma = probeWindow.guess + ((helper->id & 1) ? +offset : -offset);
+
+            if( gamma <= probeWindow.lower ) {
+                gamma = probeWindow.lower + 1;
+            }
+            else if( gamma > probeWindow.upper ) {
+                gamma = probeWindow.upper;
+            }
+
+            // Do not probe the same window twice, sleep until it changes instead
+            if( probeWindow.active && (probeWindow.lower < probeWindow.upper) && (iteration != lastIteration || gamma != lastGamma) ) {
+                break;
+            }
+
+            System::waitCondition( probeCondition, probeLock );
+        }
+
+        System::releaseLock( probeLock );
+
+        if( searchMustBeInterrupted ) {
+            break;
+        }
+
+        lastIteration = iteration;
+        lastGamma = gamma;
+
+        // Probe
+        maxSearchPly = maxSearchDepthFactor*depth;
+
+        if( maxSearchPly > MaxSearchPly ) {
+            maxSearchPly = MaxSearchPly;
+        }
+
+        int g = negaMaxMT_AtRoot( helper->root, gamma, fractDepth, helper->moves );
+
+        if( searchMustBeInterrupted ) {
+            break;
+        }
+
+        // Update the window, unless the main thread has moved on already
+        System::acquireLock( probeLock );
+
+        if( probeWindow.iteration == iteration ) {
+            if( g < gamma ) {
+                if( g < probeWindow.upper ) {
+                    probeWindow.upper = g;
+                }
+            }
+            else if( g > probeWindow.lower ) {
+                probeWindow.lower = g;
+                probeWindow.lowerMove = helper->moves.moves[0].move;
+            }
+
+            probeWindow.guess = g;
+
+            System::signalCondition( probeCondition );
+        }
+
+        System::releaseLock( probeLock );
+
+        updateHelperNodes();
+    }
+}
+
+void Engine::beginParallelProbes( int depth, int fractDepth, int f )
+{
+    System::acquireLock( probeLock );
+
+    probeWindow.iteration++;
+    probeWindow.active = true;
+    probeWindow.depth = depth;
+    probeWindow.fractDepth = fractDepth;
+    probeWindow.lower = Score::Min;
+    probeWindow.upper = Score::Max;
+    probeWindow.guess = f;
+    probeWindow.lowerMove = Move::Null;
+
+    System::signalCondition( probeCondition );
+
+    System::releaseLock( probeLock );
+}
+
+void Engine::endParallelProbes()
+{
+    System::acquireLock( probeLock );
+
+    probeWindow.active = false;
+
+    System::releaseLock( probeLock );
+}
+
+/*
+    Merges the result of a probe made by the main thread with those of the
+    helpers, and returns the updated bounds. If a helper has established the
+    lower bound, its move is brought to the top of the move list.
+*/
+void Engine::mergeParallelProbes( int gamma, int g, RootMoveList & moves, int & lower, int & upper )
+{
+    System::acquireLock( probeLock );
+
+    if( g < gamma ) {
+        if( g < probeWindow.upper ) {
+            probeWindow.upper = g;
+        }
+    }
+    else if( g > probeWindow.lower ) {
+        probeWindow.lower = g;
+        probeWindow.lowerMove = moves.moves[0].move;
+    }
+
+    probeWindow.guess = g;
+
+    // Note: with search instability bounds may cross, in that case the lower
+    // bound wins because it comes with a move
+    lower = probeWindow.lower;
+    upper = probeWindow.upper;
+
+    if( upper < lower ) {
+        upper = lower;
+    }
+
+    Move best = probeWindow.lowerMove;
+
+    System::signalCondition( probeCondition );
+
+    System::releaseLock( probeLock );
+
+    if( best != Move::Null && moves.moves[0].move != best ) {
+        int i = 1;
+
+        while( i < moves.count && moves.moves[i].move != best ) {
+            i++;
+        }
+
+        if( i < moves.count ) {
+            RootMove temp = moves.moves[i];
+
+            while( i > 0 ) {
+                moves.moves[i] = moves.moves[i-1];
+                i--;
+            }
+
+            moves.moves[0] = temp;
+        }
+    }
+}
+
+void Engine::startHelperThreads( const Position & pos, const RootMoveList & moves, int f, int maxdepth )
+{
+    unsigned pawnHashTableSize = getPawnHashTableEntries();
+    unsigned evalCacheSize = getEvalCacheEntries();
+
+    numOfHelperThreads = 0;
+
+    if( probeLock == 0 ) {
+        probeLock = System::createLock();
+        probeCondition = System::createCondition();
+    }
+
+    probeWindow.active = false;
+
+    for( int i=1; i<numOfSearchThreads; i++ ) {
+        HelperThread * helper = &helperThreads[i];
+
+        // Each thread has its own pawn hash table
+        if( helper->pawnHashTable == 0 || helper->pawnHashTableSize != pawnHashTableSize ) {
+            delete helper->pawnHashTable;
+
+            helper->pawnHashTable = new PawnHashTable( pawnHashTableSize );
+            helper->pawnHashTableSize = pawnHashTableSize;
+        }
+
+        // ...and eval cache
+        if( helper->evalCache == 0 || helper->evalCacheSize != evalCacheSize ) {
+            delete helper->evalCache;
+
+            helper->evalCache = new EvalCache( evalCacheSize );
+            helper->evalCacheSize = evalCacheSize;
+        }
+
+        if( helper->quiesceHashTable == 0 ) {
+            helper->quiesceHashTable = new QuiesceHashTable( QuiesceHashTableSize );
+        }
+
+        if( helper->positionStack == 0 ) {
+            helper->positionStack = new Position[ PositionStackSize ];
+        }
+
+        helper->id = i;
+        helper->root = pos;
+        helper->moves = moves;
+        helper->score = f;
+        helper->maxDepth = maxdepth;
+        helper->history = rep3History;
+        helper->nodes = 0;
+        helper->handle = System::startThread( helperThreadMain, helper );
+
+        if( helper->handle == 0 ) {
+            Log::write( "*** Warning: cannot start search thread %d\n", i );
+            break;
+        }
+
+        numOfHelperThreads = i;
+    }
+}
+
+void Engine::stopHelperThreads()
+{
+    bool interrupted = searchMustBeInterrupted;
+
+    joinHelperThreads();
+
+    searchMustBeInterrupted = interrupted;
+
+    if( probeLock != 0 ) {
+        System::destroyCondition( probeCondition );
+        System::destroyLock( probeLock );
+
+        probeCondition = 0;
+        probeLock = 0;
+    }
+}
+
+/*
+    Interrupts the search and waits for the helper threads to terminate, so that
+    the game position, history and tables they use can be changed safely. The main
+    thread (if searching) still has to unwind its search, so the probe window is
+    left in place until stopHelperThreads().
+*/
+void Engine::joinHelperThreads()
+{
+    // Wake up the helpers waiting for a probe window too (holding the lock, so that
+    // none of them can miss the signal)
+    if( probeLock != 0 ) {
+        System::acquireLock( probeLock );
+
+        searchMustBeInterrupted = true;
+
+        System::signalCondition( probeCondition );
+
+        System::releaseLock( probeLock );
+    }
+
+    searchMustBeInterrupted = true;
+
+    for( int i=1; i<=numOfHelperThreads; i++ ) {
+        if( helperThreads[i].handle != 0 ) {
+            System::waitThread( helperThreads[i].handle );
+
+            helperThreads[i].handle = 0;
+        }
+    }
+}
+
+/*
+    Clears the tables owned by the helper threads, which are kept from one
+    search to the next. Must not be called while the helpers are running (see
+    joinHelperThreads()).
+*/
+void Engine::clearHelperTables()
+{
+    for( int i=1; i<MaxSearchThreads; i++ ) {
+        HelperThread * helper = &helperThreads[i];
+
+        assert( helper->handle == 0 );
+
+        if( helper->pawnHashTable != 0 ) {
+            helper->pawnHashTable->reset();
+        }
+
+        if( helper->evalCache != 0 ) {
+            helper->evalCache->reset();
+        }
+
+        if( helper->quiesceHashTable != 0 ) {
+            helper->quiesceHashTable->reset();
+        }
+    }
+}
+
+void Engine::updateHelperNodes()
+{
+    helperThreads[ searchThreadId ].nodes = Counters::posSearched;
+}
+
+unsigned Engine::getNodesSearched()
+{
+    unsigned result = Counters::posSearched;
+
+    for( int i=1; i<=numOfHelperThreads; i++ ) {
+        result += helperThreads[i].nodes;
+    }
+
+    return result;
+}
@@ -0,0 +1,106 @@
+/*
+    Kiwi
+    Copyright (c) 1999-2004,2005 Alessandro Scotti
+    http://www.ascotti.org/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "counters.h"
+#include "evalcache.h"
+#include "log.h"
+#include "system.h"
+
+EvalCache::EvalCache( unsigned n )
+{
+    // Make sure the number of entries is a power of two, with at least one bucket
+    while( (n & (n-1)) != 0 ) {
+        n &= n-1;
+    }
+
+    if( n < BucketSize ) {
+        n = BucketSize;
+    }
+
+    const char * backing;
+
+    size_t bytes = n*sizeof(Uint64);
+
+    table = (Uint64 *) System::allocateLargestBlock( bytes, BucketSize*sizeof(Uint64), &backing );
+
+    if( table == 0 ) {
+        Log::write( "*** Fatal: cannot allocate eval cache\n" );
+        exit( 1 );
+    }
+
+    if( bytes < n*sizeof(Uint64) ) {
+        Log::write( "*** Warning: not enough memory for %uK eval cache entries\n", n >> 10 );
+    }
+
+    size = (unsigned) (bytes / sizeof(Uint64));
+    mask = size / BucketSize - 1;
+
+    Log::write( "Eval cache: %uK entries, %uK allocated with %s\n", size >> 10, (unsigned) ((size*sizeof(Uint64)) >> 10), backing );
+}
+
+EvalCache::~EvalCache()
+{
+    System::freeLargeBlock( table, size*sizeof(Uint64) );
+}
+
+void EvalCache::reset()
+{
+    memset( table, 0, size * sizeof(Uint64) );
+}
+
+bool EvalCache::probe( const Position & pos, int & eval ) const
+{
+    Counters::evalCacheProbes++;
+
+    const Uint64 * bucket = getBucket( pos );
+
+    for( int i=0; i<BucketSize; i++ ) {
+        if( ((bucket[i] ^ pos.hashCode.data) & ~(Uint64) EvalMask) == 0 ) {
+            eval = (short) (bucket[i] & EvalMask);
+            return true;
+        }
+    }
+
+    Counters::evalCacheProbesFailed++;
+
+    return false;
+}
+
+void EvalCache::store( const Position & pos, int eval )
+{
+    Uint64 * bucket = getBucket( pos );
+
+    // Replace the entry of the same position if any, or else the oldest,
+    // then move the new entry to the front
+    int i = 0;
+
+    while( i < BucketSize-1 && ((bucket[i] ^ pos.hashCode.data) & ~(Uint64) EvalMask) != 0 ) {
+        i++;
+    }
+
+    while( i > 0 ) {
+        bucket[i] = bucket[i-1];
+        i--;
+    }
+
+    bucket[0] = (pos.hashCode.data & ~(Uint64) EvalMask) | ((Uint64) eval & EvalMask);
+}
@@ -0,0 +1,77 @@
+/*
+    Kiwi
+    Copyright (c) 1999-2004,2005 Alessandro Scotti
+    http://www.ascotti.org/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#ifndef EVALCACHE_H_
+#define EVALCACHE_H_
+
+#include "platform.h"
+#include "position.h"
+
+/*
+    Cache of static evaluations, one per search thread.
+
+    Each entry is a single 64-bit word: the evaluation takes the low 16 bits and
+    the rest of the hash code is kept for verification. The dropped bits are part
+    of the bucket index, so for tables of 2M and more the full hash code is checked.
+
+    Entries are grouped in buckets of four (32 bytes, half a cache line), with
+    the most recent entry first.
+*/
+class EvalCache
+{
+public:
+    EvalCache( unsigned n );
+
+    ~EvalCache();
+
+    void    reset();
+
+    bool    probe( const Position & pos, int & eval ) const;
+
+    void    store( const Position & pos, int eval );
+
+    unsigned getSize() const {
+        return size;
+    }
+
+    // Starts loading the bucket for the specified position into the cache
+    void    prefetch( const Position & pos ) const {
+        PREFETCH( getBucket( pos ) );
+    }
+
+private:
+    enum {
+        BucketSize  = 4,
+        EvalMask    = 0xFFFF
+    };
+
+    // Unimplemented methods
+    EvalCache( const EvalCache & );
+    EvalCache & operator = ( const EvalCache & );
+
+    Uint64 *    getBucket( const Position & pos ) const {
+        return table + (pos.hashCode.toUnsigned() & mask) * BucketSize;
+    }
+
+    Uint64 *    table;
+    unsigned    size;   // Size of table (number of entries)
+    unsigned    mask;   // Number of buckets minus one
+};
+
+#endif // EVALCACHE_H_
@@ -19,17 +19,21 @@
 */
 #include <assert.h>
 #include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "counters.h"
+#include "engine.h"
 #include "hash.h"
 #include "log.h"
 #include "position.h"
 #include "score.h"
+#include "system.h"
 
-#define HASH_ENTRY( pos )   table + (pos.hashCode.toUnsigned() & mask)
+#define HASH_ENTRY( pos )   table + (pos.hashCode.data & mask)
 
-HashTable::HashTable( unsigned n )
+HashTable::HashTable( Uint64 n )
 {
     assert( (n & (n-1)) == 0 );     // Make sure size is a power of two
 
@@ -38,23 +42,231 @@ HashTable::HashTable( unsigned n )
     printf( "There are %d entries in the hash table\n", n );
 #endif
 
-    size = n;
-    mask = n-1;
-    mask &= ~3; // Store four positions per entry, so there is one fourth of all entries
     search_id = 0;
-    table = new Entry[ size ];
+    clear_id = 0;
+    used = false;   // Memory from allocateLargeBlock() is already zero
+
+    // Buckets are 64 bytes long (four standard or eight compact entries), the allocated
+    // block is aligned so that each of them fits in a cache line
+    const char * backing;
+
+    size_t bytes = (size_t) (n*sizeof(Entry));
+
+    table = (Entry *) System::allocateLargestBlock( bytes, EntriesPerBucket*sizeof(Entry), &backing );
+
+    if( table == 0 ) {
+        Log::write( "*** Fatal: cannot allocate hash table\n" );
+        exit( 1 );
+    }
+
+    if( bytes < n*sizeof(Entry) ) {
+        Log::write( "*** Warning: not enough memory for %uK hash entries\n", (unsigned) (n >> 10) );
+    }
+
+    size = bytes / sizeof(Entry);
+    mask = size-1;
+    mask &= ~(Uint64)(EntriesPerBucket-1); // Store several positions per bucket
+
+    Log::write( "Hash table: %uK entries, %uM allocated with %s\n", (unsigned) (size >> 10), (unsigned) ((size*sizeof(Entry)) >> 20), backing );
 }
 
 HashTable::~HashTable()
 {
-    delete [] table;
+    System::freeLargeBlock( table, size*sizeof(Entry) );
 }
 
-void HashTable::reset()
+/*
+    Clearing a table of several gigabytes takes seconds, so it is split into
+    slices that are zeroed in parallel.
+*/
+struct ClearSlice
 {
-    memset( table, 0, sizeof(Entry)*size );
+    char *  start;
+    size_t  size;
+    void *  handle;
+};
+
+static void clearSliceThread( void * param )
+{
+    ClearSlice * slice = (ClearSlice *) param;
+
+    memset( slice->start, 0, slice->size );
+}
+
+static void clearBlock( void * block, Uint64 size, int numOfThreads )
+{
+    enum {
+        MaxClearThreads     = 64,
+        MinSliceSize        = 16*1024*1024  // Not worth starting a thread for less than this
+    };
+
+    static ClearSlice slices[ MaxClearThreads ];
+
+    if( numOfThreads > MaxClearThreads ) {
+        numOfThreads = MaxClearThreads;
+    }
+
+    while( numOfThreads > 1 && size / numOfThreads < MinSliceSize ) {
+        numOfThreads--;
+    }
+
+    if( numOfThreads <= 1 ) {
+        memset( block, 0, (size_t) size );
+        return;
+    }
+
+    // Slices are a multiple of 4K, so threads do not share pages (the last one takes the rest)
+    Uint64 sliceSize = (size / numOfThreads) & ~(Uint64)4095;
+
+    int i;
+
+    for( i=0; i<numOfThreads; i++ ) {
+        slices[i].start = (char *) block + i*sliceSize;
+        slices[i].size = (size_t) (i == numOfThreads-1 ? size - i*sliceSize : sliceSize);
+        slices[i].handle = i > 0 ? System::startThread( clearSliceThread, &slices[i] ) : 0;
+    }
+
+    // The calling thread does the first slice, and those of threads that could not be started
+    for( i=0; i<numOfThreads; i++ ) {
+        if( slices[i].handle == 0 ) {
+            clearSliceThread( &slices[i] );
+        }
+    }
+
+    for( i=1; i<numOfThreads; i++ ) {
+        if( slices[i].handle != 0 ) {
+            System::waitThread( slices[i].handle );
+        }
+    }
+}
+
+void HashTable::reset( int numOfThreads )
+{
+    if( used ) {
+        clearBlock( table, sizeof(Entry)*size, numOfThreads );
+
+        used = false;
+    }
+
+    clear_id = search_id;
+}
+
+void HashTable::bumpSearchId( int numOfThreads )
+{
+    search_id = (search_id + Entry::SearchIdIncrement) & Entry::SearchIdMask;
+
+    if( search_id == clear_id ) {
+        reset( numOfThreads );
+    }
+}
+
+bool HashTable::resize( Uint64 n )
+{
+    assert( (n & (n-1)) == 0 );
+
+    if( n == size ) {
+        return true;
+    }
+
+    const char * backing;
+
+    Entry * newTable = (Entry *) System::allocateLargeBlock( n*sizeof(Entry), &backing );
+
+    if( newTable == 0 ) {
+        Log::write( "*** Warning: cannot resize hash table to %uK entries\n", (unsigned) (n >> 10) );
+        return false;
+    }
+
+    Entry * oldTable = table;
+    Uint64  oldSize = size;
+
+    table = newTable;
+    size = n;
+    mask = (n-1) & ~(Uint64)(EntriesPerBucket-1);
+
+    // Move the old entries, without clearing the new table (it's already zero)
+    if( used ) {
+        for( Uint64 b=0; b<oldSize; b += EntriesPerBucket ) {
+            for( int i=0; i<EntriesPerBucket; i++ ) {
+                const Entry & item = oldTable[b+i];
+
+                if( item.isEmpty() ) {
+                    continue;
+                }
 
-    memset( evalCache, 0, sizeof(evalCache) );
+#ifdef COMPACT_HASH
+                // Only the hash bits used for indexing are known, i.e. those of the old bucket
+                if( n > oldSize ) {
+                    break;
+                }
+
+                insertEntry( item, table + (b & mask) );
+#else
+                insertEntry( item, table + (item.getHashCode().data & mask) );
+#endif
+            }
+        }
+    }
+
+    System::freeLargeBlock( oldTable, oldSize*sizeof(Entry) );
+
+    Log::write( "Hash table resized: %uK entries, %uM allocated with %s\n", (unsigned) (size >> 10), (unsigned) ((size*sizeof(Entry)) >> 20), backing );
+
+    return true;
+}
+
+QuiesceHashTable::QuiesceHashTable( unsigned n )
+{
+    assert( (n & (n-1)) == 0 );
+
+    size_t bytes = n*sizeof(Entry);
+
+    table = (Entry *) System::allocateLargestBlock( bytes, sizeof(Entry) );
+
+    if( table == 0 ) {
+        Log::write( "*** Fatal: cannot allocate quiescence hash table\n" );
+        exit( 1 );
+    }
+
+    size = (unsigned) (bytes / sizeof(Entry));
+    mask = size-1;
+}
+
+QuiesceHashTable::~QuiesceHashTable()
+{
+    System::freeLargeBlock( table, size*sizeof(Entry) );
+}
+
+void QuiesceHashTable::reset()
+{
+    for( unsigned i=0; i<size; i++ ) {
+        table[i].code = 0;
+        table[i].value = 0;
+        table[i].flags = 0;
+    }
+}
+
+/*
+    Stores an entry into the specified bucket, replacing the first empty or least deep entry.
+*/
+void HashTable::insertEntry( const Entry & item, Entry * bucket )
+{
+    int index = 0;
+
+    for( int j=0; j<EntriesPerBucket; j++ ) {
+        if( bucket[j].isEmpty() ) {
+            index = j;
+            break;
+        }
+
+        if( bucket[j].getDepth() < bucket[index].getDepth() ) {
+            index = j;
+        }
+    }
+
+    if( bucket[index].getDepth() <= item.getDepth() ) {
+        bucket[index] = item;
+    }
 }
 
 #ifdef TEST_HASH
@@ -72,11 +284,11 @@ static void comp( const char * header, const BitBoard & b1, const BitBoard & b2
 
 #undef HASH_ENTRY
 
-#define HASH_ENTRY( pos )   table + ((pos.hashCode.toUnsigned() % size) & ~3);
+#define HASH_ENTRY( pos )   table + ((pos.hashCode.data % size) & ~(Uint64)3);
 
 #endif
 
-HashTable::Entry * HashTable::probe( const Position & pos ) const
+HashTable::Entry * HashTable::probe( const Position & pos, Entry & result ) const
 {
     Counters::hashProbes++;
 
@@ -84,29 +296,22 @@ HashTable::Entry * HashTable::probe( const Position & pos ) const
     pos.verifyHashCode();
 #endif
 
-    Entry * entry = HASH_ENTRY(pos);
+    Entry * slot = HASH_ENTRY(pos);
+    Entry * entry = 0;
 
-    if( entry->code == pos.hashCode ) {
+    // Note: the entry is copied before being checked, as another thread could
+    // be writing it at the same time
+    for( int i=0; i<EntriesPerBucket; i++ ) {
+        result = slot[i];
+
+        if( result.matches( pos.hashCode ) ) {
+            entry = &result;
+            break;
+        }
     }
-    else {
-        entry++; // Probe the second slot
-        if( entry->code == pos.hashCode ) {
-        }
-        else {
-            entry++; // Probe the third slot
-            if( entry->code == pos.hashCode ) {
-            }
-            else {
-            }
 
-            entry++; // Probe the fourth slot
-            if( entry->code == pos.hashCode ) {
-            }
-            else {
-                entry = 0;
-                Counters::hashProbesFailed++;
-            }
-        }
+    if( entry == 0 ) {
+        Counters::hashProbesFailed++;
     }
 
 #ifdef TEST_HASH
@@ -154,6 +359,11 @@ void HashTable::store( const Position & pos, const Move & move, int value, unsig
 {
     Counters::hashStores++;
 
+    // Note: test first to avoid writing (and sharing) the cache line at each store
+    if( ! used ) {
+        used = true;
+    }
+
 #ifdef TEST_HASH
     pos.verifyHashCode();
 #endif
@@ -167,10 +377,13 @@ void HashTable::store( const Position & pos, const Move & move, int value, unsig
         3) entries with a smaller search depth.
     */
     int index = 0;
+    bool found = false;
 
-    for( int i=0; i<4; i++ ) {
-        if( entry[i].code == pos.hashCode ) {
+    for( int i=0; i<EntriesPerBucket; i++ ) {
+        if( entry[i].matches( pos.hashCode ) ) {
             // Position is already in the table
+            index = i;
+            found = true;
 
             /*
             if( entry[i].getSearchId() == search_id && entry->getDepth() > depth ) {
@@ -192,11 +405,31 @@ void HashTable::store( const Position & pos, const Move & move, int value, unsig
                 index = i;
             }
         }
+    }
+
+    // Keep track of which rule has been used
+    if( found ) {
+        Counters::hashStoresSamePosition++;
+    }
+    else if( entry[index].isEmpty() ) {
+        Counters::hashStoresEmpty++;
+    }
+    else if( entry[index].getSearchId() != search_id ) {
+        Counters::hashStoresOlderSearch++;
+    }
+    else {
+        Counters::hashStoresLessDeep++;
     }
 
-    entry[index].packData1( move, flags, search_id );
-    entry[index].packData2( value, depth );
-    entry[index].code = pos.hashCode;
+    // Write the whole entry at once (in the standard layout, the hash code is xor'ed with the data)
+    Entry item;
+
+    item.reset();
+    item.packData1( move, flags, search_id );
+    item.packData2( value, depth );
+    item.setHashCode( pos.hashCode );
+
+    entry[index] = item;
 
 #ifdef TEST_HASH
     entry[index].whitePieces = pos.whitePieces;
@@ -218,8 +451,278 @@ void HashTable::clean( const Position & pos )
 {
     Entry * entry = HASH_ENTRY(pos);
 
-    entry[0].reset();
-    entry[1].reset();
-    entry[2].reset();
-    entry[3].reset();
+    for( int i=0; i<EntriesPerBucket; i++ ) {
+        entry[i].reset();
+    }
+}
+
+unsigned HashTable::getHashFull() const
+{
+    // Sample the first entries only, like most engines do
+    Uint64 samples = size < 1000 ? size : 1000;
+    Uint64 used = 0;
+
+    for( Uint64 i=0; i<samples; i++ ) {
+        if( ! table[i].isEmpty() && table[i].getSearchId() == search_id ) {
+            used++;
+        }
+    }
+
+    return samples > 0 ? (unsigned) ((used * 1000) / samples) : 0;
+}
+
+void HashTable::dumpStats() const
+{
+    enum {
+        MaxSampledBuckets   = 16*1024,
+        MaxAge              = Entry::SearchIdMask / Entry::SearchIdIncrement,
+        MaxDepth            = 32    // Plies, deeper entries are counted together
+    };
+
+    unsigned ages[ MaxAge+1 ];
+    unsigned depths[ MaxDepth+1 ];
+    unsigned samples = 0;
+    unsigned used = 0;
+
+    memset( ages, 0, sizeof(ages) );
+    memset( depths, 0, sizeof(depths) );
+
+    // Sample whole buckets evenly spread over the table, as not all slots in a bucket are used the same way
+    Uint64 buckets = size / EntriesPerBucket;
+    Uint64 step = buckets > MaxSampledBuckets ? buckets / MaxSampledBuckets : 1;
+
+    for( Uint64 b=0; b<buckets; b += step ) {
+        const Entry * bucket = table + b*EntriesPerBucket;
+
+        for( int i=0; i<EntriesPerBucket; i++ ) {
+            Entry item = bucket[i];
+
+            samples++;
+
+            if( item.isEmpty() ) {
+                continue;
+            }
+
+            used++;
+
+            ages[ ((search_id - item.getSearchId()) & Entry::SearchIdMask) / Entry::SearchIdIncrement ]++;
+
+            int depth = item.getDepth() / Engine::FullPlyDepth;
+
+            depths[ depth < MaxDepth ? depth : MaxDepth ]++;
+        }
+    }
+
+    if( samples == 0 ) {
+        return;
+    }
+
+    Log::write( "Hash table statistics\n" );
+    Log::write( "---------------------\n" );
+    Log::write( "Entries used     : %u / %u sampled (%05.2f%%), hashfull %u\n", used, samples, (used * 100.0) / samples, getHashFull() );
+
+    if( Counters::hashProbes > 0 ) {
+        unsigned hits = Counters::hashProbes - Counters::hashProbesFailed;
+
+        Log::write( "Probes           : %u, hits %u (%05.2f%%)\n", Counters::hashProbes, hits, (hits * 100.0) / Counters::hashProbes );
+    }
+
+    if( Counters::hashStores > 0 ) {
+        double n = Counters::hashStores / 100.0;
+
+        Log::write( "Stores           : %u\n", Counters::hashStores );
+        Log::write( "  same position  : %u (%05.2f%%)\n", Counters::hashStoresSamePosition, Counters::hashStoresSamePosition / n );
+        Log::write( "  empty entry    : %u (%05.2f%%)\n", Counters::hashStoresEmpty, Counters::hashStoresEmpty / n );
+        Log::write( "  older search   : %u (%05.2f%%)\n", Counters::hashStoresOlderSearch, Counters::hashStoresOlderSearch / n );
+        Log::write( "  less deep      : %u (%05.2f%%)\n", Counters::hashStoresLessDeep, Counters::hashStoresLessDeep / n );
+    }
+
+    if( used > 0 ) {
+        int i;
+
+        for( i=0; i<=MaxAge; i++ ) {
+            if( ages[i] > 0 ) {
+                Log::write( "Age %2d           : %05.2f%%\n", i, (ages[i] * 100.0) / used );
+            }
+        }
+
+        for( i=0; i<=MaxDepth; i++ ) {
+            if( depths[i] > 0 ) {
+                Log::write( "Depth %2d%s        : %05.2f%%\n", i, i == MaxDepth ? "+" : " ", (depths[i] * 100.0) / used );
+            }
+        }
+    }
+}
+
+/*
+    Snapshots: a small header followed by the table entries, exactly as they
+    are kept in memory.
+*/
+struct HashTable::SnapshotHeader
+{
+    char        signature[8];
+    Uint32      version;
+    Uint32      sizeOfEntry;
+    Uint64      size;       // Number of entries
+    Uint32      search_id;
+    Uint32      reserved;
+};
+
+static const char   SnapshotSignature[8] = { 'K', 'i', 'w', 'i', 'H', 'a', 's', 'h' };
+static const Uint32 SnapshotVersion = 1;
+
+int HashTable::backup( const char * name ) const
+{
+    FILE * f = fopen( name, "wb" );
+
+    if( f == 0 ) {
+        return -1;
+    }
+
+    SnapshotHeader header;
+
+    memset( &header, 0, sizeof(header) );
+    memcpy( header.signature, SnapshotSignature, sizeof(header.signature) );
+
+    header.version = SnapshotVersion;
+    header.sizeOfEntry = sizeof(Entry);
+    header.size = size;
+    header.search_id = search_id;
+
+    int result = 0;
+
+    if( fwrite( &header, sizeof(header), 1, f ) != 1 ) {
+        result = -2;
+    }
+    else if( fwrite( table, sizeof(Entry), (size_t) size, f ) != (size_t) size ) {
+        result = -2;
+    }
+
+    if( fclose( f ) != 0 ) {
+        result = -2;
+    }
+
+    return result;
+}
+
+/*
+    Stores entries from a snapshot of a different size, where they usually
+    end up in another bucket.
+
+    Note: compact entries do not store the whole hash code, so they cannot be moved
+    to a table of a different size (restore() refuses such snapshots).
+*/
+void HashTable::restoreEntries( const Entry * entries, Uint64 count )
+{
+#ifndef COMPACT_HASH
+    for( Uint64 i=0; i<count; i++ ) {
+        const Entry & item = entries[i];
+
+        if( item.isEmpty() ) {
+            continue;
+        }
+
+        insertEntry( item, table + (item.getHashCode().data & mask) );
+    }
+#endif
+}
+
+int HashTable::restore( const char * name )
+{
+    SnapshotHeader header;
+
+    // Memory mapping avoids copying the whole file thru a buffer, but it is not
+    // available everywhere, so fall back to a regular read if needed
+    size_t length = 0;
+
+    const char * data = (const char *) System::mapFile( name, &length );
+
+    FILE * f = 0;
+
+    if( data != 0 ) {
+        if( length < sizeof(header) ) {
+            System::unmapFile( data, length );
+            return -2;
+        }
+
+        memcpy( &header, data, sizeof(header) );
+    }
+    else {
+        f = fopen( name, "rb" );
+
+        if( f == 0 ) {
+            return -1;
+        }
+
+        if( fread( &header, sizeof(header), 1, f ) != 1 ) {
+            fclose( f );
+            return -2;
+        }
+    }
+
+    int result = 0;
+
+    if( memcmp( header.signature, SnapshotSignature, sizeof(header.signature) ) != 0 ||
+        header.version != SnapshotVersion ||
+        header.sizeOfEntry != sizeof(Entry) )
+    {
+        result = -3;
+    }
+    else if( data != 0 && (length - sizeof(header)) / sizeof(Entry) < header.size ) {
+        result = -2;
+    }
+#ifdef COMPACT_HASH
+    else if( header.size != size ) {
+        result = -3;
+    }
+#endif
+    else {
+        // A snapshot of the same size overwrites the whole table, otherwise
+        // its entries are inserted into an empty one
+        if( header.size != size ) {
+            memset( (void *) table, 0, sizeof(Entry)*size );
+        }
+
+        used = true;
+        search_id = header.search_id;
+        clear_id = search_id;
+
+        if( data != 0 ) {
+            const Entry * entries = (const Entry *) (data + sizeof(header));
+
+            if( header.size == size ) {
+                memcpy( (void *) table, entries, sizeof(Entry)*size );
+            }
+            else {
+                restoreEntries( entries, header.size );
+            }
+        }
+        else if( header.size == size ) {
+            if( fread( table, sizeof(Entry), (size_t) size, f ) != (size_t) size ) {
+                result = -2;
+            }
+        }
+        else {
+            Entry buffer[ 1024 ];
+
+            for( Uint64 n=0; n<header.size; n += 1024 ) {
+                size_t count = fread( buffer, sizeof(Entry), 1024, f );
+
+                restoreEntries( buffer, count );
+
+                if( count < 1024 ) {
+                    break;
+                }
+            }
+        }
+    }
+
+    if( data != 0 ) {
+        System::unmapFile( data, length );
+    }
+    else {
+        fclose( f );
+    }
+
+    return result;
 }
@@ -22,11 +22,15 @@
 
 // #define TEST_HASH
 
+// Define COMPACT_HASH to use 8 byte entries (eight in a cache line) in the main hash table
+// #define COMPACT_HASH
+
 #include "bitboard.h"
 #include "counters.h"
 #include "move.h"
 #include "position.h"
 
+#ifndef COMPACT_HASH
 /*
     Bits    Bytes   Description
     ----    -----   -----------
@@ -38,12 +42,147 @@
      1      -       Value type (0=lo bound, 1=hi bound)
     16      2       Value
     16      2       Depth
-    64      8       Hash
+    64      8       Hash (xor'ed with the above)
+
+    The table can be accessed by several threads at the same time without locks:
+    the stored hash code is xor'ed with the entry data, so an entry that has been
+    mixed up by concurrent writers will not match the position anymore. For the
+    same reason, probe() returns a copy of the entry and not the entry itself.
+*/
+#else
+/*
+    Compact layout:
+
+    Bits    Description
+    ----    -----------
+    16      Move (from, to and promotion only, doMove() will fill in the rest)
+    16      Value
+     8      Depth (in quarters of ply, rounded down)
+     1      Value type (0=lo bound, 1=hi bound)
+     1      There is only one valid move in this position
+     1      Null move reported a mate threat
+     1      Exact bound
+     4      Age
+    16      Hash (upper bits)
+
+    Entries are read and written as a single 64-bit word, so there is no need
+    to validate them when the table is accessed concurrently. Since only 16 bits
+    of the hash are stored (plus the bits used for indexing) collisions are more
+    frequent than with the standard layout.
 */
+#endif
 
 class HashTable
 {
 public:
+#ifdef COMPACT_HASH
+    enum {
+        EntriesPerBucket    = 8,
+        DepthUnit           = 15    // A quarter of Engine::FullPlyDepth
+    };
+
+    struct Entry
+    {
+        friend class HashTable;
+
+        enum {
+            LowerBound = 0,
+            UpperBound          = 0x80000000,
+            SingleReply         = 0x40000000,
+            MateThreat          = 0x20000000,
+            ExactBound          = 0x10000000,
+            SearchIdIncrement   = 0x01000000,
+            SearchIdMask        = 0x0F000000,
+        };
+
+        // Constructor (empty)
+        Entry() {
+        }
+
+        // Destructor (empty)
+        ~Entry() {
+        }
+
+        // Data manipulation methods (flags and search id are kept in bits 40-47)
+        void packData1( const Move & move, unsigned flags, unsigned search_id ) {
+            data = (data & ~MK_U64(0x0000FF000000FFFF)) | move.toUint16() | ((Uint64)((flags | search_id) >> 24) << 40);
+        }
+
+        void packData2( int value, int depth ) {
+            depth /= DepthUnit;
+
+            if( depth > 0xFF ) {
+                depth = 0xFF;
+            }
+            else if( depth < 0 ) {
+                depth = 0;
+            }
+
+            data = (data & ~MK_U64(0x000000FFFFFF0000)) | ((Uint64)((unsigned)(value+0x8000) & 0xFFFF) << 16) | ((Uint64)depth << 32);
+        }
+
+        void setHashCode( const BitBoard & hashCode ) {
+            data = (data & MK_U64(0x0000FFFFFFFFFFFF)) | (hashCode.data & MK_U64(0xFFFF000000000000));
+        }
+
+        void reset() {
+            data = 0;
+        }
+
+        bool isEmpty() const {
+            return data == 0;
+        }
+
+        bool matches( const BitBoard & hashCode ) const {
+            return ((data ^ hashCode.data) & MK_U64(0xFFFF000000000000)) == 0;
+        }
+
+        // Access methods
+        unsigned isUpperBound() const {
+            return getFlags() & UpperBound;
+        }
+
+        unsigned hasSingleReply() const {
+            return getFlags() & SingleReply;
+        }
+
+        unsigned hasMateThreat() const {
+            return getFlags() & MateThreat;
+        }
+
+        int getValue() const {
+            return ((int)(data >> 16) & 0xFFFF)-0x8000;
+        }
+
+        int getDepth() const {
+            return (int)((data >> 32) & 0xFF) * DepthUnit;
+        }
+
+        // For PVS
+        int getBound() const {
+            return getFlags() & (UpperBound | ExactBound);
+        }
+
+        unsigned getSearchId() const {
+            return getFlags() & SearchIdMask;
+        }
+
+        Move getMove() const {
+            return Move( (unsigned)(data & 0xFFFF) );
+        }
+
+    private:
+        unsigned getFlags() const {
+            return (unsigned)((data >> 40) & 0xFF) << 24;
+        }
+
+        Uint64      data;
+    };
+#else
+    enum {
+        EntriesPerBucket    = 4
+    };
+
     struct Entry
     {
         friend class HashTable;
@@ -77,6 +216,26 @@ public:
 
         void reset() {
             code = 0;
+            data1 = 0;
+            data2 = 0;
+        }
+
+        bool isEmpty() const {
+            return data1 == 0 && data2 == 0;
+        }
+
+        // Must be called after the data has been set
+        void setHashCode( const BitBoard & hashCode ) {
+            code = hashCode ^ BitBoard( data1, data2 );
+        }
+
+        // Hash code of the position stored in the entry
+        BitBoard getHashCode() const {
+            return code ^ BitBoard( data1, data2 );
+        }
+
+        bool matches( const BitBoard & hashCode ) const {
+            return getHashCode() == hashCode;
         }
 
         // Access methods
@@ -133,52 +292,174 @@ public:
         int             sideToPlay;
 #endif
     };
+#endif // COMPACT_HASH
 
-    HashTable( unsigned n );
+    HashTable( Uint64 n );
 
     ~HashTable();
 
-    void    reset();
+    /**
+        Clears the table, with the specified number of threads each zeroing a slice of it.
+
+        Nothing is done if nothing has been stored since the table was allocated or
+        last cleared, so that a fresh table is only touched when it is actually used.
+    */
+    void    reset( int numOfThreads = 1 );
 
-    Entry * probe( const Position & pos ) const;
+    /**
+        Changes the number of entries in the table, and stores the old entries
+        into the new table (only if it is smaller in the compact layout).
+
+        Both tables are in memory while this happens: if there is not enough,
+        the table is left unchanged.
+
+        @return true if the table has been resized, false otherwise
+    */
+    bool    resize( Uint64 n );
+
+    /**
+        Looks up a position in the table.
+
+        @param  pos position to look for
+        @param  entry (out) copy of the entry found
+
+        @return a pointer to the entry parameter if found, zero otherwise
+    */
+    Entry * probe( const Position & pos, Entry & entry ) const;
 
     void    store( const Position & pos, const Move & move, int value, unsigned flags, int depth );
 
     void    clean( const Position & pos );
 
-    void    bumpSearchId() {
-        search_id = (search_id + Entry::SearchIdIncrement ) & Entry::SearchIdMask;
+    // Starts loading the bucket for the specified position into the cache
+    void    prefetch( const Position & pos ) const {
+        PREFETCH( table + (pos.hashCode.data & mask) );
     }
 
-    unsigned getSize() const {
+    /**
+        Makes all the entries in the table older than those stored from now on.
+
+        The search id only has a few bits, so when it gets back to the value it
+        had when the table was last cleared, entries of old searches would look
+        new again: the table is then cleared, with the specified number of threads.
+    */
+    void    bumpSearchId( int numOfThreads = 1 );
+
+    Uint64  getSize() const {
         return size;
     }
 
-    void    dumpStats();
+    /**
+        Returns an estimate of how much of the table is used by the current
+        search, in permille (as reported by the "hashfull" info of UCI).
+    */
+    unsigned getHashFull() const;
 
-    int backup( char * buf, unsigned len );
+    /**
+        Writes to the log some statistics about the table contents (sampled)
+        and the replacement rules used by store().
+    */
+    void    dumpStats() const;
 
-    int restore( char * buf, unsigned len );
+    /**
+        Saves a snapshot of the table to the specified file.
+
+        @return 0 on success, an error code otherwise
+    */
+    int backup( const char * name ) const;
+
+    /**
+        Loads a snapshot of the table from the specified file.
+
+        If the snapshot has the same size of the table it is loaded as is,
+        otherwise its entries are stored one by one (standard layout only).
+
+        @return 0 on success, an error code otherwise
+    */
+    int restore( const char * name );
 
 private:
     // Unimplemented methods
     HashTable( const HashTable & );
     HashTable & operator = ( const HashTable & );
 
+    struct SnapshotHeader;
+
+    void    restoreEntries( const Entry * entries, Uint64 count );
+
+    void    insertEntry( const Entry & item, Entry * bucket );
+
     Entry *     table;
-    unsigned    mask;
+    bool        used;   // True if the table may contain something
+    Uint64      mask;   // Note: indexing is 64-bit so the table can exceed 4G entries
     unsigned    search_id;
-    unsigned    size;   // Size of table (number of entries)
+    unsigned    clear_id;   // Search id when the table was last cleared
+    Uint64      size;   // Size of table (number of entries)
 };
 
-struct EvalItem
+/*
+    Small, always-replace table for quiescence search results. It is meant to
+    fit in the L2 cache and it is private to a search thread, so unlike the main
+    table it does not need to deal with concurrent access.
+*/
+class QuiesceHashTable
 {
-    Uint32 code;
-    int eval;
-};
+public:
+    struct Entry
+    {
+        BitBoard    code;
+        int         value;
+        unsigned    flags;  // HashTable::Entry::UpperBound or HashTable::Entry::LowerBound
 
-const int ItemsInEvalCache = 256*1024; // Must be power of 2
+        int getValue() const {
+            return value;
+        }
+
+        unsigned isUpperBound() const {
+            return flags & HashTable::Entry::UpperBound;
+        }
+    };
+
+    QuiesceHashTable( unsigned n );
+
+    ~QuiesceHashTable();
+
+    void    reset();
+
+    const Entry * probe( const Position & pos ) const {
+        Counters::quiesceHashProbes++;
+
+        const Entry * entry = table + (pos.hashCode.toUnsigned() & mask);
+
+        if( entry->code == pos.hashCode ) {
+            return entry;
+        }
+
+        Counters::quiesceHashProbesFailed++;
+
+        return 0;
+    }
+
+    void    store( const Position & pos, int value, unsigned flags ) {
+        Entry * entry = table + (pos.hashCode.toUnsigned() & mask);
+
+        entry->code = pos.hashCode;
+        entry->value = value;
+        entry->flags = flags;
+    }
+
+    unsigned getSize() const {
+        return size;
+    }
+
+private:
+    // Unimplemented methods
+    QuiesceHashTable( const QuiesceHashTable & );
+    QuiesceHashTable & operator = ( const QuiesceHashTable & );
+
+    Entry *     table;
+    unsigned    size;   // Size of table (number of entries)
+    unsigned    mask;
+};
 
-extern EvalItem evalCache[ ItemsInEvalCache ];
-
 #endif // HASH_H_
@@ -0,0 +1,192 @@
+/*
+    Kiwi
+    Copyright (c) 1999-2004,2005 Alessandro Scotti
+    http://www.ascotti.org/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include <stdio.h>
+
+#include "engine.h"
+#include "hash.h"
+#include "movelist.h"
+#include "position.h"
+#include "random.h"
+#include "system.h"
+
+/*
+    Stress test for concurrent access to the hash table.
+
+    Several threads play random games and store each position in a (very small)
+    shared table, with data that is computed from the position itself. The value
+    is a checksum of the move and depth, so every entry returned by probe() can be
+    checked on its own: with concurrent writers hitting the same buckets all the
+    time, an entry made of pieces from different writers would fail the checksum
+    and show up as an error.
+
+    An entry that passes the checksum but does not hold the data expected for the
+    position was written for another position with the same verification bits:
+    these false hits are caused by hash collisions, and are counted separately.
+
+    The table size is given in bytes, so that the standard and compact (see
+    COMPACT_HASH) layouts can be compared at equal memory.
+*/
+
+enum {
+    TestTableBytes      = 64*1024,  // Kept small to have lots of collisions
+    TestMaxThreads      = 64,
+    TestPositionsPerThread = 1000000,
+    TestMaxGamePlies    = 200
+};
+
+struct HashTestInfo
+{
+    HashTable * table;
+    int         id;
+    void *      handle;
+    unsigned    probes;
+    unsigned    hits;
+    unsigned    falseHits;
+    unsigned    errors;
+};
+
+// Data stored in the table is a function of the position only
+static Move getExpectedMove( MoveList & moves, const Position & pos )
+{
+    return moves.get( pos.hashCode.toUnsigned() % moves.count() );
+}
+
+static int getExpectedDepth( const Position & pos )
+{
+    // Whole plies, which both layouts store exactly
+    return (int)((pos.hashCode >> 16).toUnsigned() & 0x3F) * Engine::FullPlyDepth;
+}
+
+// The value is a checksum of the rest of the data
+static int getExpectedValue( const Move & move, int depth )
+{
+    unsigned x = (move.toUint16() * 0x9E3779B1U) ^ ((unsigned) depth * 0x85EBCA6BU);
+
+    return (int)((x >> 16) & 0x3FFF) - 0x2000;
+}
+
+static void hashTestThread( void * param )
+{
+    HashTestInfo *  info = (HashTestInfo *) param;
+    Random          random;
+    Position        pos;
+    MoveList        moves;
+    int             plies = 0;
+
+    // Make sure each thread plays different games
+    for( int i=0; i<info->id*1000; i++ ) {
+        random.get();
+    }
+
+    pos.setBoard( Position::startPosition );
+
+    for( int n=0; n<TestPositionsPerThread; n++ ) {
+        pos.generateValidMoves( moves );
+
+        if( moves.count() == 0 || plies >= TestMaxGamePlies ) {
+            pos.setBoard( Position::startPosition );
+            plies = 0;
+            continue;
+        }
+
+        Move move = getExpectedMove( moves, pos );
+        int depth = getExpectedDepth( pos );
+        int value = getExpectedValue( move, depth );
+
+        // Check what's in the table, then store our own data
+        HashTable::Entry   item;
+        HashTable::Entry * entry = info->table->probe( pos, item );
+
+        info->probes++;
+
+        if( entry != 0 ) {
+            info->hits++;
+
+            if( entry->getValue() != getExpectedValue( entry->getMove(), entry->getDepth() ) ) {
+                info->errors++;
+            }
+            else if( entry->getMove() != move || entry->getValue() != value || entry->getDepth() != depth ) {
+                info->falseHits++;
+            }
+        }
+
+        info->table->store( pos, move, value, 0, depth );
+
+        // Play a random move
+        Move next = moves.get( random.get() % moves.count() );
+
+        pos.doMove( next );
+
+        plies++;
+    }
+}
+
+void testHashTable( int numOfThreads )
+{
+    static HashTestInfo info[ TestMaxThreads ];
+
+    if( numOfThreads < 1 ) {
+        numOfThreads = 4;
+    }
+    else if( numOfThreads > TestMaxThreads ) {
+        numOfThreads = TestMaxThreads;
+    }
+
+    unsigned entries = TestTableBytes / sizeof(HashTable::Entry);
+
+    printf( "hashtest: %d threads, %d positions per thread, %u entries of %u bytes\n", numOfThreads, TestPositionsPerThread, entries, (unsigned) sizeof(HashTable::Entry) );
+
+    HashTable table( entries );
+
+    table.reset();
+
+    unsigned t = System::getTickCount();
+
+    int i;
+
+    for( i=0; i<numOfThreads; i++ ) {
+        info[i].table = &table;
+        info[i].id = i;
+        info[i].probes = 0;
+        info[i].hits = 0;
+        info[i].falseHits = 0;
+        info[i].errors = 0;
+        info[i].handle = System::startThread( hashTestThread, &info[i] );
+    }
+
+    unsigned probes = 0;
+    unsigned hits = 0;
+    unsigned falseHits = 0;
+    unsigned errors = 0;
+
+    for( i=0; i<numOfThreads; i++ ) {
+        System::waitThread( info[i].handle );
+
+        probes += info[i].probes;
+        hits += info[i].hits;
+        falseHits += info[i].falseHits;
+        errors += info[i].errors;
+    }
+
+    t = System::getTickCount() - t;
+
+    printf( "hashtest complete: probes=%u, hits=%u, false hits=%u, errors=%u in %d.%03d seconds\n", probes, hits, falseHits, errors, t / 1000, t % 1000 );
+    printf( "%s\n\n", errors == 0 ? "OK" : "*** Error: corrupted entries found!" );
+}
@@ -0,0 +1,140 @@
+/*
+    Kiwi
+    Material table
+
+    Copyright (c) 1999-2004,2005 Alessandro Scotti
+    http://www.ascotti.org/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include "material.h"
+#include "score.h"
+
+MaterialInfo    Material::table_[ SideConfigurations*SideConfigurations ];
+
+/*
+    Returns the stage of a side with the specified pieces (i.e. the stage of
+    its opponent, see Position::getWhiteStage()).
+*/
+static int getStage( unsigned count )
+{
+    int minors = (count & Position::MinorPieces_Mask) >> Position::MinorPieces_Shift;
+    int rooks = (count & Position::AllRooks_Mask) >> Position::AllRooks_Shift;
+    int queens = (count & Position::AllQueens_Mask) >> Position::AllQueens_Shift;
+
+    int result = minors*Stage_MinorValue + rooks*Stage_RookValue + queens*Stage_QueenValue;
+
+    return result < Stage_Cap ? result : Stage_Cap;
+}
+
+/*
+    Returns true if a side with the specified pieces can still win: a lone minor
+    piece (or nothing at all) cannot mate.
+*/
+static bool canWin( unsigned count )
+{
+    return (count & (Position::AllPawns_Mask | Position::MajorPieces_Mask)) != 0 ||
+        ((count & Position::MinorPieces_Mask) >> Position::MinorPieces_Shift) > 1;
+}
+
+static int getBishops( unsigned count )
+{
+    return (count & Position::AllBishops_Mask) >> Position::AllBishops_Shift;
+}
+
+static int getPieceValue( unsigned count )
+{
+    return
+        ((count & Position::AllKnights_Mask) >> Position::AllKnights_Shift) * Score::Knight +
+        ((count & Position::AllBishops_Mask) >> Position::AllBishops_Shift) * Score::Bishop +
+        ((count & Position::AllRooks_Mask) >> Position::AllRooks_Shift) * Score::Rook +
+        ((count & Position::AllQueens_Mask) >> Position::AllQueens_Shift) * Score::Queen;
+}
+
+/*
+    Returns the scale factor for the scores in favor of a side with the specified
+    pieces, playing against the other pieces.
+*/
+static int getScale( unsigned count, unsigned otherCount )
+{
+    if( ! canWin( count ) ) {
+        return MaterialInfo::ScaleNone;
+    }
+
+    // Without pawns, being up a minor piece (or less) is seldom enough to win
+    if( (count & Position::AllPawns_Mask) == 0 && getPieceValue( count ) - getPieceValue( otherCount ) <= Score::Bishop ) {
+        return MaterialInfo::ScaleHard;
+    }
+
+    return MaterialInfo::ScaleNormal;
+}
+
+MaterialInfo Material::compute( unsigned whiteCount, unsigned blackCount )
+{
+    MaterialInfo    result;
+
+    result.whiteScale = (unsigned char) getScale( whiteCount, blackCount );
+    result.blackScale = (unsigned char) getScale( blackCount, whiteCount );
+
+    result.stage = (unsigned char) (getStage( whiteCount ) + getStage( blackCount ));
+
+    result.imbalance = 0;
+
+    if( getBishops( whiteCount ) >= 2 ) {
+        result.imbalance += Score::BishopPair;
+    }
+
+    if( getBishops( blackCount ) >= 2 ) {
+        result.imbalance -= Score::BishopPair;
+    }
+
+    return result;
+}
+
+/*
+    Fills the table by enumerating the configurations of each side in the same
+    order used by getSideIndex().
+*/
+void Material::initialize()
+{
+    unsigned    count[ SideConfigurations ];
+    int         index = 0;
+
+    for( unsigned q=0; q<=1; q++ ) {
+        for( unsigned r=0; r<=2; r++ ) {
+            for( unsigned b=0; b<=2; b++ ) {
+                for( unsigned n=0; n<=2; n++ ) {
+                    for( unsigned p=0; p<=1; p++ ) {
+                        count[index++] =
+                            (n+b+r+q+p) * Position::AllPieces_Unit +
+                            p * Position::AllPawns_Unit +
+                            (r+q) * Position::MajorPieces_Unit +
+                            (n+b) * Position::MinorPieces_Unit +
+                            q * Position::AllQueens_Unit +
+                            r * Position::AllRooks_Unit +
+                            n * Position::AllKnights_Unit +
+                            b * Position::AllBishops_Unit;
+                    }
+                }
+            }
+        }
+    }
+
+    for( int w=0; w<SideConfigurations; w++ ) {
+        for( int b=0; b<SideConfigurations; b++ ) {
+            table_[ w*SideConfigurations + b ] = compute( count[w], count[b] );
+        }
+    }
+}
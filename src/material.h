@@ -0,0 +1,116 @@
+/*
+    Kiwi
+    Material table
+
+    Copyright (c) 1999-2004,2005 Alessandro Scotti
+    http://www.ascotti.org/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#ifndef MATERIAL_H_
+#define MATERIAL_H_
+
+#include "position.h"
+
+/*
+    Everything the evaluation needs to know about the material configuration
+    alone: the winning chances of each side, the game stage used to interpolate
+    opening and endgame scores, and the imbalance bonus.
+
+    Winning chances are expressed as a scale factor, which is applied to the
+    score when it favors that side: zero means that the side cannot win at all.
+*/
+struct MaterialInfo
+{
+    enum {
+        ScaleNone       = 0,    // Cannot win (e.g. a lone minor piece)
+        ScaleHard       = 4,    // Can hardly win (e.g. rook against minor piece)
+        ScaleNormal     = 16
+    };
+
+    unsigned char   stage;      // Sum of the stages of both sides, from 0 to 2*Stage_Max
+    unsigned char   whiteScale; // Applied to scores in favor of white
+    unsigned char   blackScale; // Applied to scores in favor of black
+    short           imbalance;  // Bonus for white
+
+    bool whiteCanWin() const {
+        return whiteScale != ScaleNone;
+    }
+
+    bool blackCanWin() const {
+        return blackScale != ScaleNone;
+    }
+
+    bool isDraw() const {
+        return (whiteScale | blackScale) == ScaleNone;
+    }
+
+    // True if the score is used as is
+    bool isUnscaled() const {
+        return whiteScale == ScaleNormal && blackScale == ScaleNormal;
+    }
+};
+
+/*
+    Material table, indexed by the piece counts of both sides.
+
+    Only the presence of pawns matters, so a side has 2*3*3*3*2 configurations
+    (pawns, up to two knights, bishops and rooks, and one queen) and the table
+    covers all pairs of them. Material beyond that can only come from promotions,
+    and is computed on the fly.
+*/
+class Material
+{
+public:
+    static void initialize();
+
+    static MaterialInfo probe( const Position & pos ) {
+        unsigned w = getSideIndex( pos.whitePieceCount );
+        unsigned b = getSideIndex( pos.blackPieceCount );
+
+        if( (w | b) & NotInTable ) {
+            return compute( pos.whitePieceCount, pos.blackPieceCount );
+        }
+
+        return table_[ w*SideConfigurations + b ];
+    }
+
+private:
+    enum {
+        SideConfigurations  = 2*3*3*3*2,
+        NotInTable          = 0x100
+    };
+
+    Material();
+
+    static unsigned getSideIndex( unsigned count ) {
+        unsigned n = (count & Position::AllKnights_Mask) >> Position::AllKnights_Shift;
+        unsigned b = (count & Position::AllBishops_Mask) >> Position::AllBishops_Shift;
+        unsigned r = (count & Position::AllRooks_Mask) >> Position::AllRooks_Shift;
+        unsigned q = (count & Position::AllQueens_Mask) >> Position::AllQueens_Shift;
+
+        if( n > 2 || b > 2 || r > 2 || q > 1 ) {
+            return NotInTable;
+        }
+
+        return (((q*3 + r)*3 + b)*3 + n)*2 + ((count & Position::AllPawns_Mask) != 0);
+    }
+
+    static MaterialInfo compute( unsigned whiteCount, unsigned blackCount );
+
+    static MaterialInfo table_[ SideConfigurations*SideConfigurations ];
+};
+
+#endif // MATERIAL_H_
@@ -38,11 +38,14 @@ const int   BonusForKiller1             = 100 * BonusMultiplier;
 const int   BonusForKiller2             =  90 * BonusMultiplier;
 const int   BonusForMinorPromotion      =  80 * BonusMultiplier;
 const int   BonusForCastling            =  70 * BonusMultiplier;
+const int   BonusForLosingCapture       = -100 * BonusMultiplier;
 
-int  MoveHandler::tableHistoryBlack[64*64];
-int  MoveHandler::tableHistoryWhite[64*64];
-Move MoveHandler::tableKiller1[MaxKiller];
-Move MoveHandler::tableKiller2[MaxKiller];
+const int   MinMoveWeight               = -1000 * BonusMultiplier;
+
+THREAD_LOCAL int         MoveHandler::tableHistoryBlack[64*64];
+THREAD_LOCAL int         MoveHandler::tableHistoryWhite[64*64];
+THREAD_LOCAL unsigned    MoveHandler::tableKiller1[MaxKiller];
+THREAD_LOCAL unsigned    MoveHandler::tableKiller2[MaxKiller];
 
 MoveHandler::MoveHandler( const Position & pos, int ply, int mode, Move hashMove )
     : pos_( pos ) 
@@ -69,6 +72,150 @@ void MoveHandler::restart( Move hashMove )
     state_ = StateReadNextMove;
 }
 
+/*
+    Assigns a weight to the specified move and adds it to the list.
+*/
+void MoveHandler::addMove( const Move & m, bool selectForQuiesce )
+{
+    int moved = pos_.board.piece[ m.getFrom() ];
+    int captured = pos_.board.piece[ m.getTo() ];
+    int promoted = m.getPromoted();
+    int weight = 0;
+
+    if( captured != None ) {
+        // Move is a capture
+        weight = Score::PieceAbs[ captured ] - Score::PieceAbs[ moved ];
+
+        if( weight < 0 ) {
+            weight = pos_.evaluateExchange( m.getFrom(), m.getTo() );
+
+            // Prune losing captures if generating moves for the quiesce search
+            if( selectForQuiesce && (weight < 0) ) {
+                discardedMoves_.add( m );
+                return;
+            }
+        }
+
+        if( weight > 0 ) {
+            weight += BonusForWinningCapture;
+        }
+        else {
+            if( PieceType(promoted) == Queen ) {
+                weight += BonusForPromotionCapture;
+            }
+            else if( weight == 0 ) {
+                weight += BonusForGoodCapture;
+            }
+            else {
+                weight += BonusForLosingCapture;
+            }
+        }
+
+    }
+    else if( promoted != None ) {
+        // Move is a promotion
+        if( PieceType(promoted) == Queen ) {
+            weight += BonusForMajorPromotion;
+        }
+        else {
+            if( selectForQuiesce && (PieceType(m.getPromoted()) != Knight) ) {
+                discardedMoves_.add( m );
+                return;
+            }
+
+            weight += BonusForMinorPromotion + Score::PieceAbs[ promoted ];
+        }
+    }
+    else {
+        if( m == tableKiller1[ ply_ ] ) {
+            weight += BonusForKiller1;
+        }
+        else if( m == tableKiller2[ ply_ ] ) {
+            weight += BonusForKiller2;
+        }
+        else {
+            weight += historyTable_[ m.toUint12() ] >> 16;
+        }
+    }
+
+    // Adjust weight with piece/square information too
+    const char * psq = Score::ByPiece_Opening[ moved ];
+
+    if( psq != 0 ) {
+        weight += psq[ m.getTo() ];
+        weight -= psq[ m.getFrom() ];
+    }
+
+    // Add move to the list
+    move_[ moveCount_ ] = m;
+    moveWeight_[ moveCount_ ] = weight;
+    moveCount_++;
+}
+
+/*
+    Gets the move with the highest weight from those not returned yet, provided
+    its weight is at least "minWeight" (otherwise the move is left in the list).
+*/
+bool MoveHandler::selectNextMove( Move & result, int minWeight )
+{
+    if( moveIndex_ >= moveCount_ ) {
+        return false;
+    }
+
+    // Search the best move in the list
+    int i = moveIndex_;
+
+    for( int j=i+1; j<moveCount_; j++ ) {
+        if( moveWeight_[ j ] > moveWeight_[ i ] ) {
+            i = j;
+        }
+    }
+
+    if( moveWeight_[ i ] < minWeight ) {
+        return false;
+    }
+
+    result = move_[ i ];
+    
+    if( i != moveIndex_ ) {
+        move_[ i ] = move_[ moveIndex_ ];
+        moveWeight_[ i ] = moveWeight_[ moveIndex_ ];
+    }
+
+    moveIndex_++;
+
+    return true;
+}
+
+/*
+    Returns true if the specified killer move can be played now. Captures and
+    promotions are skipped, as they have been generated by the tactical stage already.
+*/
+bool MoveHandler::isUsableKiller( const Move & m ) const
+{
+    if( m == Move::Null || m == hashMove_ || m.getPromoted() != None ) {
+        return false;
+    }
+
+    if( ! pos_.isValidMove( m ) ) {
+        return false;
+    }
+
+    int from = m.getFrom();
+    int to = m.getTo();
+
+    if( pos_.board.piece[ to ] != None ) {
+        return false;
+    }
+
+    // En-passant capture
+    if( PieceType(pos_.board.piece[ from ]) == Pawn && FileOfSquare(from) != FileOfSquare(to) ) {
+        return false;
+    }
+
+    return true;
+}
+
 int MoveHandler::getNextMove( Move & result )
 {
     switch( state_ ) {
@@ -93,129 +240,112 @@ int MoveHandler::getNextMove( Move & result )
 
             MoveList tmp;
 
-            bool selectForQuiesce = (mode_ == GenerateForQuiesce) && ! pos_.isSideToMoveInCheck();
+            bool inCheck = pos_.isSideToMoveInCheck();
+            bool selectForQuiesce = (mode_ == GenerateForQuiesce) && ! inCheck;
 
-            if( pos_.isSideToMoveInCheck() ) {
-                pos_.generateCheckEscapes( tmp );
-            }
-            else if( mode_ == GenerateForQuiesce ) {
-                pos_.generateTactical( tmp ); 
-            }
-            else {
-                pos_.generateMoves( tmp );
-            }
+            if( mode_ == GenerateForSearch && ! inCheck ) {
+                // Generate captures and promotions only, the other moves may not be needed
+                Counters::movesStaged++;
 
-            // Assign a weight to each move and copy it in the main array
-            for( int i=0; i<tmp.count(); i++ ) {
-                Move m = tmp.get( i );
+                pos_.generateTactical( tmp );
 
-                if( m != hashMove_ ) {
-                    int moved = pos_.board.piece[ m.getFrom() ];
-                    int captured = pos_.board.piece[ m.getTo() ];
-                    int promoted = m.getPromoted();
-                    int weight = 0;
-
-                    if( captured != None ) {
-                        // Move is a capture
-                        weight = Score::PieceAbs[ captured ] - Score::PieceAbs[ moved ];
-
-                        if( weight < 0 ) {
-                            weight = pos_.evaluateExchange( m.getFrom(), m.getTo() );
-
-                            // Prune losing captures if generating moves for the quiesce search
-                            if( selectForQuiesce && (weight < 0) ) {
-                                discardedMoves_.add( m );
-                                continue;
-                            }
-                        }
-
-                        if( weight > 0 ) {
-                            weight += BonusForWinningCapture;
-                        }
-                        else {
-                            if( PieceType(promoted) == Queen ) {
-                                weight += BonusForPromotionCapture;
-                            }
-                            else if( weight == 0 ) {
-                                weight += BonusForGoodCapture;
-                            }
-                        }
+                for( int i=0; i<tmp.count(); i++ ) {
+                    Move m = tmp.get( i );
 
+                    if( m != hashMove_ ) {
+                        addMove( m, false );
                     }
-                    else if( promoted != None ) {
-                        // Move is a promotion
-                        if( PieceType(promoted) == Queen ) {
-                            weight += BonusForMajorPromotion;
-                        }
-                        else {
-                            if( selectForQuiesce && (PieceType(m.getPromoted()) != Knight) ) {
-                                discardedMoves_.add( m );
-                                continue;
-                            }
-
-                            weight += BonusForMinorPromotion + Score::PieceAbs[ promoted ];
-                        }
-                    }
-                    else {
-                        if( m == tableKiller1[ ply_ ] ) {
-                            weight += BonusForKiller1;
-                        }
-                        else if( m == tableKiller2[ ply_ ] ) {
-                            weight += BonusForKiller2;
-                        }
-                        else {
-                            weight += historyTable_[ m.toUint12() ] >> 16;
-                        }
-                    }
+                }
+
+                state_ = StateReadTactical;
+            }
+            else {
+                if( Position::useLegalMoveGenerator && (mode_ == GenerateForSearch || inCheck) ) {
+                    pos_.generateLegalMoves( tmp );
+                }
+                else if( inCheck ) {
+                    pos_.generateCheckEscapes( tmp );
+                }
+                else {
+                    pos_.generateTactical( tmp ); 
+                }
 
-                    // Adjust weight with piece/square information too
-                    const char * psq = Score::ByPiece_Opening[ moved ];
+                // Assign a weight to each move and copy it in the main array
+                for( int i=0; i<tmp.count(); i++ ) {
+                    Move m = tmp.get( i );
 
-                    if( psq != 0 ) {
-                        weight += psq[ m.getTo() ];
-                        weight -= psq[ m.getFrom() ];
+                    if( m != hashMove_ ) {
+                        addMove( m, selectForQuiesce );
                     }
-
-                    // Add move to the list
-                    move_[ moveCount_ ] = m;
-                    moveWeight_[ moveCount_ ] = weight;
-                    moveCount_++;
+                    // ...else skip, as hash move was already considered
                 }
-                // ...else skip, as hash move was already considered
+
+                state_ = StateReadNextMove;
+                break;
             }
         }
 
-        state_ = StateReadNextMove;
-
         /* ...fall thru to get a capture move... */
-    case StateReadNextMove:
-        if( moveIndex_ < moveCount_ ) {
-            // Search the best move in the list
-            int i = moveIndex_;
+    case StateReadTactical:
+        // Winning and equal captures, queen promotions
+        if( selectNextMove( result, BonusForGoodCapture ) ) {
+            return 0;
+        }
 
-            for( int j=i+1; j<moveCount_; j++ ) {
-                if( moveWeight_[ j ] > moveWeight_[ i ] ) {
-                    i = j;
-                }
-            }
+        state_ = StateTryKiller1;
 
-            result = move_[ i ];
-            
-            if( i != moveIndex_ ) {
-                move_[ i ] = move_[ moveIndex_ ];
-                moveWeight_[ i ] = moveWeight_[ moveIndex_ ];
-            }
+        /* ...fall thru to killer moves... */
+    case StateTryKiller1:
+        state_ = StateTryKiller2;
+
+        if( isUsableKiller( tableKiller1[ ply_ ] ) ) {
+            result = tableKiller1[ ply_ ];
+            return 0;
+        }
 
-            moveIndex_++;
+        /* ...fall thru... */
+    case StateTryKiller2:
+        state_ = StateGenerateQuiet;
 
+        if( isUsableKiller( tableKiller2[ ply_ ] ) ) {
+            result = tableKiller2[ ply_ ];
             return 0;
         }
-        else {
-            state_ = StateDone;
-            return 1;
+
+        /* ...fall thru... */
+    case StateGenerateQuiet:
+        {
+            // Add the non-tactical moves to the captures and promotions left
+            Counters::movesStagedQuiet++;
+
+            MoveList tmp;
+
+            pos_.generateNonTactical( tmp );
+
+            for( int i=0; i<tmp.count(); i++ ) {
+                Move m = tmp.get( i );
+
+                // Skip hash and killer moves, they have been tried already
+                if( m != hashMove_ && m != tableKiller1[ ply_ ] && m != tableKiller2[ ply_ ] ) {
+                    addMove( m, false );
+                }
+            }
         }
+
+        state_ = StateReadNextMove;
+        break;
+
+    case StateReadNextMove:
+        break;
     }
 
+    // Get the best move left
+    if( selectNextMove( result, MinMoveWeight ) ) {
+        return 0;
+    }
+
+    state_ = StateDone;
+
     return 1;
 }
 
@@ -248,13 +378,13 @@ void MoveHandler::resetKillerTable()
 
 void MoveHandler::addToKillerTable( const Move & m, int ply )
 {
-    Move    killer = tableKiller1[ply];
+    unsigned killer = tableKiller1[ply];
 
-    if( killer != m ) {
+    if( m != killer ) {
         if( killer != Move::Null ) {
             // Move this entry into the next slot
             tableKiller2[ply] = killer;
         }
-        tableKiller1[ply] = m;
+        tableKiller1[ply] = m.toUint16();
     }
 }
@@ -59,19 +59,36 @@ public:
         return m == tableKiller1[ply] || m == tableKiller2[ply];
     }
 
-    static int  tableHistoryBlack[64*64];
-    static int  tableHistoryWhite[64*64];
-    static Move tableKiller1[MaxKiller];
-    static Move tableKiller2[MaxKiller];
+    // Note: tables are kept separately by each search thread, killer moves
+    // are stored in the 16-bit format returned by Move::toUint16()
+    static THREAD_LOCAL int         tableHistoryBlack[64*64];
+    static THREAD_LOCAL int         tableHistoryWhite[64*64];
+    static THREAD_LOCAL unsigned    tableKiller1[MaxKiller];
+    static THREAD_LOCAL unsigned    tableKiller2[MaxKiller];
 
 private:
+    /*
+        When searching a position that is not in check, moves are generated in
+        stages so that no time is wasted if an early move causes a cutoff:
+        hash move, good captures and queen promotions, killer moves, then all the
+        other moves (with losing captures last). Otherwise (in check or in the
+        quiescence search) all moves are generated at once.
+    */
     enum State {
         StateDone,
         StateTryHashMove,
         StateGenerateMoves,
+        StateReadTactical,
+        StateTryKiller1,
+        StateTryKiller2,
+        StateGenerateQuiet,
         StateReadNextMove,
     };
 
+    void addMove( const Move & m, bool selectForQuiesce );
+    bool selectNextMove( Move & m, int minWeight );
+    bool isUsableKiller( const Move & m ) const;
+
     int                 ply_;
     const Position &    pos_;
     int                 mode_;
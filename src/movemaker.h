@@ -0,0 +1,81 @@
+/*
+    Kiwi
+    Copyright (c) 1999-2004,2005 Alessandro Scotti
+    http://www.ascotti.org/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#ifndef MOVEMAKER_H_
+#define MOVEMAKER_H_
+
+#include "move.h"
+#include "position.h"
+#include "undoinfo.h"
+
+/*
+    Plays the moves of a node, in one of two ways:
+    - make/unmake: the move is played on the position of the node and taken back
+      with the information saved in UndoInfo;
+    - copy-make: the position is copied into the next slot of a pre-allocated
+      stack (one position per ply) and the move is played on the copy, so there
+      is nothing to take back.
+
+    In both cases, the position after the move is returned by position().
+*/
+class MoveMaker
+{
+public:
+    /*
+        If "child" is null moves are made and unmade on "pos", else they are
+        played on "child" after copying "pos" into it.
+    */
+    MoveMaker( Position & pos, Position * child ) : pos_( pos ) {
+        if( child != 0 ) {
+            child_ = child;
+        }
+        else {
+            child_ = &pos;
+            undoinfo_.save( pos );
+        }
+    }
+
+    // Plays the move, returns 0 if the move is valid (see Position::doMove())
+    int doMove( Move & m ) {
+        if( child_ != &pos_ ) {
+            *child_ = pos_;
+        }
+
+        return child_->doMove( m );
+    }
+
+    // Takes back the move (nothing to do with copy-make)
+    void undoMove( const Move & m ) {
+        if( child_ == &pos_ ) {
+            pos_.undoMove( m, undoinfo_ );
+        }
+    }
+
+    // Position after the move
+    Position & position() {
+        return *child_;
+    }
+
+private:
+    Position &  pos_;
+    Position *  child_;
+    UndoInfo    undoinfo_;
+};
+
+#endif // MOVEMAKER_H_
@@ -18,12 +18,14 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "counters.h"
 #include "log.h"
 #include "pawnhash.h"
 #include "position.h"
+#include "system.h"
 
 PawnHashTable::PawnHashTable( unsigned n )
 {
@@ -36,14 +38,30 @@ PawnHashTable::PawnHashTable( unsigned n )
         Log::write( "Pawn hash entries adjusted to %d, overall size is %dK\n", n, (n*sizeof(PawnHashEntry)) / 1024 );
     }
 
-    size = n;
-    mask = n-1;
-    table = new PawnHashEntry[ size ];
+    const char * backing;
+
+    size_t bytes = n*sizeof(PawnHashEntry);
+
+    table = (PawnHashEntry *) System::allocateLargestBlock( bytes, sizeof(PawnHashEntry), &backing );
+
+    if( table == 0 ) {
+        Log::write( "*** Fatal: cannot allocate pawn hash table\n" );
+        exit( 1 );
+    }
+
+    if( bytes < n*sizeof(PawnHashEntry) ) {
+        Log::write( "*** Warning: not enough memory for %uK pawn hash entries\n", n >> 10 );
+    }
+
+    size = (unsigned) (bytes / sizeof(PawnHashEntry));
+    mask = size-1;
+
+    Log::write( "Pawn hash table: %uK entries, %uK allocated with %s\n", size >> 10, (unsigned) ((size*sizeof(PawnHashEntry)) >> 10), backing );
 }
 
 PawnHashTable::~PawnHashTable()
 {
-    delete [] table;
+    System::freeLargeBlock( table, size*sizeof(PawnHashEntry) );
 }
 
 void PawnHashTable::reset()
@@ -76,11 +76,16 @@ public:
     }
 
     void setBlackScore( int v1, int v2 ) {
-        blackScore = (((unsigned)(v1+0x8000)) << 16) | ((unsigned)(v2+0x8000));
+        blackScore = MakePackedScore( v1, v2 );
     }
 
     void setWhiteScore( int v1, int v2 ) {
-        whiteScore = (((unsigned)(v1+0x8000)) << 16) | ((unsigned)(v2+0x8000));
+        whiteScore = MakePackedScore( v1, v2 );
+    }
+
+    void setKingShield( int file, int blackDefects, int whiteDefects ) {
+        blackKingShield |= blackDefects << (file*4);
+        whiteKingShield |= whiteDefects << (file*4);
     }
 
     void reset() {
@@ -92,11 +97,26 @@ public:
         return flags2 & PawnHashValidEntry;
     }
 
+    // Returns the defects in the pawn shield of a king on the back rank (see Position::evaluateKingShield())
+    int getBlackKingShield( int file ) const {
+        return (blackKingShield >> (file*4)) & 0x0F;
+    }
+
+    int getWhiteKingShield( int file ) const {
+        return (whiteKingShield >> (file*4)) & 0x0F;
+    }
+
     Uint32      flags1;
     Uint32      flags2;
-    Uint32      whiteScore;
-    Uint32      blackScore;
+    PackedScore whiteScore;         // Opening and endgame scores
+    PackedScore blackScore;
     BitBoard    code;
+    BitBoard    blackPassed;        // Passed pawns (only the most advanced of doubled pawns)
+    BitBoard    whitePassed;
+    BitBoard    blackPawnAttacks;   // Squares attacked by pawns
+    BitBoard    whitePawnAttacks;
+    Uint32      blackKingShield;    // King shield defects by king file, 4 bits each
+    Uint32      whiteKingShield;
 };
 
 class PawnHashTable
@@ -116,6 +136,11 @@ public:
         return size;
     }
 
+    // Starts loading the entry for the specified position into the cache
+    void    prefetch( const Position & pos ) const {
+        PREFETCH( table + (xhash(pos) & mask) );
+    }
+
 private:
     // Unimplemented methods
     PawnHashTable( const PawnHashTable & );
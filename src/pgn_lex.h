@@ -74,7 +74,7 @@ public:
 
         @return token identifier
     */
-    PGNTokenId PGNLex::getNextToken();
+    PGNTokenId getNextToken();
 
     /** Returns the current token identifier. */
     PGNTokenId tokenId() const {
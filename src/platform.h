@@ -22,16 +22,27 @@
 #ifndef PLATFORM_H_
 #define PLATFORM_H_
 
+// Note: THREAD_LOCAL can only be applied to plain data (i.e. types without constructors)
 #if defined(_MSC_VER)
+#include <xmmintrin.h>
 #define CDECL __cdecl
 #define CACHE_ALIGN __declspec(align(64))
+#define THREAD_LOCAL __declspec(thread)
+#define PREFETCH( addr ) _mm_prefetch( (const char *) (addr), _MM_HINT_T0 )
 #else
 #define CDECL
 #define CACHE_ALIGN
+#define THREAD_LOCAL __thread
+#define PREFETCH( addr ) __builtin_prefetch( addr )
 #endif
 
-#if defined(LINUX_I386) || defined(WIN_I386) || defined(MAC_G4)
-// 32-bit platform
+#if defined(LINUX_X86_64) || defined(WIN_X64)
+// 64-bit platform: x86-64 instructions can be used for bit manipulation (see bitboard.h)
+#define PLATFORM_64BIT
+#define CPU_X86_64
+#endif
+
+#if defined(LINUX_I386) || defined(WIN_I386) || defined(MAC_G4) || defined(PLATFORM_64BIT)
 #if defined(__GNUC__)
 
 typedef unsigned long long  Uint64;
@@ -41,6 +52,10 @@ typedef unsigned            Uint32;
 #define PRIx64  "llx"
 #endif
 
+#ifndef PRIu64
+#define PRIu64  "llu"
+#endif
+
 #define MK_U64( n ) n##ull
 
 #else // Visual C++
@@ -52,6 +67,10 @@ typedef unsigned            Uint32;
 #define PRIx64  "I64x"
 #endif
 
+#ifndef PRIu64
+#define PRIu64  "I64u"
+#endif
+
 #define MK_U64( n ) n
 
 #endif
@@ -75,17 +75,13 @@ const Position & Position::operator = ( const Position & p )
     whitePieces         = p.whitePieces;
     
     allPieces           = p.allPieces;
-    allPiecesTA1H8      = p.allPiecesTA1H8;
-    allPiecesDA1H8      = p.allPiecesDA1H8;
-    allPiecesDA8H1      = p.allPiecesDA8H1;
 
     hashCode            = p.hashCode;
     pawnHashCode        = p.pawnHashCode;
 
     materialSignature   = p.materialSignature;
     materialScore       = p.materialScore;
-    pstScoreOpening     = p.pstScoreOpening;
-    pstScoreEndgame     = p.pstScoreEndgame;
+    pstScore            = p.pstScore;
 
     return *this;
 }
@@ -189,8 +185,7 @@ void Position::setBoard( const Board & b )
     
     materialSignature = 0;
     materialScore = 0;
-    pstScoreOpening = 0;
-    pstScoreEndgame = 0;
+    pstScore = 0;
 
     // Clear hash codes
     hashCode.clear();
@@ -213,8 +208,7 @@ void Position::setBoard( const Board & b )
             updateSignatureAdd( Black, Pawn );
             break;
         case BlackKnight:
-            pstScoreOpening -= Score::BlackKnight_Opening[ i ];
-            pstScoreEndgame -= Score::BlackKnight_Endgame[ i ];
+            pstScore -= Score::BlackKnight_Packed[ i ];
 
             blackKnights.setBit( i );
             blackPieceCount += AllPieces_Unit | MinorPieces_Unit | AllKnights_Unit;
@@ -222,8 +216,7 @@ void Position::setBoard( const Board & b )
             updateSignatureAdd( Black, Knight );
             break;
         case BlackBishop:
-            pstScoreOpening -= Score::BlackBishop_Opening[ i ];
-            pstScoreEndgame -= Score::BlackBishop_Endgame[ i ];
+            pstScore -= Score::BlackBishop_Packed[ i ];
 
             blackQueensBishops.setBit( i );
             blackPieceCount += AllPieces_Unit | MinorPieces_Unit | AllBishops_Unit;
@@ -231,8 +224,7 @@ void Position::setBoard( const Board & b )
             updateSignatureAdd( Black, Bishop );
             break;
         case BlackRook:
-            pstScoreOpening -= Score::BlackRook_Opening[ i ];
-            pstScoreEndgame -= Score::BlackRook_Endgame[ i ];
+            pstScore -= Score::BlackRook_Packed[ i ];
 
             blackQueensRooks.setBit( i );
             blackPieceCount += AllPieces_Unit | MajorPieces_Unit | AllRooks_Unit;
@@ -240,8 +232,7 @@ void Position::setBoard( const Board & b )
             updateSignatureAdd( Black, Rook );
             break;
         case BlackQueen:
-            pstScoreOpening -= Score::BlackQueen_Opening[ i ];
-            pstScoreEndgame -= Score::BlackQueen_Endgame[ i ];
+            pstScore -= Score::BlackQueen_Packed[ i ];
 
             blackQueensRooks.setBit( i );
             blackQueensBishops.setBit( i );
@@ -250,8 +241,7 @@ void Position::setBoard( const Board & b )
             updateSignatureAdd( Black, Queen );
             break;
         case BlackKing:
-            pstScoreOpening -= Score::BlackKing_Opening[ i ];
-            pstScoreEndgame -= Score::BlackKing_Endgame[ i ];
+            pstScore -= Score::BlackKing_Packed[ i ];
 
             blackKingSquare = i;
             hashCode ^= Zobrist::BlackKing[i];
@@ -264,8 +254,7 @@ void Position::setBoard( const Board & b )
             updateSignatureAdd( White, Pawn );
             break;
         case WhiteKnight:
-            pstScoreOpening += Score::WhiteKnight_Opening[ i ];
-            pstScoreEndgame += Score::WhiteKnight_Endgame[ i ];
+            pstScore += Score::WhiteKnight_Packed[ i ];
 
             whiteKnights.setBit( i );
             whitePieceCount += AllPieces_Unit | MinorPieces_Unit | AllKnights_Unit;
@@ -273,8 +262,7 @@ void Position::setBoard( const Board & b )
             updateSignatureAdd( White, Knight );
             break;
         case WhiteBishop:
-            pstScoreOpening += Score::WhiteBishop_Opening[ i ];
-            pstScoreEndgame += Score::WhiteBishop_Endgame[ i ];
+            pstScore += Score::WhiteBishop_Packed[ i ];
 
             whiteQueensBishops.setBit( i );
             whitePieceCount += AllPieces_Unit | MinorPieces_Unit | AllBishops_Unit;
@@ -282,8 +270,7 @@ void Position::setBoard( const Board & b )
             updateSignatureAdd( White, Bishop );
             break;
         case WhiteRook:
-            pstScoreOpening += Score::WhiteRook_Opening[ i ];
-            pstScoreEndgame += Score::WhiteRook_Endgame[ i ];
+            pstScore += Score::WhiteRook_Packed[ i ];
 
             whiteQueensRooks.setBit( i );
             whitePieceCount += AllPieces_Unit | MajorPieces_Unit | AllRooks_Unit;
@@ -291,8 +278,7 @@ void Position::setBoard( const Board & b )
             updateSignatureAdd( White, Rook );
             break;
         case WhiteQueen:
-            pstScoreOpening += Score::WhiteQueen_Opening[ i ];
-            pstScoreEndgame += Score::WhiteQueen_Endgame[ i ];
+            pstScore += Score::WhiteQueen_Packed[ i ];
 
             whiteQueensBishops.setBit( i );
             whiteQueensRooks.setBit( i );
@@ -301,8 +287,7 @@ void Position::setBoard( const Board & b )
             updateSignatureAdd( White, Queen );
             break;
         case WhiteKing:
-            pstScoreOpening += Score::WhiteKing_Opening[ i ];
-            pstScoreEndgame += Score::WhiteKing_Endgame[ i ];
+            pstScore += Score::WhiteKing_Packed[ i ];
 
             whiteKingSquare = i;
             hashCode ^= Zobrist::WhiteKing[i];
@@ -314,15 +299,8 @@ void Position::setBoard( const Board & b )
     blackPieces.clear();
     whitePieces.clear();
 
-    allPiecesDA1H8.clear();
-    allPiecesDA8H1.clear();
-    allPiecesTA1H8.clear();
-
     for( i=A1; i<=H8; i++ ) {
         if( board.piece[i] != None ) {
-            allPiecesDA1H8.setBit( boardDA1H8[i] );
-            allPiecesDA8H1.setBit( boardDA8H1[i] );
-            allPiecesTA1H8.setBit( boardTA1H8[i] );
             if( (board.piece[i] & PieceSideMask) == Black ) {
                 blackPieces.setBit( i );
             }
@@ -378,8 +356,8 @@ void Position::dump( const char * header ) const
     fprintf( f, "%s to play, material: %d, pst=%d/%d, flags: %x\n", 
         sideToPlay == White ? "White" : "Black",
         materialScore,
-        pstScoreOpening,
-        pstScoreEndgame,
+        GetOpeningScore( pstScore ),
+        GetEndgameScore( pstScore ),
         boardFlags );
 }
 
@@ -404,12 +382,8 @@ int Position::operator == ( const Position & p ) const
         (whiteQueensRooks   == p.whiteQueensRooks) &&
         (whitePieces        == p.whitePieces) &&
         (allPieces          == p.allPieces) &&
-        (allPiecesTA1H8     == p.allPiecesTA1H8) &&
-        (allPiecesDA1H8     == p.allPiecesDA1H8) &&
-        (allPiecesDA8H1     == p.allPiecesDA8H1) &&
         (materialScore      == p.materialScore) &&
-        (pstScoreOpening    == p.pstScoreOpening) &&
-        (pstScoreEndgame    == p.pstScoreEndgame) &&
+        (pstScore           == p.pstScore) &&
         (hashCode           == p.hashCode) &&
         (pawnHashCode       == p.pawnHashCode) );
 }
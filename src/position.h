@@ -137,7 +137,19 @@ public:
     int getBoard( char * fen, int moveNumber = 0 ) const;
 
     //
-    int getEvaluation() const;
+    int getEvaluation() const {
+        return getEvaluation( Score::Min, Score::Max );
+    }
+
+    // Same as getEvaluation(), but when the score is clearly outside the specified
+    // window it may return a bound instead (lazy evaluation): either a value not lower
+    // than upperBound and not higher than the score, or a value not higher than lowerBound
+    // and not lower than the score
+    int getEvaluation( int lowerBound, int upperBound ) const;
+
+    // Max difference between the full evaluation and the material plus piece/square
+    // score, used by the lazy evaluation (zero disables it)
+    static int  lazyEvalMargin;
 
     PawnHashEntry * evaluatePawnStructure() const;
 
@@ -170,6 +182,22 @@ public:
     void        generateNonTactical( MoveList & moves ) const;
     void        generateCheckEscapes( MoveList & moves ) const;
     void        generateValidMoves( MoveList & moves, int to = -1 ) const;
+    void        generateLegalMoves( MoveList & moves ) const;
+
+    // Same as above, for a side to play known at compile time (see sidetraits.h)
+    template<int Side> int  doMove( Move & m );
+    template<int Side> void undoMove( const Move & m, const UndoInfo & info );
+
+    template<int Side> void generateMoves( MoveList & moves ) const;
+    template<int Side> void generateMovesToSquare( MoveList & moves, int to ) const;
+    template<int Side> void generateTactical( MoveList & moves ) const;
+    template<int Side> void generateNonTactical( MoveList & moves ) const;
+    template<int Side> void generateCheckEscapes( MoveList & moves ) const;
+    template<int Side> void generateLegalMoves( MoveList & moves ) const;
+
+    // If not zero, the search and perft use generateLegalMoves() instead of the
+    // pseudo-legal generators (with 2, perft also cross-checks the two generators)
+    static int  useLegalMoveGenerator;
 
     //
     BitBoard    getAttacksFromSquare( int square ) const;
@@ -474,9 +502,6 @@ public:
 #endif
     
     BitBoard        allPieces;
-    BitBoard        allPiecesTA1H8;
-    BitBoard        allPiecesDA1H8;
-    BitBoard        allPiecesDA8H1;
     //
     BitBoard        hashCode;
     BitBoard        pawnHashCode;
@@ -487,31 +512,33 @@ public:
     //
     unsigned        materialSignature;
     int             materialScore;
-    int             pstScoreOpening;
-    int             pstScoreEndgame;
+    PackedScore     pstScore;           // Piece/square score (see PackedScore)
 
 private:
     void addXRayAttacker( BitBoard & attackers, int from, int attackDirection ) const;
+    template<int Side> void generateCastling( MoveList & moves, const BitBoard & targets ) const;
+    template<int Side> bool isLegalEnPassant( int from, int to, const BitBoard & checkers ) const;
+    template<int Side> bool isSquareAttackedWith( int square, const BitBoard & occupied ) const;
     void setBoard( const Board & b );
 };
 
+#define rookAttacks( from )         \
+    Attacks::getRookAttacks( from, allPieces )
+
 #define rookAttacksOnRank( from )   \
-    (Attacks::RookRank[from][allPieces.getRank(from / 8)])
+    (rookAttacks(from) & Attacks::RookOnRank[from])
 
 #define rookAttacksOnFile( from )   \
-    (Attacks::RookFile[from][allPiecesTA1H8.getRank(from % 8)])
+    (rookAttacks(from) & Attacks::RookOnFile[from])
 
-#define rookAttacks( from )         \
-    (rookAttacksOnRank(from) | rookAttacksOnFile(from))
+#define bishopAttacks( from )           \
+    Attacks::getBishopAttacks( from, allPieces )
 
 #define bishopAttacksOnDiagA1H8( from ) \
-    (Attacks::BishopA1H8[from][(allPiecesDA1H8 >> shiftDA1H8[from]).toByte()])
+    (bishopAttacks(from) & Attacks::BishopOnA1H8[from])
 
 #define bishopAttacksOnDiagA8H1( from ) \
-    (Attacks::BishopA8H1[from][(allPiecesDA8H1 >> shiftDA8H1[from]).toByte()])
-
-#define bishopAttacks( from )           \
-    (bishopAttacksOnDiagA1H8(from) | bishopAttacksOnDiagA8H1(from))
+    (bishopAttacks(from) & Attacks::BishopOnA8H1[from])
 
 #define updateSignatureAdd( color, piece ) \
     materialSignature += SignatureMaterial##color##piece; \
@@ -28,6 +28,7 @@
 #include "position.h"
 #include "san.h"
 #include "score.h"
+#include "sidetraits.h"
 #include "zobrist.h"
 
 /*
@@ -44,6 +45,22 @@
 */
 int Position::doMove( Move & m )
 {
+    if( sideToPlay == Black ) {
+        return doMove<Black>( m );
+    }
+
+    return doMove<White>( m );
+}
+
+/*
+    Performs the specified move for the side "Side", which must be the side to play.
+*/
+template<int Side>
+int Position::doMove( Move & m )
+{
+    typedef SideTraits<Side>                Us;
+    typedef SideTraits<OppositeSide(Side)>  Them;
+
     int         to          = m.getTo();
     int         from        = m.getFrom();
     BitBoard    fromTo      = BitBoard::Set[from] | BitBoard::Set[to];
@@ -59,28 +76,16 @@ int Position::doMove( Move & m )
         boardFlags &= ~EnPassantSquareMask;
         hashCode ^= Zobrist::EnPassant[enPassantSquare];
 
-        if( (to == enPassantSquare) && (PieceType(pieceMoved)==Pawn) ) {
+        if( (to == enPassantSquare) && (pieceMoved == Us::Pawn) ) {
             // En-passant capture
             m.setEnPassant();
 
-            if( to <= H3 ) {
-                // This is a black pawn capturing on the 3rd rank
-                pieceCaptured = WhitePawn;
-                pieceCapturedPos = to+8;
-            }
-            else {
-                // White pawn capturing on the 6th rank
-                pieceCaptured = BlackPawn;
-                pieceCapturedPos = to-8;
-            }
+            pieceCaptured = Them::Pawn;
+            pieceCapturedPos = to - Us::Forward;
 
             board.piece[pieceCapturedPos] = None;
 
             allPieces ^= BitBoard::Set[pieceCapturedPos] | BitBoard::Set[to];
-
-            allPiecesTA1H8 ^= SetTA1H8[pieceCapturedPos] | SetTA1H8[to];
-            allPiecesDA1H8 ^= SetDA1H8[pieceCapturedPos] | SetDA1H8[to];
-            allPiecesDA8H1 ^= SetDA8H1[pieceCapturedPos] | SetDA8H1[to];
         }
         else {
             pieceCaptured   = board.piece[to];
@@ -99,9 +104,6 @@ int Position::doMove( Move & m )
         // Remove the moved piece from the global boards (later the captured piece
         // will be "overwritten" on the destination square by the moved piece)
         allPieces.clrBit( from );
-        allPiecesTA1H8 ^= SetTA1H8[from];
-        allPiecesDA1H8 ^= SetDA1H8[from];
-        allPiecesDA8H1 ^= SetDA8H1[from];
 
         // Reset the half-move clock
         boardFlags &= ~HalfMoveClockMask;
@@ -114,123 +116,60 @@ int Position::doMove( Move & m )
 
         // Remove the captured piece from the board
         switch( pieceCaptured ) {
-        case BlackPawn:
-            blackPieceCount -= AllPawns_Unit;
-            blackPieces.clrBit(pieceCapturedPos);
-            blackPawns.clrBit(pieceCapturedPos);
-            hashCode ^= Zobrist::BlackPawn[pieceCapturedPos];
-            pawnHashCode ^= Zobrist::BlackPawn[pieceCapturedPos];
-            updateSignatureRemove( Black, Pawn );
-            break;
-        case WhitePawn:
-            whitePieceCount -= AllPawns_Unit;
-            whitePieces.clrBit(pieceCapturedPos);
-            whitePawns.clrBit(pieceCapturedPos);
-            hashCode ^= Zobrist::WhitePawn[pieceCapturedPos];
-            pawnHashCode ^= Zobrist::WhitePawn[pieceCapturedPos];
-            updateSignatureRemove( White, Pawn );
+        case Them::Pawn:
+            Them::pieceCount(*this) -= AllPawns_Unit;
+            Them::pieces(*this).clrBit(pieceCapturedPos);
+            Them::pawns(*this).clrBit(pieceCapturedPos);
+            hashCode ^= Them::zobristPawn()[pieceCapturedPos];
+            pawnHashCode ^= Them::zobristPawn()[pieceCapturedPos];
+            updateSideSignatureRemove( Them, Pawn );
             break;
-        case BlackKnight:
-            pstScoreOpening += Score::BlackKnight_Opening[ pieceCapturedPos ];
-            pstScoreEndgame += Score::BlackKnight_Endgame[ pieceCapturedPos ];
-
-            blackPieceCount -= AllPieces_Unit | MinorPieces_Unit | AllKnights_Unit;
-            blackPieces.clrBit(pieceCapturedPos);
-            blackKnights.clrBit(pieceCapturedPos);
-            hashCode ^= Zobrist::BlackKnight[pieceCapturedPos];
-            updateSignatureRemove( Black, Knight );
+        case Them::Knight:
+            pstScore -= Them::Sign * Them::knightScore()[ pieceCapturedPos ];
+
+            Them::pieceCount(*this) -= AllPieces_Unit | MinorPieces_Unit | AllKnights_Unit;
+            Them::pieces(*this).clrBit(pieceCapturedPos);
+            Them::knights(*this).clrBit(pieceCapturedPos);
+            hashCode ^= Them::zobristKnight()[pieceCapturedPos];
+            updateSideSignatureRemove( Them, Knight );
             break;
-        case WhiteKnight:
-            pstScoreOpening -= Score::WhiteKnight_Opening[ pieceCapturedPos ];
-            pstScoreEndgame -= Score::WhiteKnight_Endgame[ pieceCapturedPos ];
-
-            whitePieceCount -= AllPieces_Unit | MinorPieces_Unit | AllKnights_Unit;
-            whitePieces.clrBit(pieceCapturedPos);
-            whiteKnights.clrBit(pieceCapturedPos);
-            hashCode ^= Zobrist::WhiteKnight[pieceCapturedPos];
-            updateSignatureRemove( White, Knight );
+        case Them::Bishop:
+            pstScore -= Them::Sign * Them::bishopScore()[ pieceCapturedPos ];
+
+            Them::pieceCount(*this) -= AllPieces_Unit | MinorPieces_Unit | AllBishops_Unit;
+            Them::pieces(*this).clrBit(pieceCapturedPos);
+            Them::queensBishops(*this).clrBit(pieceCapturedPos);
+            hashCode ^= Them::zobristBishop()[pieceCapturedPos];
+            updateSideSignatureRemove( Them, Bishop );
             break;
-        case BlackBishop:
-            pstScoreOpening += Score::BlackBishop_Opening[ pieceCapturedPos ];
-            pstScoreEndgame += Score::BlackBishop_Endgame[ pieceCapturedPos ];
-
-            blackPieceCount -= AllPieces_Unit | MinorPieces_Unit | AllBishops_Unit;
-            blackPieces.clrBit(pieceCapturedPos);
-            blackQueensBishops.clrBit(pieceCapturedPos);
-            hashCode ^= Zobrist::BlackBishop[pieceCapturedPos];
-            updateSignatureRemove( Black, Bishop );
-            break;
-        case WhiteBishop:
-            pstScoreOpening -= Score::WhiteBishop_Opening[ pieceCapturedPos ];
-            pstScoreEndgame -= Score::WhiteBishop_Endgame[ pieceCapturedPos ];
-
-            whitePieceCount -= AllPieces_Unit | MinorPieces_Unit | AllBishops_Unit;
-            whitePieces.clrBit(pieceCapturedPos);
-            whiteQueensBishops.clrBit(pieceCapturedPos);
-            hashCode ^= Zobrist::WhiteBishop[pieceCapturedPos];
-            updateSignatureRemove( White, Bishop );
-            break;
-        case BlackRook:
-            pstScoreOpening += Score::BlackRook_Opening[ pieceCapturedPos ];
-            pstScoreEndgame += Score::BlackRook_Endgame[ pieceCapturedPos ];
-
-            blackPieceCount -= AllPieces_Unit | MajorPieces_Unit | AllRooks_Unit;
-            blackPieces.clrBit(pieceCapturedPos);
-            blackQueensRooks.clrBit(pieceCapturedPos);
-            hashCode ^= Zobrist::BlackRook[pieceCapturedPos];
-            if( (pieceCapturedPos == H8) && (boardFlags & BlackCastleKing) ) {
-                // Disable kingside castling
-                boardFlags &= ~BlackCastleKing;
-                hashCode ^= Zobrist::BlackCastleKing;
-            }
-            if( (pieceCapturedPos == A8) && (boardFlags & BlackCastleQueen) ) {
-                // Disable queenside castling
-                boardFlags &= ~BlackCastleQueen;
-                hashCode ^= Zobrist::BlackCastleQueen;
-            }
-            updateSignatureRemove( Black, Rook );
-            break;
-        case WhiteRook:
-            pstScoreOpening -= Score::WhiteRook_Opening[ pieceCapturedPos ];
-            pstScoreEndgame -= Score::WhiteRook_Endgame[ pieceCapturedPos ];
-
-            whitePieceCount -= AllPieces_Unit | MajorPieces_Unit | AllRooks_Unit;
-            whitePieces.clrBit(pieceCapturedPos);
-            whiteQueensRooks.clrBit(pieceCapturedPos);
-            hashCode ^= Zobrist::WhiteRook[pieceCapturedPos];
-            if( (pieceCapturedPos == H1) && (boardFlags & WhiteCastleKing) ) {
+        case Them::Rook:
+            pstScore -= Them::Sign * Them::rookScore()[ pieceCapturedPos ];
+
+            Them::pieceCount(*this) -= AllPieces_Unit | MajorPieces_Unit | AllRooks_Unit;
+            Them::pieces(*this).clrBit(pieceCapturedPos);
+            Them::queensRooks(*this).clrBit(pieceCapturedPos);
+            hashCode ^= Them::zobristRook()[pieceCapturedPos];
+            if( (pieceCapturedPos == Them::KingRook) && (boardFlags & Them::CastleKing) ) {
                 // Disable kingside castling
-                boardFlags &= ~WhiteCastleKing;
-                hashCode ^= Zobrist::WhiteCastleKing;
+                boardFlags &= ~Them::CastleKing;
+                hashCode ^= Them::zobristCastleKing();
             }
-            if( (pieceCapturedPos == A1) && (boardFlags & WhiteCastleQueen) ) {
+            if( (pieceCapturedPos == Them::QueenRook) && (boardFlags & Them::CastleQueen) ) {
                 // Disable queenside castling
-                boardFlags &= ~WhiteCastleQueen;
-                hashCode ^= Zobrist::WhiteCastleQueen;
+                boardFlags &= ~Them::CastleQueen;
+                hashCode ^= Them::zobristCastleQueen();
             }
-            updateSignatureRemove( White, Rook );
-            break;
-        case BlackQueen:
-            pstScoreOpening += Score::BlackQueen_Opening[ pieceCapturedPos ];
-            pstScoreEndgame += Score::BlackQueen_Endgame[ pieceCapturedPos ];
-
-            blackPieceCount -= AllPieces_Unit | MajorPieces_Unit | AllQueens_Unit;
-            blackPieces.clrBit(pieceCapturedPos);
-            blackQueensBishops.clrBit(pieceCapturedPos);
-            blackQueensRooks.clrBit(pieceCapturedPos);
-            hashCode ^= Zobrist::BlackQueen[pieceCapturedPos];
-            updateSignatureRemove( Black, Queen );
+            updateSideSignatureRemove( Them, Rook );
             break;
-        case WhiteQueen:
-            pstScoreOpening -= Score::WhiteQueen_Opening[ pieceCapturedPos ];
-            pstScoreEndgame -= Score::WhiteQueen_Endgame[ pieceCapturedPos ];
-
-            whitePieceCount -= AllPieces_Unit | MajorPieces_Unit | AllQueens_Unit;
-            whitePieces.clrBit(pieceCapturedPos);
-            whiteQueensBishops.clrBit(pieceCapturedPos);
-            whiteQueensRooks.clrBit(pieceCapturedPos);
-            hashCode ^= Zobrist::WhiteQueen[pieceCapturedPos];
-            updateSignatureRemove( White, Queen );
+        case Them::Queen:
+            pstScore -= Them::Sign * Them::queenScore()[ pieceCapturedPos ];
+
+            Them::pieceCount(*this) -= AllPieces_Unit | MajorPieces_Unit | AllQueens_Unit;
+            Them::pieces(*this).clrBit(pieceCapturedPos);
+            Them::queensBishops(*this).clrBit(pieceCapturedPos);
+            Them::queensRooks(*this).clrBit(pieceCapturedPos);
+            hashCode ^= Them::zobristQueen()[pieceCapturedPos];
+            updateSideSignatureRemove( Them, Queen );
             break;
         default:
             return 1;
@@ -240,154 +179,73 @@ int Position::doMove( Move & m )
         // Not a capture
         allPieces ^= fromTo;
 
-        allPiecesTA1H8 ^= SetTA1H8[from] | SetTA1H8[to];
-        allPiecesDA1H8 ^= SetDA1H8[from] | SetDA1H8[to];
-        allPiecesDA8H1 ^= SetDA8H1[from] | SetDA8H1[to];
-
         // Bump the half-move clock (if this is a pawn move it will be reset later)
         boardFlags += HalfMoveClockIncrement;
     }
 
     switch( pieceMoved ) {
-    case BlackPawn:
+    case Us::Pawn:
         boardFlags &= ~HalfMoveClockMask; // Reset half-move clock
-        blackPieces ^= fromTo;
-        hashCode ^= Zobrist::BlackPawn[from];
-        pawnHashCode ^= Zobrist::BlackPawn[from];
-        if( to <= H1 ) {
+        Us::pieces(*this) ^= fromTo;
+        hashCode ^= Us::zobristPawn()[from];
+        pawnHashCode ^= Us::zobristPawn()[from];
+        if( RankOfSquare(to) == Us::PromotionRank ) {
             // Promotion: remove pawn and add piece
-            blackPawns.clrBit(from);
+            Us::pawns(*this).clrBit(from);
             board.piece[to] = (Piece)m.getPromoted();
-            materialScore += (Score::Piece[m.getPromoted()]+Score::Pawn);
+            materialScore += (Score::Piece[m.getPromoted()]-Score::Piece[Us::Pawn]);
 
-            blackPieceCount -= AllPawns_Unit;
+            Us::pieceCount(*this) -= AllPawns_Unit;
 
             switch( m.getPromoted() ) {
-            case BlackKnight:
-                pstScoreOpening -= Score::BlackKnight_Opening[ to ];
-                pstScoreEndgame -= Score::BlackKnight_Endgame[ to ];
-
-                blackPieceCount += AllPieces_Unit | MinorPieces_Unit | AllKnights_Unit;
-                blackKnights.setBit(to);
-                hashCode ^= Zobrist::BlackKnight[to];
-                updateSignatureAdd( Black, Knight );
+            case Us::Knight:
+                pstScore += Us::Sign * Us::knightScore()[ to ];
+
+                Us::pieceCount(*this) += AllPieces_Unit | MinorPieces_Unit | AllKnights_Unit;
+                Us::knights(*this).setBit(to);
+                hashCode ^= Us::zobristKnight()[to];
+                updateSideSignatureAdd( Us, Knight );
                 break;
-            case BlackBishop:
-                pstScoreOpening -= Score::BlackBishop_Opening[ to ];
-                pstScoreEndgame -= Score::BlackBishop_Endgame[ to ];
-
-                blackPieceCount += AllPieces_Unit | MinorPieces_Unit | AllBishops_Unit;
-                blackQueensBishops.setBit(to);
-                hashCode ^= Zobrist::BlackBishop[to];
-                updateSignatureAdd( Black, Bishop );
+            case Us::Bishop:
+                pstScore += Us::Sign * Us::bishopScore()[ to ];
+
+                Us::pieceCount(*this) += AllPieces_Unit | MinorPieces_Unit | AllBishops_Unit;
+                Us::queensBishops(*this).setBit(to);
+                hashCode ^= Us::zobristBishop()[to];
+                updateSideSignatureAdd( Us, Bishop );
                 break;
-            case BlackRook:
-                pstScoreOpening -= Score::BlackRook_Opening[ to ];
-                pstScoreEndgame -= Score::BlackRook_Endgame[ to ];
-
-                blackPieceCount += AllPieces_Unit | MajorPieces_Unit | AllRooks_Unit;
-                blackQueensRooks.setBit(to);
-                hashCode ^= Zobrist::BlackRook[to];
-                updateSignatureAdd( Black, Rook );
+            case Us::Rook:
+                pstScore += Us::Sign * Us::rookScore()[ to ];
+
+                Us::pieceCount(*this) += AllPieces_Unit | MajorPieces_Unit | AllRooks_Unit;
+                Us::queensRooks(*this).setBit(to);
+                hashCode ^= Us::zobristRook()[to];
+                updateSideSignatureAdd( Us, Rook );
                 break;
-            case BlackQueen:
-                pstScoreOpening -= Score::BlackQueen_Opening[ to ];
-                pstScoreEndgame -= Score::BlackQueen_Endgame[ to ];
-
-                blackPieceCount += AllPieces_Unit | MajorPieces_Unit | AllQueens_Unit;
-                blackQueensBishops.setBit(to);
-                blackQueensRooks.setBit(to);
-                hashCode ^= Zobrist::BlackQueen[to];
-                updateSignatureAdd( Black, Queen );
+            case Us::Queen:
+                pstScore += Us::Sign * Us::queenScore()[ to ];
+
+                Us::pieceCount(*this) += AllPieces_Unit | MajorPieces_Unit | AllQueens_Unit;
+                Us::queensBishops(*this).setBit(to);
+                Us::queensRooks(*this).setBit(to);
+                hashCode ^= Us::zobristQueen()[to];
+                updateSideSignatureAdd( Us, Queen );
                 break;
             default:
                 return 1;
             }
 
-            updateSignatureRemove( Black, Pawn );
-        }
-        else {
-            blackPawns ^= fromTo;
-            board.piece[to] = BlackPawn;
-            hashCode ^= Zobrist::BlackPawn[to];
-            pawnHashCode ^= Zobrist::BlackPawn[to];
-
-            if( (from >= A7) && (to <= H5) && (Mask::SideSquares[to] & whitePawns) ) {
-                // Enable en-passant for next move
-                int enPassantSquare = from - 8;
-                hashCode ^= Zobrist::EnPassant[enPassantSquare];
-                boardFlags |= EnPassantAvailable | enPassantSquare;
-
-                if( board.piece[enPassantSquare] != None ) {
-                    return 1;
-                }
-            }
-        }
-        break;
-    case WhitePawn:
-        boardFlags &= ~HalfMoveClockMask; // Reset half-move clock
-        whitePieces ^= fromTo;
-        hashCode ^= Zobrist::WhitePawn[from];
-        pawnHashCode ^= Zobrist::WhitePawn[from];
-        if( to >= A8 ) {
-            // Promotion: remove pawn and add piece
-            whitePawns.clrBit(from);
-            board.piece[to] = (Piece)m.getPromoted();
-            materialScore += (Score::Piece[m.getPromoted()]-Score::Pawn);
-
-            whitePieceCount -= AllPawns_Unit;
-
-            switch( m.getPromoted() ) {
-            case WhiteKnight:
-                pstScoreOpening += Score::WhiteKnight_Opening[ to ];
-                pstScoreEndgame += Score::WhiteKnight_Endgame[ to ];
-
-                whitePieceCount += AllPieces_Unit | MinorPieces_Unit | AllKnights_Unit;
-                whiteKnights.setBit(to);
-                hashCode ^= Zobrist::WhiteKnight[to];
-                updateSignatureAdd( White, Knight );
-                break;
-            case WhiteBishop:
-                pstScoreOpening += Score::WhiteBishop_Opening[ to ];
-                pstScoreEndgame += Score::WhiteBishop_Endgame[ to ];
-
-                whitePieceCount += AllPieces_Unit | MinorPieces_Unit | AllBishops_Unit;
-                whiteQueensBishops.setBit(to);
-                hashCode ^= Zobrist::WhiteBishop[to];
-                updateSignatureAdd( White, Bishop );
-                break;
-            case WhiteRook:
-                pstScoreOpening += Score::WhiteRook_Opening[ to ];
-                pstScoreEndgame += Score::WhiteRook_Endgame[ to ];
-
-                whitePieceCount += AllPieces_Unit | MajorPieces_Unit | AllRooks_Unit;
-                whiteQueensRooks.setBit(to);
-                hashCode ^= Zobrist::WhiteRook[to];
-                updateSignatureAdd( White, Rook );
-                break;
-            case WhiteQueen:
-                pstScoreOpening += Score::WhiteQueen_Opening[ to ];
-                pstScoreEndgame += Score::WhiteQueen_Endgame[ to ];
-
-                whitePieceCount += AllPieces_Unit | MajorPieces_Unit | AllQueens_Unit;
-                whiteQueensBishops.setBit(to);
-                whiteQueensRooks.setBit(to);
-                hashCode ^= Zobrist::WhiteQueen[to];
-                updateSignatureAdd( White, Queen );
-                break;
-            }
-
-            updateSignatureRemove( White, Pawn );
+            updateSideSignatureRemove( Us, Pawn );
         }
         else {
-            whitePawns ^= fromTo;
-            board.piece[to] = WhitePawn;
-            hashCode ^= Zobrist::WhitePawn[to];
-            pawnHashCode ^= Zobrist::WhitePawn[to];
+            Us::pawns(*this) ^= fromTo;
+            board.piece[to] = Us::Pawn;
+            hashCode ^= Us::zobristPawn()[to];
+            pawnHashCode ^= Us::zobristPawn()[to];
 
-            if( (from <= H2) && (to >= A4) && (Mask::SideSquares[to] & blackPawns) ) {
+            if( (to - from == 2*Us::Forward) && (Mask::SideSquares[to] & Them::pawns(*this)) ) {
                 // Enable en-passant for next move
-                int enPassantSquare = from + 8;
+                int enPassantSquare = from + Us::Forward;
                 hashCode ^= Zobrist::EnPassant[enPassantSquare];
                 boardFlags |= EnPassantAvailable | enPassantSquare;
 
@@ -397,353 +255,159 @@ int Position::doMove( Move & m )
             }
         }
         break;
-    case BlackKnight:
-        pstScoreOpening += Score::BlackKnight_Opening[ from ];
-        pstScoreOpening -= Score::BlackKnight_Opening[ to ];
-        pstScoreEndgame += Score::BlackKnight_Endgame[ from ];
-        pstScoreEndgame -= Score::BlackKnight_Endgame[ to ];
-
-        blackPieces ^= fromTo;
-        blackKnights ^= fromTo;
-        board.piece[to] = BlackKnight;
-        hashCode ^= Zobrist::BlackKnight[from];
-        hashCode ^= Zobrist::BlackKnight[to];
+    case Us::Knight:
+        pstScore += Us::Sign * (Us::knightScore()[ to ] - Us::knightScore()[ from ]);
+
+        Us::pieces(*this) ^= fromTo;
+        Us::knights(*this) ^= fromTo;
+        board.piece[to] = Us::Knight;
+        hashCode ^= Us::zobristKnight()[from];
+        hashCode ^= Us::zobristKnight()[to];
         break;
-    case WhiteKnight:
-        pstScoreOpening -= Score::WhiteKnight_Opening[ from ];
-        pstScoreOpening += Score::WhiteKnight_Opening[ to ];
-        pstScoreEndgame -= Score::WhiteKnight_Endgame[ from ];
-        pstScoreEndgame += Score::WhiteKnight_Endgame[ to ];
-
-        whitePieces ^= fromTo;
-        whiteKnights ^= fromTo;
-        board.piece[to] = WhiteKnight;
-        hashCode ^= Zobrist::WhiteKnight[from];
-        hashCode ^= Zobrist::WhiteKnight[to];
+    case Us::Bishop:
+        pstScore += Us::Sign * (Us::bishopScore()[ to ] - Us::bishopScore()[ from ]);
+
+        Us::pieces(*this) ^= fromTo;
+        Us::queensBishops(*this) ^= fromTo;
+        board.piece[to] = Us::Bishop;
+        hashCode ^= Us::zobristBishop()[from];
+        hashCode ^= Us::zobristBishop()[to];
         break;
-    case BlackBishop:
-        pstScoreOpening += Score::BlackBishop_Opening[ from ];
-        pstScoreOpening -= Score::BlackBishop_Opening[ to ];
-        pstScoreEndgame += Score::BlackBishop_Endgame[ from ];
-        pstScoreEndgame -= Score::BlackBishop_Endgame[ to ];
-
-        blackPieces ^= fromTo;
-        blackQueensBishops ^= fromTo;
-        board.piece[to] = BlackBishop;
-        hashCode ^= Zobrist::BlackBishop[from];
-        hashCode ^= Zobrist::BlackBishop[to];
-        break;
-    case WhiteBishop:
-        pstScoreOpening -= Score::WhiteBishop_Opening[ from ];
-        pstScoreOpening += Score::WhiteBishop_Opening[ to ];
-        pstScoreEndgame -= Score::WhiteBishop_Endgame[ from ];
-        pstScoreEndgame += Score::WhiteBishop_Endgame[ to ];
-
-        whitePieces ^= fromTo;
-        whiteQueensBishops ^= fromTo;
-        board.piece[to] = WhiteBishop;
-        hashCode ^= Zobrist::WhiteBishop[from];
-        hashCode ^= Zobrist::WhiteBishop[to];
-        break;
-    case BlackRook:
-        pstScoreOpening += Score::BlackRook_Opening[ from ];
-        pstScoreOpening -= Score::BlackRook_Opening[ to ];
-        pstScoreEndgame += Score::BlackRook_Endgame[ from ];
-        pstScoreEndgame -= Score::BlackRook_Endgame[ to ];
-
-        blackPieces ^= fromTo;
-        blackQueensRooks ^= fromTo;
-        board.piece[to] = BlackRook;
-        hashCode ^= Zobrist::BlackRook[from];
-        hashCode ^= Zobrist::BlackRook[to];
-        if( (from == H8) && (boardFlags & BlackCastleKing) ) {
-            // Disable kingside castling
-            boardFlags &= ~BlackCastleKing;
-            hashCode ^= Zobrist::BlackCastleKing;
-        }
-        if( (from == A8) && (boardFlags & BlackCastleQueen) ) {
-            // Disable queenside castling
-            boardFlags &= ~BlackCastleQueen;
-            hashCode ^= Zobrist::BlackCastleQueen;
-        }
-        break;
-    case WhiteRook:
-        pstScoreOpening -= Score::WhiteRook_Opening[ from ];
-        pstScoreOpening += Score::WhiteRook_Opening[ to ];
-        pstScoreEndgame -= Score::WhiteRook_Endgame[ from ];
-        pstScoreEndgame += Score::WhiteRook_Endgame[ to ];
-
-        whitePieces ^= fromTo;
-        whiteQueensRooks ^= fromTo;
-        board.piece[to] = WhiteRook;
-        hashCode ^= Zobrist::WhiteRook[from];
-        hashCode ^= Zobrist::WhiteRook[to];
-        if( (from == H1) && (boardFlags & WhiteCastleKing) ) {
+    case Us::Rook:
+        pstScore += Us::Sign * (Us::rookScore()[ to ] - Us::rookScore()[ from ]);
+
+        Us::pieces(*this) ^= fromTo;
+        Us::queensRooks(*this) ^= fromTo;
+        board.piece[to] = Us::Rook;
+        hashCode ^= Us::zobristRook()[from];
+        hashCode ^= Us::zobristRook()[to];
+        if( (from == Us::KingRook) && (boardFlags & Us::CastleKing) ) {
             // Disable kingside castling
-            boardFlags &= ~WhiteCastleKing;
-            hashCode ^= Zobrist::WhiteCastleKing;
+            boardFlags &= ~Us::CastleKing;
+            hashCode ^= Us::zobristCastleKing();
         }
-        if( (from == A1) && (boardFlags & WhiteCastleQueen) ) {
+        if( (from == Us::QueenRook) && (boardFlags & Us::CastleQueen) ) {
             // Disable queenside castling
-            boardFlags &= ~WhiteCastleQueen;
-            hashCode ^= Zobrist::WhiteCastleQueen;
+            boardFlags &= ~Us::CastleQueen;
+            hashCode ^= Us::zobristCastleQueen();
         }
         break;
-    case BlackQueen:
-        pstScoreOpening += Score::BlackQueen_Opening[ from ];
-        pstScoreOpening -= Score::BlackQueen_Opening[ to ];
-        pstScoreEndgame += Score::BlackQueen_Endgame[ from ];
-        pstScoreEndgame -= Score::BlackQueen_Endgame[ to ];
-
-        blackPieces ^= fromTo;
-        blackQueensBishops ^= fromTo;
-        blackQueensRooks ^= fromTo;
-        board.piece[to] = BlackQueen;
-        hashCode ^= Zobrist::BlackQueen[from];
-        hashCode ^= Zobrist::BlackQueen[to];
+    case Us::Queen:
+        pstScore += Us::Sign * (Us::queenScore()[ to ] - Us::queenScore()[ from ]);
+
+        Us::pieces(*this) ^= fromTo;
+        Us::queensBishops(*this) ^= fromTo;
+        Us::queensRooks(*this) ^= fromTo;
+        board.piece[to] = Us::Queen;
+        hashCode ^= Us::zobristQueen()[from];
+        hashCode ^= Us::zobristQueen()[to];
         break;
-    case WhiteQueen:
-        pstScoreOpening -= Score::WhiteQueen_Opening[ from ];
-        pstScoreOpening += Score::WhiteQueen_Opening[ to ];
-        pstScoreEndgame -= Score::WhiteQueen_Endgame[ from ];
-        pstScoreEndgame += Score::WhiteQueen_Endgame[ to ];
-
-        whitePieces ^= fromTo;
-        whiteQueensBishops ^= fromTo;
-        whiteQueensRooks ^= fromTo;
-        board.piece[to] = WhiteQueen;
-        hashCode ^= Zobrist::WhiteQueen[from];
-        hashCode ^= Zobrist::WhiteQueen[to];
-        break;
-    case BlackKing:
-        pstScoreOpening += Score::BlackKing_Opening[ from ];
-        pstScoreOpening -= Score::BlackKing_Opening[ to ];
-        pstScoreEndgame += Score::BlackKing_Endgame[ from ];
-        pstScoreEndgame -= Score::BlackKing_Endgame[ to ];
-
-        blackPieces ^= fromTo;
-        blackKingSquare = to;
-        board.piece[to] = BlackKing;
-        hashCode ^= Zobrist::BlackKing[from];
-        hashCode ^= Zobrist::BlackKing[to];
-        if( from == E8 ) {
-            if( to == G8 ) {
+    case Us::King:
+        pstScore += Us::Sign * (Us::kingScore()[ to ] - Us::kingScore()[ from ]);
+
+        Us::pieces(*this) ^= fromTo;
+        Us::kingSquare(*this) = to;
+        board.piece[to] = Us::King;
+        hashCode ^= Us::zobristKing()[from];
+        hashCode ^= Us::zobristKing()[to];
+        if( from == Us::KingStart ) {
+            if( to == Us::KingCastleTo ) {
                 // Kingside castle: move the rook
-                pstScoreOpening += Score::BlackRook_Opening[ H8 ];
-                pstScoreOpening -= Score::BlackRook_Opening[ F8 ];
-                pstScoreEndgame += Score::BlackRook_Endgame[ H8 ];
-                pstScoreEndgame -= Score::BlackRook_Endgame[ F8 ];
-
-                fromTo = BitBoard::Set[H8] | BitBoard::Set[F8];
-                blackPieces ^= fromTo;
-                blackQueensRooks ^= fromTo;
-                allPieces ^= fromTo;
-                allPiecesTA1H8 ^= SetTA1H8[H8] | SetTA1H8[F8];
-                allPiecesDA1H8 ^= SetDA1H8[H8] | SetDA1H8[F8];
-                allPiecesDA8H1 ^= SetDA8H1[H8] | SetDA8H1[F8];
-                hashCode ^= Zobrist::BlackRook[H8];
-                hashCode ^= Zobrist::BlackRook[F8];
-                board.piece[H8] = None;
-                board.piece[F8] = BlackRook;
-
-                boardFlags |= BlackHasCastled;
-            }
-            else if( to == C8 ) {
-                // Queenside castle: move the rook
-                pstScoreOpening += Score::BlackRook_Opening[ A8 ];
-                pstScoreOpening -= Score::BlackRook_Opening[ D8 ];
-                pstScoreEndgame += Score::BlackRook_Endgame[ A8 ];
-                pstScoreEndgame -= Score::BlackRook_Endgame[ D8 ];
-
-                fromTo = BitBoard::Set[A8] | BitBoard::Set[D8];
-                blackPieces ^= fromTo;
-                blackQueensRooks ^= fromTo;
-                allPieces ^= fromTo;
-                allPiecesTA1H8 ^= SetTA1H8[A8] | SetTA1H8[D8];
-                allPiecesDA1H8 ^= SetDA1H8[A8] | SetDA1H8[D8];
-                allPiecesDA8H1 ^= SetDA8H1[A8] | SetDA8H1[D8];
-                hashCode ^= Zobrist::BlackRook[A8];
-                hashCode ^= Zobrist::BlackRook[D8];
-                board.piece[A8] = None;
-                board.piece[D8] = BlackRook;
-
-                boardFlags |= BlackHasCastled;
-            }
-            // Clear castling flags
-            if( boardFlags & BlackCastleKing )   hashCode ^= Zobrist::BlackCastleKing;
-            if( boardFlags & BlackCastleQueen )  hashCode ^= Zobrist::BlackCastleQueen;
-            boardFlags &= ~(BlackCastleKing | BlackCastleQueen);
-        }
-        break;
-    case WhiteKing:
-        pstScoreOpening -= Score::WhiteKing_Opening[ from ];
-        pstScoreOpening += Score::WhiteKing_Opening[ to ];
-        pstScoreEndgame -= Score::WhiteKing_Endgame[ from ];
-        pstScoreEndgame += Score::WhiteKing_Endgame[ to ];
-
-        whitePieces ^= fromTo;
-        whiteKingSquare = to;
-        board.piece[to] = WhiteKing;
-        hashCode ^= Zobrist::WhiteKing[from];
-        hashCode ^= Zobrist::WhiteKing[to];
-        if( from == E1 ) {
-            if( to == G1 ) {
-                // Kingside castle: move the rook
-                pstScoreOpening -= Score::WhiteRook_Opening[ H1 ];
-                pstScoreOpening += Score::WhiteRook_Opening[ F1 ];
-                pstScoreEndgame -= Score::WhiteRook_Endgame[ H1 ];
-                pstScoreEndgame += Score::WhiteRook_Endgame[ F1 ];
-
-                fromTo = BitBoard::Set[H1] | BitBoard::Set[F1];
-                whitePieces ^= fromTo;
-                whiteQueensRooks ^= fromTo;
+                pstScore += Us::Sign * (Us::rookScore()[ Us::KingRookTo ] - Us::rookScore()[ Us::KingRook ]);
+
+                fromTo = BitBoard::Set[Us::KingRook] | BitBoard::Set[Us::KingRookTo];
+                Us::pieces(*this) ^= fromTo;
+                Us::queensRooks(*this) ^= fromTo;
                 allPieces ^= fromTo;
-                allPiecesTA1H8 ^= SetTA1H8[H1] | SetTA1H8[F1];
-                allPiecesDA1H8 ^= SetDA1H8[H1] | SetDA1H8[F1];
-                allPiecesDA8H1 ^= SetDA8H1[H1] | SetDA8H1[F1];
-                hashCode ^= Zobrist::WhiteRook[H1];
-                hashCode ^= Zobrist::WhiteRook[F1];
-                board.piece[H1] = None;
-                board.piece[F1] = WhiteRook;
-
-                boardFlags |= WhiteHasCastled;
+                hashCode ^= Us::zobristRook()[Us::KingRook];
+                hashCode ^= Us::zobristRook()[Us::KingRookTo];
+                board.piece[Us::KingRook] = None;
+                board.piece[Us::KingRookTo] = Us::Rook;
+
+                boardFlags |= Us::HasCastled;
             }
-            else if( to == C1 ) {
+            else if( to == Us::QueenCastleTo ) {
                 // Queenside castle: move the rook
-                pstScoreOpening -= Score::WhiteRook_Opening[ A1 ];
-                pstScoreOpening += Score::WhiteRook_Opening[ D1 ];
-                pstScoreEndgame -= Score::WhiteRook_Endgame[ A1 ];
-                pstScoreEndgame += Score::WhiteRook_Endgame[ D1 ];
-
-                fromTo = BitBoard::Set[A1] | BitBoard::Set[D1];
-                whitePieces ^= fromTo;
-                whiteQueensRooks ^= fromTo;
+                pstScore += Us::Sign * (Us::rookScore()[ Us::QueenRookTo ] - Us::rookScore()[ Us::QueenRook ]);
+
+                fromTo = BitBoard::Set[Us::QueenRook] | BitBoard::Set[Us::QueenRookTo];
+                Us::pieces(*this) ^= fromTo;
+                Us::queensRooks(*this) ^= fromTo;
                 allPieces ^= fromTo;
-                allPiecesTA1H8 ^= SetTA1H8[A1] | SetTA1H8[D1];
-                allPiecesDA1H8 ^= SetDA1H8[A1] | SetDA1H8[D1];
-                allPiecesDA8H1 ^= SetDA8H1[A1] | SetDA8H1[D1];
-                hashCode ^= Zobrist::WhiteRook[A1];
-                hashCode ^= Zobrist::WhiteRook[D1];
-                board.piece[A1] = None;
-                board.piece[D1] = WhiteRook;
-
-                boardFlags |= WhiteHasCastled;
+                hashCode ^= Us::zobristRook()[Us::QueenRook];
+                hashCode ^= Us::zobristRook()[Us::QueenRookTo];
+                board.piece[Us::QueenRook] = None;
+                board.piece[Us::QueenRookTo] = Us::Rook;
+
+                boardFlags |= Us::HasCastled;
             }
 
             // Clear castling flags
-            if( boardFlags & WhiteCastleKing )   hashCode ^= Zobrist::WhiteCastleKing;
-            if( boardFlags & WhiteCastleQueen )  hashCode ^= Zobrist::WhiteCastleQueen;
+            if( boardFlags & Us::CastleKing )   hashCode ^= Us::zobristCastleKing();
+            if( boardFlags & Us::CastleQueen )  hashCode ^= Us::zobristCastleQueen();
 
-            boardFlags &= ~(WhiteCastleKing | WhiteCastleQueen);
+            boardFlags &= ~(Us::CastleKing | Us::CastleQueen);
         }
         break;
     }
 
     board.piece[from] = None;
 
-    sideToPlay ^= PieceSideMask;
+    sideToPlay = OppositeSide(Side);
     hashCode ^= ZobSideToPlay;
 
     // Check whether this move put this side in check (then it's illegal) or
     // if it checks the other side
-    if( sideToPlay != Black ) {
-        // Note: the current side to play is the opposite of the one that
-        // performed the move, so this code refers to black!
-
-        int king = blackKingSquare;
-
-        if( (boardFlags & SideToPlayInCheck) || (pieceMoved == BlackKing) || m.getEnPassant() ) {
-            // Make sure we do not put the king in check
-            if( Attacks::Knight[king] & whiteKnights ) return 1;
-            if( Attacks::BlackPawn[king] & whitePawns ) return 1;
-            if( rookAttacks(king) & whiteQueensRooks ) return 1;
-            if( bishopAttacks(king) & whiteQueensBishops ) return 1;
-            if( Attacks::KingDistance[king][whiteKingSquare] <= 1 ) return 1;
-        }
-        else {
-            // If we are here then we can only get a discovered check
-            // when our own piece moved
-            unsigned    dir = Attacks::Direction[from][king];
-
-            switch( dir ) {
-            case DirRank:
-                if( rookAttacksOnRank( king ) & whiteQueensRooks ) return 1;
-                break;
-            case DirFile:
-                if( rookAttacksOnFile( king ) & whiteQueensRooks ) return 1;
-                break;
-            case DirA1H8:
-                if( bishopAttacksOnDiagA1H8( king ) & whiteQueensBishops ) return 1;
-                break;
-            case DirA8H1:
-                if( bishopAttacksOnDiagA8H1( king ) & whiteQueensBishops ) return 1;
-                break;
-            }
-        }
-
-        // Update side in check flag
-        boardFlags &= ~SideToPlayInCheck;
-
-        king = whiteKingSquare;
-
-        if( ( Attacks::Knight[king] & blackKnights ) ||
-            ( (Attacks::Rook[king] & blackQueensRooks) && (rookAttacks(king) & blackQueensRooks) )  ||
-            ( (Attacks::Bishop[king] & blackQueensBishops) && (bishopAttacks(king) & blackQueensBishops) ) ||
-            ( Attacks::WhitePawn[king] & blackPawns ) ) 
-        {
-            boardFlags |= SideToPlayInCheck;
-        }
+    int king = Us::kingSquare(*this);
+
+    if( (boardFlags & SideToPlayInCheck) || (pieceMoved == Us::King) || m.getEnPassant() ) {
+        // Make sure we do not put the king in check
+        if( Attacks::Knight[king] & Them::knights(*this) ) return 1;
+        if( Us::pawnAttacks()[king] & Them::pawns(*this) ) return 1;
+        if( rookAttacks(king) & Them::queensRooks(*this) ) return 1;
+        if( bishopAttacks(king) & Them::queensBishops(*this) ) return 1;
+        if( Attacks::KingDistance[king][Them::kingSquare(*this)] <= 1 ) return 1;
     }
     else {
-        int king = whiteKingSquare;
-
-        if( (boardFlags & SideToPlayInCheck) || (pieceMoved == WhiteKing) || m.getEnPassant() ) {
-            // Make sure we do not put the king in check
-            if( Attacks::Knight[king] & blackKnights ) return 1;
-            if( Attacks::WhitePawn[king] & blackPawns ) return 1;
-            if( rookAttacks(king) & blackQueensRooks ) return 1;
-            if( bishopAttacks(king) & blackQueensBishops ) return 1;
-            if( Attacks::KingDistance[king][blackKingSquare] <= 1 ) return 1;
-        }
-        else {
-            // If we are here then we can only get a discovered check
-            // when our own piece moved
-            unsigned    dir = Attacks::Direction[from][king];
-
-            switch( dir ) {
-            case DirRank:
-                if( rookAttacksOnRank( king ) & blackQueensRooks ) return 1;
-                break;
-            case DirFile:
-                if( rookAttacksOnFile( king ) & blackQueensRooks ) return 1;
-                break;
-            case DirA1H8:
-                if( bishopAttacksOnDiagA1H8( king ) & blackQueensBishops ) return 1;
-                break;
-            case DirA8H1:
-                if( bishopAttacksOnDiagA8H1( king ) & blackQueensBishops ) return 1;
-                break;
-            }
+        // If we are here then we can only get a discovered check
+        // when our own piece moved
+        unsigned    dir = Attacks::Direction[from][king];
 
+        switch( dir ) {
+        case DirRank:
+            if( rookAttacksOnRank( king ) & Them::queensRooks(*this) ) return 1;
+            break;
+        case DirFile:
+            if( rookAttacksOnFile( king ) & Them::queensRooks(*this) ) return 1;
+            break;
+        case DirA1H8:
+            if( bishopAttacksOnDiagA1H8( king ) & Them::queensBishops(*this) ) return 1;
+            break;
+        case DirA8H1:
+            if( bishopAttacksOnDiagA8H1( king ) & Them::queensBishops(*this) ) return 1;
+            break;
         }
+    }
 
-        // Update side in check flag
-        boardFlags &= ~SideToPlayInCheck;
+    // Update side in check flag
+    boardFlags &= ~SideToPlayInCheck;
 
-        king = blackKingSquare;
+    king = Them::kingSquare(*this);
 
-        if( ( Attacks::Knight[king] & whiteKnights ) ||
-            ( (Attacks::Rook[king] & whiteQueensRooks) && (rookAttacks(king) & whiteQueensRooks) )  ||
-            ( (Attacks::Bishop[king] & whiteQueensBishops) && (bishopAttacks(king) & whiteQueensBishops) ) ||
-            ( Attacks::BlackPawn[king] & whitePawns ) ) 
-        {
-            boardFlags |= SideToPlayInCheck;
-        }
+    if( ( Attacks::Knight[king] & Us::knights(*this) ) ||
+        ( (Attacks::Rook[king] & Us::queensRooks(*this)) && (rookAttacks(king) & Us::queensRooks(*this)) )  ||
+        ( (Attacks::Bishop[king] & Us::queensBishops(*this)) && (bishopAttacks(king) & Us::queensBishops(*this)) ) ||
+        ( Them::pawnAttacks()[king] & Us::pawns(*this) ) ) 
+    {
+        boardFlags |= SideToPlayInCheck;
     }
 
     return 0;
 }
 
+template int Position::doMove<White>( Move & m );
+template int Position::doMove<Black>( Move & m );
+
 int Position::doNullMove() 
 { 
     if( boardFlags & EnPassantAvailable ) {
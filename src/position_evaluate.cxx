@@ -20,17 +20,21 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "board.h"
 #include "counters.h"
 #include "engine.h"
+#include "evalcache.h"
 #include "hash.h"
 #include "log.h"
 #include "mask.h"
+#include "material.h"
 #include "metrics.h"
 #include "pawnhash.h"
 #include "position.h"
 #include "score.h"
+#include "system.h"
 
 #undef PRINT
 //#define PRINT( s )  printf s
@@ -91,33 +95,51 @@ const int   PassedPawnBonus_Endgame[8] = {
 const int   TrappedRookPenalty      = 60;
 const int   TrappedBishopPenalty    = 100;
 
-EvalItem evalCache[ ItemsInEvalCache ];
+/*
+    The margin of the lazy evaluation has been measured on the benchmark positions:
+    the full evaluation differs from material plus piece/square by more than
+    200 points in 1.3% of the positions, by more than 300 in 0.2% and by more
+    than 400 in 0.04%.
+*/
+int Position::lazyEvalMargin = 300;
 
-int Position::getEvaluation() const
+int Position::getEvaluation( int lowerBound, int upperBound ) const
 {
-    // Evaluate draws for insufficient material, and remember whether a side can win or not
-    bool blackCanWin = true;
-    bool whiteCanWin = true;
-
-    if( ! hasBlackPawns() && ! hasBlackMajorPieces() && numOfBlackMinorPieces() <= 1 ) {
-        blackCanWin = false;
-    }
+    // Evaluate draws for insufficient material, and remember the winning chances of each side
+    MaterialInfo material = Material::probe( *this );
 
-    if( ! hasWhitePawns() && ! hasWhiteMajorPieces() && numOfWhiteMinorPieces() <= 1 ) {
-        whiteCanWin = false;
-    }
-
-    if( ! whiteCanWin && ! blackCanWin ) {
+    if( material.isDraw() ) {
         return 0;
-    }
+    }
 
     // Probe eval cache
-    EvalItem * ev_item = evalCache + (((hashCode >> 32).toUnsigned()) & (ItemsInEvalCache-1));
+    EvalCache * evalCache = Engine::getEvalCache();
+    int         cachedEval;
 
-    if( ev_item->code == hashCode.toUnsigned() ) {
-        return ev_item->eval;
+    if( evalCache->probe( *this, cachedEval ) ) {
+        return cachedEval;
     }
 
+    int stage = material.stage;
+
+    // Lazy evaluation: if material plus piece/square is far enough from the window,
+    // the other terms cannot bring the score inside it, so return a bound
+    if( lazyEvalMargin > 0 && material.isUnscaled() && (lowerBound > Score::Min || upperBound < Score::Max) ) {
+        int lazyScore = materialScore + GetStageScore( pstScore, stage );
+
+        Counters::evalLazyProbes++;
+
+        if( lazyScore - lazyEvalMargin >= upperBound ) {
+            Counters::evalLazyCuts++;
+            return lazyScore - lazyEvalMargin;
+        }
+
+        if( lazyScore + lazyEvalMargin <= lowerBound ) {
+            Counters::evalLazyCuts++;
+            return lazyScore + lazyEvalMargin;
+        }
+    }
+
     BitBoard    allPawns    = blackPawns | whitePawns;
 
     BitBoard    whiteEnemyOrEmpty   = ~whitePieces;
@@ -125,14 +147,11 @@ int Position::getEvaluation() const
 
     BitBoard    whiteKingDanger = Mask::KingAttack_Danger[ whiteKingSquare ];
     BitBoard    blackKingDanger = Mask::KingAttack_Danger[ blackKingSquare ];
-    BitBoard    blackPassed( 0 );
-    BitBoard    whitePassed( 0 );
 
     BitBoard    bb;
     int         pos;
-    int         positionalScore = 0;
-    int         posOpening = 0;
-    int         posEndgame = 0;
+    int         positionalScore = material.imbalance;
+    PackedScore posScore = 0;
     unsigned    whiteAttack = 0;
     unsigned    blackAttack = 0;
     unsigned    whiteDefend = KingAtk;
@@ -140,8 +159,6 @@ int Position::getEvaluation() const
 
     int         result = 0;
 
-    int stage = getWhiteStage() + getBlackStage();
-
     positionalScore += evaluateDevelopment();
     positionalScore += evaluatePatterns();
 
@@ -158,8 +175,10 @@ int Position::getEvaluation() const
         entry = evaluatePawnStructure();
     }
 
-    int pawnOpening = (((entry->whiteScore >> 16) & 0xFFFF) - 0x8000) - (((entry->blackScore >> 16) & 0xFFFF) - 0x8000);
-    int pawnEndgame = ((entry->whiteScore & 0xFFFF) - 0x8000) - ((entry->blackScore & 0xFFFF) - 0x8000);
+    PackedScore pawnScore = entry->whiteScore - entry->blackScore;
+
+    BitBoard    blackPassed = entry->blackPassed;
+    BitBoard    whitePassed = entry->whitePassed;
 
     // Note: one may be tempted use a "switch" statemement on the board pieces,
     // which would make for some cleaner code. Surprisingly, last time I tried
@@ -172,42 +191,29 @@ int Position::getEvaluation() const
     const int ExpRookMob    =  8;   // In open board: min=max=14
     const int ExpQueenMob   = 12;   // In open board: min=21, max=27
 
-    const int ValKnightMobOpening   = 3;
-    const int ValKnightMobEndgame   = 3;
-    const int ValBishopMobOpening   = 4;
-    const int ValBishopMobEndgame   = 4;
-    const int ValRookMobOpening     = 2;
-    const int ValRookMobEndgame     = 4;
-    const int ValQueenMobOpening    = 0;
-    const int ValQueenMobEndgame    = 2;
+    const PackedScore ValKnightMob  = MakePackedScore( 3, 3 );
+    const PackedScore ValBishopMob  = MakePackedScore( 4, 4 );
+    const PackedScore ValRookMob    = MakePackedScore( 2, 4 );
+    const PackedScore ValQueenMob   = MakePackedScore( 0, 2 );
 
-    int mobOpening = 0;
-    int mobEndgame = 0;
+    PackedScore mobility = 0;
 
     BitBoard atk;
     int x;
 
-    BitBoard    bpAtk;
-    BitBoard    wpAtk;
+    BitBoard    bpAtk = entry->blackPawnAttacks;
+    BitBoard    wpAtk = entry->whitePawnAttacks;
 
     //--------------------------------------------------
     //
     // Pawn
     //
     //--------------------------------------------------
-    bb = ((blackPawns & Mask::NotFile[0]) >> 9) | ((blackPawns & Mask::NotFile[7]) >> 7);
-
-    bpAtk = bb;
-
-    if( bb & whiteKingDanger ) {
+    if( bpAtk & whiteKingDanger ) {
         blackAttack += PawnAtk;
     }
 
-    bb = ((whitePawns & Mask::NotFile[7]) << 9) | ((whitePawns & Mask::NotFile[0]) << 7);
-
-    wpAtk = bb;
-
-    if( bb & blackKingDanger ) {
+    if( wpAtk & blackKingDanger ) {
         whiteAttack += PawnAtk;
     }
 
@@ -216,117 +222,109 @@ int Position::getEvaluation() const
     // Passed pawns
     //
     //--------------------------------------------------
-    bb = blackPawns;
+    bb = blackPassed;
     while( bb.isNotZero() ) {
         pos = bitSearchAndReset( bb );
-        if( (Mask::BlackPassed[pos] & whitePawns).isZero() && (Mask::SquaresTo1stRank[pos] & blackPawns).isZero() ) {
-            PRINT(( "The black pawn %s is passed\n", sqname(pos) ));
+        PRINT(( "The black pawn %s is passed\n", sqname(pos) ));
 
-            int bonus =
-                (PassedPawnBonus_Opening[ 7 - RankOfSquare(pos) ]*stage +
-                PassedPawnBonus_Endgame[ 7 - RankOfSquare(pos) ]*(2*Stage_Max-stage)) / (2*Stage_Max);
+        int bonus =
+            (PassedPawnBonus_Opening[ 7 - RankOfSquare(pos) ]*stage +
+            PassedPawnBonus_Endgame[ 7 - RankOfSquare(pos) ]*(2*Stage_Max-stage)) / (2*Stage_Max);
 
-            result -= bonus;
+        result -= bonus;
 
-            PRINT(( "  ...bonus = %d\n", bonus ));
+        PRINT(( "  ...bonus = %d\n", bonus ));
 
-            blackPassed.setBit( pos );
+        // Protected pawn
+        if( (Attacks::WhitePawn[pos] & blackPawns).isNotZero() ) {
+            PRINT(( "  ...and protected\n" ));
 
-            // Protected pawn
-            if( (Attacks::WhitePawn[pos] & blackPawns).isNotZero() ) {
-                PRINT(( "  ...and protected\n" ));
+            result -= bonus / 4;
+        }
 
-                result -= bonus / 4;
-            }
+        // King is better close to the pawn in the endgame
+        posScore += MakePackedScore( 0, (distance( pos, blackKingSquare ) * bonus) / 16 );
 
-            // King is better close to the pawn in the endgame
-            posEndgame += (distance( pos, blackKingSquare ) * bonus) / 16;
+        PRINT(( "  ...king distance = %d\n", (distance( pos, blackKingSquare ) * bonus) / 16 ));
 
-            PRINT(( "  ...king distance = %d\n", (distance( pos, blackKingSquare ) * bonus) / 16 ));
-
-            // Rook behind passed pawn
-            BitBoard tmp = rookAttacksOnFile(pos) & blackQueensRooks;
-            if( tmp ) {
-                tmp &= Mask::SquaresTo8thRank[pos];
-                tmp &= ~(blackQueensBishops & blackQueensRooks);
-
-                if( tmp ) {
-                    PRINT(( "  ...pushed by rook\n" ));
-
-                    posEndgame -= Score::RookBehindPassedPawn; // Rook behind passer
-                }
-            }
-
-            // Blocked pawn
-            if( whitePieces.getBit( pos-8 ) ) {
-                int penalty = (bonus * 2) / 4;
+        // Rook behind passed pawn
+        BitBoard tmp = rookAttacksOnFile(pos) & blackQueensRooks;
+        if( tmp ) {
+            tmp &= Mask::SquaresTo8thRank[pos];
+            tmp &= ~(blackQueensBishops & blackQueensRooks);
+
+            if( tmp ) {
+                PRINT(( "  ...pushed by rook\n" ));
+
+                posScore -= MakePackedScore( 0, Score::RookBehindPassedPawn ); // Rook behind passer
+            }
+        }
 
-                if( board.piece[pos-8] == WhiteKnight ) {
-                    PRINT(( "  ...blocked by knight\n" ));
-                    penalty += bonus / 8;
-                }
-                
-                PRINT(( "  ...blocked, penalty = %d\n", penalty ));
+        // Blocked pawn
+        if( whitePieces.getBit( pos-8 ) ) {
+            int penalty = (bonus * 2) / 4;
 
-                result += penalty;
+            if( board.piece[pos-8] == WhiteKnight ) {
+                PRINT(( "  ...blocked by knight\n" ));
+                penalty += bonus / 8;
             }
+            
+            PRINT(( "  ...blocked, penalty = %d\n", penalty ));
+
+            result += penalty;
         }
     }
 
-    bb = whitePawns;
+    bb = whitePassed;
     while( bb.isNotZero() ) {
         pos = bitSearchAndReset( bb );
-        if( (Mask::WhitePassed[pos] & blackPawns).isZero() && (Mask::SquaresTo8thRank[pos] & whitePawns).isZero() ) {
-            PRINT(( "The white pawn %s is passed\n", sqname(pos) ));
+        PRINT(( "The white pawn %s is passed\n", sqname(pos) ));
 
-            int bonus =
-                (PassedPawnBonus_Opening[ RankOfSquare(pos) ]*stage +
-                PassedPawnBonus_Endgame[ RankOfSquare(pos) ]*(2*Stage_Max-stage)) / (2*Stage_Max);
+        int bonus =
+            (PassedPawnBonus_Opening[ RankOfSquare(pos) ]*stage +
+            PassedPawnBonus_Endgame[ RankOfSquare(pos) ]*(2*Stage_Max-stage)) / (2*Stage_Max);
 
-            PRINT(( "  ...bonus = %d\n", bonus ));
+        PRINT(( "  ...bonus = %d\n", bonus ));
 
-            result += bonus;
+        result += bonus;
 
-            whitePassed.setBit( pos );
+        // Protected pawn
+        if( (Attacks::BlackPawn[pos] & whitePawns).isNotZero() ) {
+            PRINT(( "  ...and protected\n" ));
 
-            // Protected pawn
-            if( (Attacks::BlackPawn[pos] & whitePawns).isNotZero() ) {
-                PRINT(( "  ...and protected\n" ));
+            result += bonus / 4;
+        }
 
-                result += bonus / 4;
-            }
+        // King is better close to the pawn in the endgame
+        posScore -= MakePackedScore( 0, (distance( pos, whiteKingSquare ) * bonus) / 16 );
 
-            // King is better close to the pawn in the endgame
-            posEndgame -= (distance( pos, whiteKingSquare ) * bonus) / 16;
+        PRINT(( "  ...king distance = %d\n", (distance( pos, whiteKingSquare ) * bonus) / 16 ));
 
-            PRINT(( "  ...king distance = %d\n", (distance( pos, whiteKingSquare ) * bonus) / 16 ));
-
-            // Rook behind passed pawn
-            BitBoard tmp = rookAttacksOnFile(pos) & whiteQueensRooks;
-            if( tmp ) {
-                tmp &= Mask::SquaresTo1stRank[pos];
-                tmp &= ~(whiteQueensBishops & whiteQueensRooks);
-
-                if( tmp ) {
-                    PRINT(( "  ...pushed by rook\n" ));
-
-                    posEndgame += Score::RookBehindPassedPawn; // Rook behind passer
-                }
-            }
-
-            // Blocked pawn
-            if( blackPieces.getBit( pos+8 ) ) {
-                int penalty = (bonus * 2) / 4;
+        // Rook behind passed pawn
+        BitBoard tmp = rookAttacksOnFile(pos) & whiteQueensRooks;
+        if( tmp ) {
+            tmp &= Mask::SquaresTo1stRank[pos];
+            tmp &= ~(whiteQueensBishops & whiteQueensRooks);
+
+            if( tmp ) {
+                PRINT(( "  ...pushed by rook\n" ));
+
+                posScore += MakePackedScore( 0, Score::RookBehindPassedPawn ); // Rook behind passer
+            }
+        }
 
-                if( board.piece[pos+8] == BlackKnight ) {
-                    PRINT(( "  ...blocked by knight\n" ));
-                    penalty += bonus / 8;
-                }
-                
-                PRINT(( "  ...blocked, penalty = %d\n", penalty ));
+        // Blocked pawn
+        if( blackPieces.getBit( pos+8 ) ) {
+            int penalty = (bonus * 2) / 4;
 
-                result -= penalty;
+            if( board.piece[pos+8] == BlackKnight ) {
+                PRINT(( "  ...blocked by knight\n" ));
+                penalty += bonus / 8;
             }
+            
+            PRINT(( "  ...blocked, penalty = %d\n", penalty ));
+
+            result -= penalty;
         }
     }
 
@@ -345,8 +343,7 @@ int Position::getEvaluation() const
 #ifdef HAVE_MOBILITY
         x = bitCount( atk & blackEnemyOrEmpty ) - ExpKnightMob;
 
-        mobOpening -= ValKnightMobOpening * x;
-        mobEndgame -= ValKnightMobEndgame * x;
+        mobility -= ValKnightMob * x;
 #endif
 
         if( atk & whiteKingDanger ) {
@@ -371,8 +368,7 @@ int Position::getEvaluation() const
 #ifdef HAVE_MOBILITY
         x = bitCount( atk & whiteEnemyOrEmpty ) - ExpKnightMob;
 
-        mobOpening += ValKnightMobOpening * x;
-        mobEndgame += ValKnightMobEndgame * x;
+        mobility += ValKnightMob * x;
 #endif
 
         if( atk & blackKingDanger ) {
@@ -397,10 +393,6 @@ int Position::getEvaluation() const
 
     bb = blackQueensBishops ^ blackQueens;
 
-    if( bitCount(bb) >= 2 ) { // TODO: we ignore promotions for now
-        positionalScore -= Score::BishopPair;
-    }
-
     while( bb.isNotZero() ) {
         pos = bitSearchAndReset( bb );
         PRINT(( "Black bishop at %s\n", sqname(pos) ));
@@ -411,8 +403,7 @@ int Position::getEvaluation() const
 
         PRINT(( "  mobility = %d\n", x ));
 
-        mobOpening -= ValBishopMobOpening * x;
-        mobEndgame -= ValBishopMobEndgame * x;
+        mobility -= ValBishopMob * x;
 
         if( atk & whiteKingDanger ) {
             blackAttack += BishopAtk;
@@ -423,7 +414,7 @@ int Position::getEvaluation() const
         }
 
         if( blackPassed || whitePassed ) {
-            posEndgame -= Score::EndgameBishopWithPassers;
+            posScore -= MakePackedScore( 0, Score::EndgameBishopWithPassers );
         }
     }
 
@@ -431,10 +422,6 @@ int Position::getEvaluation() const
 
     bb = whiteQueensBishops ^ whiteQueens;
 
-    if( bitCount(bb) >= 2 ) { // TODO: we ignore promotions for now
-        positionalScore += Score::BishopPair;
-    }
-
     while( bb.isNotZero() ) {
         pos = bitSearchAndReset( bb );
         PRINT(( "White bishop at %s\n", sqname(pos) ));
@@ -445,8 +432,7 @@ int Position::getEvaluation() const
 
         PRINT(( "  mobility = %d\n", x ));
 
-        mobOpening += ValBishopMobOpening * x;
-        mobEndgame += ValBishopMobEndgame * x;
+        mobility += ValBishopMob * x;
 
         if( atk & blackKingDanger ) {
             whiteAttack += BishopAtk;
@@ -457,7 +443,7 @@ int Position::getEvaluation() const
         }
 
         if( blackPassed || whitePassed ) {
-            posEndgame += Score::EndgameBishopWithPassers;
+            posScore += MakePackedScore( 0, Score::EndgameBishopWithPassers );
         }
     }
 
@@ -466,21 +452,6 @@ int Position::getEvaluation() const
     // pieces but the white and black queens/rooks, which allows any
     // rook or queen to be automatically "x-rayed" thru other rooks or
     // queens of the same color
-    BitBoard    rotNoBlackQR = allPiecesTA1H8;
-    BitBoard    rotNoWhiteQR = allPiecesTA1H8;
-
-    bb = blackQueensRooks;
-    while( bb.isNotZero() ) {
-        pos = bitSearchAndReset( bb );
-        rotNoBlackQR ^= SetTA1H8[pos];
-    }
-
-    bb = whiteQueensRooks;
-    while( bb.isNotZero() ) {
-        pos = bitSearchAndReset( bb );
-        rotNoWhiteQR ^= SetTA1H8[pos];
-    }
-
     BitBoard    allNoBlackQR = allPieces ^ blackQueensRooks;
     BitBoard    allNoWhiteQR = allPieces ^ whiteQueensRooks;
 #endif
@@ -502,9 +473,7 @@ int Position::getEvaluation() const
 #ifndef HAVE_XRAY_QR
         atk = rookAttacks( pos );
 #else
-        atk =
-            (Attacks::RookRank[pos][allNoBlackQR.getRank(pos / 8)]) |
-            (Attacks::RookFile[pos][rotNoBlackQR.getRank(pos % 8)]);
+        atk = Attacks::getRookAttacks( pos, allNoBlackQR );
 #endif
 
 #ifdef HAVE_MOBILITY
@@ -512,13 +481,12 @@ int Position::getEvaluation() const
 
         PRINT(( "  mobility = %d\n", x ));
 
-        mobOpening -= ValRookMobOpening * x;
-        mobEndgame -= ValRookMobEndgame * x;
+        mobility -= ValRookMob * x;
 
         x = bitCount( atk & blackEnemyOrEmpty & ~wpAtk );
 
         if( x <= 1 ) {
-            posEndgame += 150;
+            posScore += MakePackedScore( 0, 150 );
         }
 #endif
 
@@ -537,7 +505,7 @@ int Position::getEvaluation() const
         if( !(Mask::File[file] & allPawns) ) {
             PRINT(( "  on open file (%d)\n", Score::RookOnOpenFile[file] ));
             //positionalScore -= Score::RookOnOpenFile[file];
-            posOpening -= Score::RookOnOpenFile[file];
+            posScore -= MakePackedScore( Score::RookOnOpenFile[file], 0 );
         }
         else if( ! (Mask::File[file] & blackPawns ) ) {
             PRINT(( "  on half-open file\n" ));
@@ -550,8 +518,7 @@ int Position::getEvaluation() const
                 PRINT(( "  on 7th rank\n" ));
 
                 // The king is trapped or there are pawns to attack
-                posOpening -= Score::RookOn7thRank_Opening;
-                posEndgame -= Score::RookOn7thRank_Endgame;
+                posScore -= MakePackedScore( Score::RookOn7thRank_Opening, Score::RookOn7thRank_Endgame );
 
                 // If the king cannot escape from the 2nd rank by moving
                 // behind a pawn we have an "absolute" 2nd rank
@@ -575,9 +542,7 @@ int Position::getEvaluation() const
 #ifndef HAVE_XRAY_QR
         atk = rookAttacks( pos );
 #else
-        atk =
-            (Attacks::RookRank[pos][allNoWhiteQR.getRank(pos / 8)]) |
-            (Attacks::RookFile[pos][rotNoWhiteQR.getRank(pos % 8)]);
+        atk = Attacks::getRookAttacks( pos, allNoWhiteQR );
 #endif
 
 #ifdef HAVE_MOBILITY
@@ -585,15 +550,14 @@ int Position::getEvaluation() const
 
         PRINT(( "  mobility = %d\n", x ));
 
-        mobOpening += ValRookMobOpening * x;
-        mobEndgame += ValRookMobEndgame * x;
+        mobility += ValRookMob * x;
 
         x = bitCount( atk & whiteEnemyOrEmpty & ~bpAtk );
 
         // 8/p7/1p2p3/3p1k2/1R1P3P/P2r2P1/5P2/6K1 w - - 0 35
 
         if( x <= 1 ) {
-            posEndgame -= 150;
+            posScore -= MakePackedScore( 0, 150 );
         }
 #endif
 
@@ -610,7 +574,7 @@ int Position::getEvaluation() const
         if( !(Mask::File[file] & allPawns) ) {
             PRINT(( "  on open file\n", Score::RookOnOpenFile[file] ));
             //positionalScore += Score::RookOnOpenFile[file];
-            posOpening += Score::RookOnOpenFile[file];
+            posScore += MakePackedScore( Score::RookOnOpenFile[file], 0 );
         }
         else if( ! (Mask::File[file] & whitePawns ) ) {
             PRINT(( "  on half-open file\n" ));
@@ -623,8 +587,7 @@ int Position::getEvaluation() const
                 PRINT(( "  on 7th rank\n" ));
 
                 // The king is trapped or there are pawns to attack
-                posOpening += Score::RookOn7thRank_Opening;
-                posEndgame += Score::RookOn7thRank_Endgame;
+                posScore += MakePackedScore( Score::RookOn7thRank_Opening, Score::RookOn7thRank_Endgame );
 
                 // If the king cannot escape from the 7th rank by moving
                 // behind a pawn we have an "absolute" 7th rank
@@ -651,17 +614,13 @@ int Position::getEvaluation() const
 #ifndef HAVE_XRAY_QR
         atk = rookAttacks( pos ) | bishopAttacks( pos );
 #else
-        atk =
-            (Attacks::RookRank[pos][allNoBlackQR.getRank(pos / 8)]) |
-            (Attacks::RookFile[pos][rotNoBlackQR.getRank(pos % 8)]) |
-            bishopAttacks( pos );
+        atk = Attacks::getRookAttacks( pos, allNoBlackQR ) | bishopAttacks( pos );
 #endif
 
 #ifdef HAVE_MOBILITY
         x = bitCount( atk & blackEnemyOrEmpty ) - ExpQueenMob;
 
-        mobOpening -= ValQueenMobOpening * x;
-        mobEndgame -= ValQueenMobEndgame * x;
+        mobility -= ValQueenMob * x;
 #endif
 
         // Attack
@@ -684,17 +643,13 @@ int Position::getEvaluation() const
 #ifndef HAVE_XRAY_QR
         atk = rookAttacks( pos ) | bishopAttacks( pos );
 #else
-        atk =
-            (Attacks::RookRank[pos][allNoWhiteQR.getRank(pos / 8)]) |
-            (Attacks::RookFile[pos][rotNoWhiteQR.getRank(pos % 8)]) |
-            bishopAttacks( pos );
+        atk = Attacks::getRookAttacks( pos, allNoWhiteQR ) | bishopAttacks( pos );
 #endif
 
 #ifdef HAVE_MOBILITY
         x = bitCount( atk & whiteEnemyOrEmpty ) - ExpQueenMob;
 
-        mobOpening += ValQueenMobOpening * x;
-        mobEndgame += ValQueenMobEndgame * x;
+        mobility += ValQueenMob * x;
 #endif
 
         // Attack
@@ -717,14 +672,14 @@ int Position::getEvaluation() const
     int whiteKingDefects = 0;
 
     if( RankOfSquare( blackKingSquare ) == 7 ) {
-        blackKingDefects = evaluateKingShield( blackKingSquare, Black );
+        blackKingDefects = entry->getBlackKingShield( FileOfSquare( blackKingSquare ) );
     }
     else {
         blackKingDefects = imin( 7, 3*(7 - RankOfSquare( blackKingSquare )) );
     }
 
     if( RankOfSquare( whiteKingSquare ) == 0 ) {
-        whiteKingDefects = evaluateKingShield( whiteKingSquare, White );
+        whiteKingDefects = entry->getWhiteKingShield( FileOfSquare( whiteKingSquare ) );
     }
     else {
         whiteKingDefects = imin( 7, 3*RankOfSquare( whiteKingSquare ) );
@@ -742,8 +697,8 @@ int Position::getEvaluation() const
     // TODO: not entirely correct... it may happen that the shield is completely
     // destroyed and gets a serious penalty, then the king will just move one step
     // towards the center in order to get the "secondary" penalty, which is smaller!
-    posOpening += KingDefectsPenalty[ blackKingDefects ];
-    posOpening -= KingDefectsPenalty[ whiteKingDefects ];
+    posScore += MakePackedScore( KingDefectsPenalty[ blackKingDefects ], 0 );
+    posScore -= MakePackedScore( KingDefectsPenalty[ whiteKingDefects ], 0 );
 
     int blackAttackScore = 0;
     int whiteAttackScore = 0;
@@ -790,23 +745,22 @@ int Position::getEvaluation() const
     PRINT(( "Material = %d\n", materialScore ));
     PRINT(( "King attack for black = %d\n", blackAttackScore ));
     PRINT(( "King attack for white = %d\n", whiteAttackScore ));
-    PRINT(( "Piece/square = %d / %d\n", pstScoreOpening, pstScoreEndgame ));
-    PRINT(( "Mobility = %d / %d\n", mobOpening, mobEndgame ));
-    PRINT(( "Pawn = %d / %d\n", pawnOpening, pawnEndgame ));
-    PRINT(( "Positional = %d / %d + %d\n", posOpening, posEndgame, positionalScore ));
+    PRINT(( "Piece/square = %d / %d\n", GetOpeningScore( pstScore ), GetEndgameScore( pstScore ) ));
+    PRINT(( "Mobility = %d / %d\n", GetOpeningScore( mobility ), GetEndgameScore( mobility ) ));
+    PRINT(( "Pawn = %d / %d\n", GetOpeningScore( pawnScore ), GetEndgameScore( pawnScore ) ));
+    PRINT(( "Positional = %d / %d + %d\n", GetOpeningScore( posScore ), GetEndgameScore( posScore ), positionalScore ));
 
     result += materialScore + whiteAttackScore - blackAttackScore;
 
+    // All the terms that depend on the stage are interpolated at once
+    PackedScore stagedScore = pstScore + mobility + pawnScore + posScore + MakePackedScore( positionalScore, positionalScore );
+
     PRINT(( "Interpolation = %d -> %d : %d\n",
-        ( pstScoreOpening + mobOpening + pawnOpening + posOpening + positionalScore ),
-        ( pstScoreEndgame + mobEndgame + pawnEndgame + posEndgame + positionalScore ),
+        GetOpeningScore( stagedScore ),
+        GetEndgameScore( stagedScore ),
+        GetStageScore( stagedScore, stage ) ));
 
-        (( pstScoreOpening + mobOpening + pawnOpening + posOpening + positionalScore )*(stage) +
-         ( pstScoreEndgame + mobEndgame + pawnEndgame + posEndgame + positionalScore )*(2*Stage_Max-stage)) / (2*Stage_Max) ));
-
-    result += (
-        ( pstScoreOpening + mobOpening + pawnOpening + posOpening + positionalScore )*(stage) +
-        ( pstScoreEndgame + mobEndgame + pawnEndgame + posEndgame + positionalScore )*(2*Stage_Max-stage)) / (2*Stage_Max);
+    result += GetStageScore( stagedScore, stage );
 
     PRINT(( "Result = %d (stage = %d)\n", result, stage ));
 
@@ -817,13 +771,12 @@ int Position::getEvaluation() const
     }
     */
 
-    // If a side thinks it's winning but it's not, adjust the score accordingly
-    if( result > 0 && ! whiteCanWin ) {
-        result = -5;
+    // If a side thinks it's winning but it can hardly win or not at all, adjust the score accordingly
+    if( result > 0 ) {
+        result = material.whiteCanWin() ? result * material.whiteScale / MaterialInfo::ScaleNormal : -5;
     }
-
-    if( result < 0 && ! blackCanWin ) {
-        result = +5;
+    else if( result < 0 ) {
+        result = material.blackCanWin() ? result * material.blackScale / MaterialInfo::ScaleNormal : +5;
     }
 
     // Roundup the score to help MTD(f) converge faster
@@ -836,8 +789,7 @@ int Position::getEvaluation() const
         }
     }
 
-    ev_item->code = hashCode.toUnsigned();
-    ev_item->eval = result;
+    evalCache->store( *this, result );
 
     return result;
 }
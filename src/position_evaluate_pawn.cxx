@@ -103,6 +103,9 @@ static bool initialize = true;
     - isolated pawns;
     - doubled pawns;
     - backward pawns.
+
+    The entry also keeps what the main evaluation needs about pawns only: passed
+    pawns, squares attacked by pawns and the king shields for each king file.
 */
 PawnHashEntry * Position::evaluatePawnStructure() const
 {
@@ -402,6 +405,39 @@ PawnHashEntry * Position::evaluatePawnStructure() const
         pawnFlags1,
         pawnFlags2 );
 
+    entry->blackPassed = 0;
+    entry->whitePassed = 0;
+
+    bb = blackPawns;
+
+    while( bb.isNotZero() ) {
+        sq = bitSearchAndReset( bb );
+
+        if( (Mask::BlackPassed[sq] & whitePawns).isZero() && (Mask::SquaresTo1stRank[sq] & blackPawns).isZero() ) {
+            entry->blackPassed.setBit( sq );
+        }
+    }
+
+    bb = whitePawns;
+
+    while( bb.isNotZero() ) {
+        sq = bitSearchAndReset( bb );
+
+        if( (Mask::WhitePassed[sq] & blackPawns).isZero() && (Mask::SquaresTo8thRank[sq] & whitePawns).isZero() ) {
+            entry->whitePassed.setBit( sq );
+        }
+    }
+
+    entry->blackPawnAttacks = ((blackPawns & Mask::NotFile[0]) >> 9) | ((blackPawns & Mask::NotFile[7]) >> 7);
+    entry->whitePawnAttacks = ((whitePawns & Mask::NotFile[7]) << 9) | ((whitePawns & Mask::NotFile[0]) << 7);
+
+    entry->blackKingShield = 0;
+    entry->whiteKingShield = 0;
+
+    for( int file=0; file<8; file++ ) {
+        entry->setKingShield( file, evaluateKingShield( A8 + file, Black ), evaluateKingShield( A1 + file, White ) );
+    }
+
     return entry;
 }
 
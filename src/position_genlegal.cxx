@@ -0,0 +1,272 @@
+/*
+    Kiwi
+    Legal move generation
+
+    Copyright (c) 1999-2004,2005 Alessandro Scotti
+    http://www.ascotti.org/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include "attacks.h"
+#include "board.h"
+#include "bitboard.h"
+#include "counters.h"
+#include "mask.h"
+#include "move.h"
+#include "movelist.h"
+#include "position.h"
+#include "sidetraits.h"
+
+/*
+    Legal move generation.
+
+    Checking and pinned pieces are computed once per position: when in check,
+    all moves but those of the king must capture the checking piece or interpose
+    on its line, and a pinned piece can only move between the king and the pinner.
+    The king cannot move to an attacked square, which is tested with the king
+    removed from the board (so it does not hide behind itself from a slider).
+    En-passant captures remove two pieces from the board and are verified one by one.
+
+    Moves come in the same order as generateMoves() (or generateCheckEscapes() when
+    in check), so both generators give the same list once illegal moves are removed
+    from the latter, and searches are not affected by the choice.
+*/
+
+int Position::useLegalMoveGenerator = 1;
+
+// Adds the moves of a piece from "from" to the squares in "board"
+#define addLegalMoves( moves, from, board )                     \
+    while( board.isNotZero() ) {                                \
+        int to = bitSearchAndReset( board );                    \
+        moves.add( from, to );                                  \
+    }
+
+// Adds the pawn moves to the squares in "board", each from the square "delta"
+// below the target, skipping pinned pawns that would leave their line and
+// illegal en-passant captures
+#define addLegalPawnMoves( moves, board, delta, Us )            \
+    while( board.isNotZero() ) {                                \
+        int to = bitSearchAndReset( board );                    \
+        int from = to - (delta);                                \
+        if( pinned.getBit( from ) && ! pinRay[from].getBit( to ) ) continue; \
+        if( to == enPassantSquare && ! isLegalEnPassant<Side>( from, to, checkers ) ) continue; \
+        if( RankOfSquare(to) == Us::PromotionRank ) {           \
+            moves.add( from, to, Us::Bishop );                  \
+            moves.add( from, to, Us::Knight );                  \
+            moves.add( from, to, Us::Rook );                    \
+            moves.add( from, to, Us::Queen );                   \
+        }                                                       \
+        else {                                                  \
+            moves.add( from, to );                              \
+        }                                                       \
+    }
+
+/*
+    Returns true if the specified en-passant capture does not leave the king in check.
+*/
+template<int Side>
+bool Position::isLegalEnPassant( int from, int to, const BitBoard & checkers ) const
+{
+    typedef SideTraits<Side>                Us;
+    typedef SideTraits<OppositeSide(Side)>  Them;
+
+    int         king = Us::kingSquare(*this);
+    int         captured = to - Us::Forward;
+    BitBoard    queensRooks = Them::queensRooks(*this);
+    BitBoard    queensBishops = Them::queensBishops(*this);
+
+    // Non-sliding pieces still giving check, unless it's the captured pawn
+    BitBoard    others = checkers & ~(queensRooks | queensBishops);
+
+    others.clrBit( captured );
+
+    if( others.isNotZero() ) {
+        return false;
+    }
+
+    // Sliders, with both pawns moved
+    BitBoard    occupied = allPieces ^ BitBoard::Set[from] ^ BitBoard::Set[captured] ^ BitBoard::Set[to];
+
+    if( Attacks::getRookAttacks( king, occupied ) & queensRooks ) {
+        return false;
+    }
+
+    if( Attacks::getBishopAttacks( king, occupied ) & queensBishops ) {
+        return false;
+    }
+
+    return true;
+}
+
+/*
+    Returns true if the specified square is attacked by the opponent of "Side",
+    with the specified pieces on the board.
+*/
+template<int Side>
+bool Position::isSquareAttackedWith( int square, const BitBoard & occupied ) const
+{
+    typedef SideTraits<Side>                Us;
+    typedef SideTraits<OppositeSide(Side)>  Them;
+
+    if( Attacks::Knight[square] & Them::knights(*this) ) return true;
+    if( Us::pawnAttacks()[square] & Them::pawns(*this) ) return true;
+    if( Attacks::KingDistance[square][Them::kingSquare(*this)] <= 1 ) return true;
+    if( Attacks::getRookAttacks( square, occupied ) & Them::queensRooks(*this) ) return true;
+    if( Attacks::getBishopAttacks( square, occupied ) & Them::queensBishops(*this) ) return true;
+
+    return false;
+}
+
+/*
+    Generates all the legal moves from the current position.
+*/
+void Position::generateLegalMoves( MoveList & moves ) const
+{
+    if( sideToPlay == Black ) {
+        generateLegalMoves<Black>( moves );
+    }
+    else {
+        generateLegalMoves<White>( moves );
+    }
+}
+
+template<int Side>
+void Position::generateLegalMoves( MoveList & moves ) const
+{
+    typedef SideTraits<Side>                Us;
+    typedef SideTraits<OppositeSide(Side)>  Them;
+
+    const BitBoard & own = Us::pieces(*this);
+    const BitBoard & enemy = Them::pieces(*this);
+    BitBoard    bb;
+    BitBoard    wb;
+    int         king = Us::kingSquare(*this);
+    int         pos;
+
+    int enPassantSquare = (boardFlags & EnPassantSquareMask) - EnPassantAvailable;
+
+    Counters::callsToGenMoves++;
+
+    BitBoard    checkers = getAttacksToSquare( king, OppositeSide(Side) );
+
+    // Find pinned pieces: look from the king thru our own pieces for enemy sliders,
+    // a piece is pinned if it's the only one between the king and the slider
+    BitBoard    pinned;
+    BitBoard    pinRay[64];     // Squares a pinned piece can move to (valid for pinned pieces only)
+
+    pinned.clear();
+
+    wb = (Attacks::getRookAttacks( king, enemy ) & Them::queensRooks(*this)) |
+         (Attacks::getBishopAttacks( king, enemy ) & Them::queensBishops(*this));
+
+    while( wb.isNotZero() ) {
+        int pinner = bitSearchAndReset( wb );
+
+        bb = Attacks::SquaresBetween[king][pinner] & allPieces;
+
+        if( (bb & own).isNotZero() && (bb.data & (bb.data - 1)) == 0 ) {
+            pos = bitSearch( bb );
+
+            pinned.setBit( pos );
+            pinRay[pos] = Attacks::SquaresBetween[king][pinner] | BitBoard::Set[pinner];
+        }
+    }
+
+    // Get the squares where pieces other than the king can move to: if in check,
+    // they must capture the checking piece or interpose (with two checks, only
+    // the king can move)
+    BitBoard    targets = ~own;
+
+    if( checkers.isNotZero() ) {
+        if( (checkers.data & (checkers.data - 1)) != 0 ) {
+            targets.clear();
+        }
+        else {
+            pos = bitSearch( checkers );
+            targets = Attacks::SquaresBetween[pos][king] | BitBoard::Set[pos];
+        }
+    }
+
+    if( targets.isNotZero() ) {
+        BitBoard    emptySquares = ~allPieces;
+
+        // Knights (a pinned knight can never move)
+        wb = Us::knights(*this) & ~pinned;
+        while( wb.isNotZero() ) {
+            pos = bitSearchAndReset( wb );
+            bb = Attacks::Knight[pos] & targets;
+            addLegalMoves( moves, pos, bb );
+        }
+
+        // Rooks and queen "rook movement"
+        wb = Us::queensRooks(*this);
+        while( wb.isNotZero() ) {
+            pos = bitSearchAndReset( wb );
+            bb = rookAttacks( pos ) & targets;
+            if( pinned.getBit( pos ) ) bb &= pinRay[pos];
+            addLegalMoves( moves, pos, bb );
+        }
+
+        // Bishops and queen "bishop movement"
+        wb = Us::queensBishops(*this);
+        while( wb.isNotZero() ) {
+            pos = bitSearchAndReset( wb );
+            bb = bishopAttacks( pos ) & targets;
+            if( pinned.getBit( pos ) ) bb &= pinRay[pos];
+            addLegalMoves( moves, pos, bb );
+        }
+
+        // Pawns (en-passant is always tried, as the captured pawn may be the one giving check)
+        BitBoard    pp = enemy & targets;
+
+        if( enPassantSquare >= 0 ) {
+            pp.setBit( enPassantSquare );
+        }
+
+        // Advance
+        wb = Us::pawnAdvance( Us::pawns(*this) ) & emptySquares;
+        bb = Us::pawnAdvance( wb & Mask::Rank[Us::DoubleStepRank] ) & emptySquares & targets;
+        wb &= targets;
+
+        addLegalPawnMoves( moves, wb, Us::Forward, Us );
+        addLegalPawnMoves( moves, bb, 2*Us::Forward, Us );
+
+        // Captures
+        wb = Us::pawnCapture1( Us::pawns(*this) ) & pp;
+        addLegalPawnMoves( moves, wb, Us::Capture1, Us );
+        wb = Us::pawnCapture2( Us::pawns(*this) ) & pp;
+        addLegalPawnMoves( moves, wb, Us::Capture2, Us );
+    }
+
+    // King
+    BitBoard    occupied = allPieces ^ BitBoard::Set[king];
+
+    wb = Attacks::King[king] & ~own;
+    while( wb.isNotZero() ) {
+        pos = bitSearchAndReset( wb );
+
+        if( ! isSquareAttackedWith<Side>( pos, occupied ) ) {
+            moves.add( king, pos );
+        }
+    }
+
+    // Castling
+    if( checkers.isZero() ) {
+        generateCastling<Side>( moves, ~allPieces );
+    }
+}
+
+template void Position::generateLegalMoves<White>( MoveList & moves ) const;
+template void Position::generateLegalMoves<Black>( MoveList & moves ) const;
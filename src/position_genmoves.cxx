@@ -31,6 +31,7 @@
 #include "movelist.h"
 #include "position.h"
 #include "score.h"
+#include "sidetraits.h"
 #include "undoinfo.h"
 
 #define addMoves( moves, from, board )                          \
@@ -41,45 +42,99 @@
         }                                                       \
     }
 
-#define addWhitePawnMovesNoPromotion( moves, board, from )  \
-        while( board.isNotZero() ) { \
-            pos = bitSearchAndReset(board); \
-            moves.add( from, pos );                              \
+// Adds the pawn moves to the squares in "board", each from the square "delta" below
+// the target (promotions are generated only if the pawns may reach the last rank)
+#define addPawnMovesNoPromotion( moves, board, delta )      \
+    while( board.isNotZero() ) {                            \
+        int to = bitSearchAndReset(board);                  \
+        moves.add( to - (delta), to );                      \
     }
 
-#define addWhitePawnMoves( moves, board, from )             \
-        while( board.isNotZero() ) { \
-            pos = bitSearchAndReset(board); \
-        if( pos >= A8 ) {                                   \
-            moves.add( from, pos, WhiteBishop );            \
-            moves.add( from, pos, WhiteKnight );            \
-            moves.add( from, pos, WhiteRook );              \
-            moves.add( from, pos, WhiteQueen );             \
+#define addPawnMoves( moves, board, delta, Us )             \
+    while( board.isNotZero() ) {                            \
+        int to = bitSearchAndReset(board);                  \
+        int from = to - (delta);                            \
+        if( RankOfSquare(to) == Us::PromotionRank ) {       \
+            moves.add( from, to, Us::Bishop );              \
+            moves.add( from, to, Us::Knight );              \
+            moves.add( from, to, Us::Rook );                \
+            moves.add( from, to, Us::Queen );               \
         }                                                   \
         else {                                              \
-            moves.add( from, pos );                         \
+            moves.add( from, to );                          \
         }                                                   \
     }
 
-#define addBlackPawnMovesNoPromotion( moves, board, from )  \
-        while( board.isNotZero() ) { \
-            pos = bitSearchAndReset(board); \
-            moves.add( from, pos );                              \
+/*
+    Move generation is implemented once for both sides, with templates
+    on the side to move (see sidetraits.h). The public functions simply
+    dispatch on the side to play.
+*/
+void Position::generateMoves( MoveList & moves ) const
+{
+    if( sideToPlay == Black ) {
+        generateMoves<Black>( moves );
+    }
+    else {
+        generateMoves<White>( moves );
     }
+}
 
-#define addBlackPawnMoves( moves, board, from )             \
-        while( board.isNotZero() ) { \
-            pos = bitSearchAndReset(board); \
-        if( pos <= H1 ) {                                   \
-            moves.add( from, pos, BlackBishop );            \
-            moves.add( from, pos, BlackKnight );            \
-            moves.add( from, pos, BlackRook );              \
-            moves.add( from, pos, BlackQueen );             \
-        }                                                   \
-        else {                                              \
-            moves.add( from, pos );                         \
-        }                                                   \
+void Position::generateTactical( MoveList & moves ) const
+{
+    if( sideToPlay == Black ) {
+        generateTactical<Black>( moves );
     }
+    else {
+        generateTactical<White>( moves );
+    }
+}
+
+void Position::generateNonTactical( MoveList & moves ) const
+{
+    if( sideToPlay == Black ) {
+        generateNonTactical<Black>( moves );
+    }
+    else {
+        generateNonTactical<White>( moves );
+    }
+}
+
+void Position::generateCheckEscapes( MoveList & moves ) const
+{
+    if( sideToPlay == Black ) {
+        generateCheckEscapes<Black>( moves );
+    }
+    else {
+        generateCheckEscapes<White>( moves );
+    }
+}
+
+/*
+    Generates the castling moves to the specified target squares.
+
+    Note that there is no need to verify that the king is not in check,
+    because that would be handled by a specific move-generation function.
+*/
+template<int Side>
+void Position::generateCastling( MoveList & moves, const BitBoard & targets ) const
+{
+    typedef SideTraits<Side>    Us;
+
+    if( (boardFlags & Us::CastleKing) && targets.getBit( Us::KingCastleTo ) &&
+        (board.piece[Us::KingRookTo] == None) && (board.piece[Us::KingCastleTo] == None) &&
+        !isSquareAttackedBy(Us::KingRookTo,OppositeSide(Side)) && !isSquareAttackedBy(Us::KingCastleTo,OppositeSide(Side)) )
+    {
+        moves.add( Us::kingSquare(*this), Us::KingCastleTo );
+    }
+
+    if( (boardFlags & Us::CastleQueen) && targets.getBit( Us::QueenCastleTo ) &&
+        (board.piece[Us::QueenRookTo] == None) && (board.piece[Us::QueenCastleTo] == None) && (board.piece[Us::QueenKnight] == None) &&
+        !isSquareAttackedBy(Us::QueenRookTo,OppositeSide(Side)) && !isSquareAttackedBy(Us::QueenCastleTo,OppositeSide(Side)) )
+    {
+        moves.add( Us::kingSquare(*this), Us::QueenCastleTo );
+    }
+}
 
 /*
     Generates all the pseudo-legal moves that the specified side
@@ -87,10 +142,14 @@
     Some of the generated moves may leave the king in check: this is handled
     later when we actually try to perform the move on the board.
 */
+template<int Side>
 void Position::generateMoves( MoveList & moves ) const
 {
+    typedef SideTraits<Side>                Us;
+    typedef SideTraits<OppositeSide(Side)>  Them;
+
     BitBoard    emptySquares    = ~allPieces;
-    BitBoard    enemyOrEmpty;
+    BitBoard    enemyOrEmpty    = ~Us::pieces(*this);
     BitBoard    bb;
     BitBoard    wb;
 
@@ -99,242 +158,125 @@ void Position::generateMoves( MoveList & moves ) const
 
     Counters::callsToGenMoves++;
 
-    if( sideToPlay == Black ) {
-        enemyOrEmpty = ~blackPieces;
-
-        // Knights
-        wb = blackKnights;
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            bb = Attacks::Knight[pos] & enemyOrEmpty;
-            addMoves( moves, pos, bb );
-        }
-
-        // Rooks and queen "rook movement"
-        wb = blackQueensRooks;
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            bb  = rookAttacks( pos ) & enemyOrEmpty;
-            addMoves( moves, pos, bb );
-        }
-
-        // Bishops and queen "bishop movement"
-        wb = blackQueensBishops;
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            bb = bishopAttacks( pos ) & enemyOrEmpty;
-            addMoves( moves, pos, bb );
-        }
-
-        // Pawns: advance
-        wb = (blackPawns >> 8) & emptySquares;
-        bb = ((wb & Mask::Rank[5]) >> 8) & emptySquares;
-
-        addBlackPawnMoves( moves, wb, pos+8 );
-        addBlackPawnMovesNoPromotion( moves, bb, pos+16 );
-
-        // Pawns: captures
-        BitBoard    pp = whitePieces;
-        if( enPassantSquare >= 0 ) pp.setBit( enPassantSquare );
-
-        wb = ((blackPawns & Mask::NotFile[0]) >> 9) & pp;
-        addBlackPawnMoves( moves, wb, pos+9 );
-        wb = ((blackPawns & Mask::NotFile[7]) >> 7) & pp;
-        addBlackPawnMoves( moves, wb, pos+7 );
-
-        // King
-        wb = Attacks::King[ blackKingSquare ] & enemyOrEmpty;
-        addMoves( moves, blackKingSquare, wb );
-
-        // Castling (note that there is no need to verify that the king is not in check,
-        // because that would be handled by a specific move-generation function
-        if( (boardFlags & BlackCastleKing) && 
-            (board.piece[F8] == None) && (board.piece[G8] == None) &&
-            !isSquareAttackedBy(F8,White) && !isSquareAttackedBy(G8,White) )
-        {
-            moves.add( blackKingSquare, G8 );
-        }
+    // Knights
+    wb = Us::knights(*this);
+    while( wb.isNotZero() ) {
+        pos = bitSearchAndReset( wb );
+        bb = Attacks::Knight[pos] & enemyOrEmpty;
+        addMoves( moves, pos, bb );
+    }
 
-        if( (boardFlags & BlackCastleQueen) && 
-            (board.piece[D8] == None) && (board.piece[C8] == None) && (board.piece[B8] == None) && 
-            !isSquareAttackedBy(D8,White) && !isSquareAttackedBy(C8,White) )
-        {
-            moves.add( blackKingSquare, C8 );
-        }
+    // Rooks and queen "rook movement"
+    wb = Us::queensRooks(*this);
+    while( wb.isNotZero() ) {
+        pos = bitSearchAndReset( wb );
+        bb  = rookAttacks( pos ) & enemyOrEmpty;
+        addMoves( moves, pos, bb );
     }
-    else { // White
-        enemyOrEmpty = ~whitePieces;
 
-        // Knights
-        wb = whiteKnights;
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            bb = Attacks::Knight[pos] & enemyOrEmpty;
-            addMoves( moves, pos, bb );
-        }
+    // Bishops and queen "bishop movement"
+    wb = Us::queensBishops(*this);
+    while( wb.isNotZero() ) {
+        pos = bitSearchAndReset( wb );
+        bb = bishopAttacks( pos ) & enemyOrEmpty;
+        addMoves( moves, pos, bb );
+    }
 
-        // Rooks and queen "rook movement"
-        wb = whiteQueensRooks;
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            bb = rookAttacks( pos ) & enemyOrEmpty;
-            addMoves( moves, pos, bb );
-        }
+    // Pawns: advance
+    wb = Us::pawnAdvance( Us::pawns(*this) ) & emptySquares;
+    bb = Us::pawnAdvance( wb & Mask::Rank[Us::DoubleStepRank] ) & emptySquares;
 
-        // Bishops and queen "bishop movement"
-        wb = whiteQueensBishops;
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            bb = bishopAttacks( pos ) & enemyOrEmpty;
-            addMoves( moves, pos, bb );
-        }
+    addPawnMoves( moves, wb, Us::Forward, Us );
+    addPawnMovesNoPromotion( moves, bb, 2*Us::Forward );
 
-        // Pawns: advance
-        wb = (whitePawns << 8) & emptySquares;
-        bb = ((wb & Mask::Rank[2]) << 8) & emptySquares;
+    // Pawns: captures
+    BitBoard    pp = Them::pieces(*this);
+    if( enPassantSquare >= 0 ) pp.setBit( enPassantSquare );
 
-        addWhitePawnMoves( moves, wb, pos-8 );
-        addWhitePawnMovesNoPromotion( moves, bb, pos-16 );
+    wb = Us::pawnCapture1( Us::pawns(*this) ) & pp;
+    addPawnMoves( moves, wb, Us::Capture1, Us );
+    wb = Us::pawnCapture2( Us::pawns(*this) ) & pp;
+    addPawnMoves( moves, wb, Us::Capture2, Us );
 
-        // Pawns: captures
-        BitBoard    pp = blackPieces;
-        if( enPassantSquare >= 0 ) pp.setBit( enPassantSquare );
-
-        wb = ((whitePawns & Mask::NotFile[7]) << 9) & pp;
-        addWhitePawnMoves( moves, wb, pos-9 );
-        wb = ((whitePawns & Mask::NotFile[0]) << 7) & pp;
-        addWhitePawnMoves( moves, wb, pos-7 );
-
-        // King
-        wb = Attacks::King[ whiteKingSquare ] & enemyOrEmpty;
-        addMoves( moves, whiteKingSquare, wb );
-
-        // Castling (note that there is no need to verify that the king is not in check,
-        // because that would be handled by a specific move-generation function
-        if( (boardFlags & WhiteCastleKing) && 
-            (board.piece[F1] == None) && (board.piece[G1] == None) &&
-            !isSquareAttackedBy(F1,Black) && !isSquareAttackedBy(G1,Black) )
-        {
-            moves.add( whiteKingSquare, G1 );
-        }
+    // King
+    wb = Attacks::King[ Us::kingSquare(*this) ] & enemyOrEmpty;
+    addMoves( moves, Us::kingSquare(*this), wb );
 
-        if( (boardFlags & WhiteCastleQueen) && 
-            (board.piece[D1] == None) && (board.piece[C1] == None) && (board.piece[B1] == None) &&
-            !isSquareAttackedBy(D1,Black) && !isSquareAttackedBy(C1,Black) )
-        {
-            moves.add( whiteKingSquare, C1 );
-        }
-    }
+    // Castling
+    generateCastling<Side>( moves, emptySquares );
 }
 
 /*
-    Generates all the pseudo-legal captures that the specified side
-    can do from the current position.
+    Generates all the pseudo-legal captures and promotions that the
+    specified side can do from the current position.
 */
+template<int Side>
 void Position::generateTactical( MoveList & moves ) const
 {
+    typedef SideTraits<Side>                Us;
+    typedef SideTraits<OppositeSide(Side)>  Them;
+
+    const BitBoard & enemy = Them::pieces(*this);
     BitBoard    bb;
     BitBoard    wb;
 
     int pos;
     int enPassantSquare = (boardFlags & EnPassantSquareMask) - EnPassantAvailable;
 
-    if( sideToPlay == Black ) {
-        // King
-        wb = Attacks::King[ blackKingSquare ] & whitePieces;
-        addMoves( moves, blackKingSquare, wb );
-
-        // Rooks and queen "rook movement"
-        wb = blackQueensRooks;
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            bb  = rookAttacks( pos ) & whitePieces;
-            addMoves( moves, pos, bb );
-        }
-
-        // Bishops and queen "bishop movement"
-        wb = blackQueensBishops;
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            bb = bishopAttacks( pos ) & whitePieces;
-            addMoves( moves, pos, bb );
-        }
-
-        // Knights
-        wb = blackKnights;
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            bb = Attacks::Knight[pos] & whitePieces;
-            addMoves( moves, pos, bb );
-        }
-
-        // Pawns: captures
-        BitBoard    pp = whitePieces;
-        if( enPassantSquare >= 0 ) pp.setBit( enPassantSquare );
-
-        wb = ((blackPawns & Mask::NotFile[0]) >> 9) & pp;
-        addBlackPawnMoves( moves, wb, pos+9 );
-        wb = ((blackPawns & Mask::NotFile[7]) >> 7) & pp;
-        addBlackPawnMoves( moves, wb, pos+7 );
-
-        // Pawns: promotions
-        wb = ((blackPawns & Mask::Rank[1]) >> 8) & (~allPieces);
+    // King
+    wb = Attacks::King[ Us::kingSquare(*this) ] & enemy;
+    addMoves( moves, Us::kingSquare(*this), wb );
 
-        addBlackPawnMoves( moves, wb, pos+8 );
+    // Rooks and queen "rook movement"
+    wb = Us::queensRooks(*this);
+    while( wb.isNotZero() ) {
+        pos = bitSearchAndReset( wb );
+        bb  = rookAttacks( pos ) & enemy;
+        addMoves( moves, pos, bb );
     }
-    else {
-        // King
-        wb = Attacks::King[ whiteKingSquare ] & blackPieces;
-        addMoves( moves, whiteKingSquare, wb );
-
-        // Rooks and queen "rook movement"
-        wb = whiteQueensRooks;
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            bb  = rookAttacks( pos ) & blackPieces;
-            addMoves( moves, pos, bb );
-        }
 
-        // Bishops and queen "bishop movement"
-        wb = whiteQueensBishops;
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            bb = bishopAttacks( pos ) & blackPieces;
-            addMoves( moves, pos, bb );
-        }
+    // Bishops and queen "bishop movement"
+    wb = Us::queensBishops(*this);
+    while( wb.isNotZero() ) {
+        pos = bitSearchAndReset( wb );
+        bb = bishopAttacks( pos ) & enemy;
+        addMoves( moves, pos, bb );
+    }
 
-        // Knights
-        wb = whiteKnights;
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            bb = Attacks::Knight[pos] & blackPieces;
-            addMoves( moves, pos, bb );
-        }
+    // Knights
+    wb = Us::knights(*this);
+    while( wb.isNotZero() ) {
+        pos = bitSearchAndReset( wb );
+        bb = Attacks::Knight[pos] & enemy;
+        addMoves( moves, pos, bb );
+    }
 
-        // Pawns: captures
-        BitBoard    pp = blackPieces;
-        if( enPassantSquare >= 0 ) pp.setBit( enPassantSquare );
+    // Pawns: captures
+    BitBoard    pp = enemy;
+    if( enPassantSquare >= 0 ) pp.setBit( enPassantSquare );
 
-        wb = ((whitePawns & Mask::NotFile[7]) << 9) & pp;
-        addWhitePawnMoves( moves, wb, pos-9 );
-        wb = ((whitePawns & Mask::NotFile[0]) << 7) & pp;
-        addWhitePawnMoves( moves, wb, pos-7 );
+    wb = Us::pawnCapture1( Us::pawns(*this) ) & pp;
+    addPawnMoves( moves, wb, Us::Capture1, Us );
+    wb = Us::pawnCapture2( Us::pawns(*this) ) & pp;
+    addPawnMoves( moves, wb, Us::Capture2, Us );
 
-        // Pawns: promotions
-        wb = ((whitePawns & Mask::Rank[6]) << 8) & (~allPieces);
+    // Pawns: promotions
+    wb = Us::pawnAdvance( Us::pawns(*this) & Mask::Rank[Us::PrePromotionRank] ) & (~allPieces);
 
-        addWhitePawnMoves( moves, wb, pos-8 );
-    }
+    addPawnMoves( moves, wb, Us::Forward, Us );
 }
 
 /*
     Generates all the pseudo-legal non-captures that the specified side
     can do from the current position.
-*/
 
-// TODO: do not generate pawn promotions here
+    Pawn promotions are tactical moves and are not generated here.
+*/
+template<int Side>
 void Position::generateNonTactical( MoveList & moves ) const
 {
+    typedef SideTraits<Side>    Us;
+
     BitBoard    emptySquares    = ~allPieces;
     BitBoard    bb;
     BitBoard    wb;
@@ -343,109 +285,44 @@ void Position::generateNonTactical( MoveList & moves ) const
 
     Counters::callsToGenMoves++;
 
-    if( sideToPlay == Black ) {
-        // Knights
-        wb = blackKnights;
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            bb = Attacks::Knight[pos] & emptySquares;
-            addMoves( moves, pos, bb );
-        }
-
-        // Rooks and queen "rook movement"
-        wb = blackQueensRooks;
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            bb  = rookAttacks( pos ) & emptySquares;
-            addMoves( moves, pos, bb );
-        }
-
-        // Bishops and queen "bishop movement"
-        wb = blackQueensBishops;
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            bb = bishopAttacks( pos ) & emptySquares;
-            addMoves( moves, pos, bb );
-        }
+    // Knights
+    wb = Us::knights(*this);
+    while( wb.isNotZero() ) {
+        pos = bitSearchAndReset( wb );
+        bb = Attacks::Knight[pos] & emptySquares;
+        addMoves( moves, pos, bb );
+    }
 
-        // Pawns: advance
-        wb = (blackPawns >> 8) & emptySquares;
-        bb = ((wb & Mask::Rank[5]) >> 8) & emptySquares;
-        addBlackPawnMoves( moves, wb, pos+8 );
-        addBlackPawnMovesNoPromotion( moves, bb, pos+16 );
-
-        // King
-        wb = Attacks::King[ blackKingSquare ] & emptySquares;
-        addMoves( moves, blackKingSquare, wb );
-
-        // Castling (note that there is no need to verify that the king is not in check,
-        // because that would be handled by a specific move-generation function)
-        if( (boardFlags & BlackCastleKing) &&
-            (board.piece[F8] == None) && (board.piece[G8] == None) &&
-            !isSquareAttackedBy(F8,White) && !isSquareAttackedBy(G8,White) )
-        {
-            moves.add( blackKingSquare, G8 );
-        }
+    // Rooks and queen "rook movement"
+    wb = Us::queensRooks(*this);
+    while( wb.isNotZero() ) {
+        pos = bitSearchAndReset( wb );
+        bb  = rookAttacks( pos ) & emptySquares;
+        addMoves( moves, pos, bb );
+    }
 
-        if( (boardFlags & BlackCastleQueen) &&
-            (board.piece[D8] == None) && (board.piece[C8] == None) && (board.piece[B8] == None) &&
-            !isSquareAttackedBy(D8,White) && !isSquareAttackedBy(C8,White) )
-        {
-            moves.add( blackKingSquare, C8 );
-        }
+    // Bishops and queen "bishop movement"
+    wb = Us::queensBishops(*this);
+    while( wb.isNotZero() ) {
+        pos = bitSearchAndReset( wb );
+        bb = bishopAttacks( pos ) & emptySquares;
+        addMoves( moves, pos, bb );
     }
-    else { // White
-        // Knights
-        wb = whiteKnights;
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            bb = Attacks::Knight[pos] & emptySquares;
-            addMoves( moves, pos, bb );
-        }
 
-        // Rooks and queen "rook movement"
-        wb = whiteQueensRooks;
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            bb  = rookAttacks( pos ) & emptySquares;
-            addMoves( moves, pos, bb );
-        }
+    // Pawns: advance
+    wb = Us::pawnAdvance( Us::pawns(*this) ) & emptySquares;
+    bb = Us::pawnAdvance( wb & Mask::Rank[Us::DoubleStepRank] ) & emptySquares;
+    wb &= ~Mask::Rank[Us::PromotionRank];
 
-        // Bishops and queen "bishop movement"
-        wb = whiteQueensBishops;
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            bb = bishopAttacks( pos ) & emptySquares;
-            addMoves( moves, pos, bb );
-        }
+    addPawnMovesNoPromotion( moves, wb, Us::Forward );
+    addPawnMovesNoPromotion( moves, bb, 2*Us::Forward );
 
-        // Pawns: advance
-        wb = (whitePawns << 8) & emptySquares;
-        bb = ((wb & Mask::Rank[2]) << 8) & emptySquares;
-
-        addWhitePawnMoves( moves, wb, pos-8 );
-        addWhitePawnMovesNoPromotion( moves, bb, pos-16 );
-
-        // King
-        wb = Attacks::King[ whiteKingSquare ] & emptySquares;
-        addMoves( moves, whiteKingSquare, wb );
-
-        // Castling (note that there is no need to verify that the king is not in check,
-        // because that would be handled by a specific move-generation function)
-        if( (boardFlags & WhiteCastleKing) &&
-            (board.piece[F1] == None) && (board.piece[G1] == None) &&
-            !isSquareAttackedBy(F1,Black) && !isSquareAttackedBy(G1,Black) )
-        {
-            moves.add( whiteKingSquare, G1 );
-        }
+    // King
+    wb = Attacks::King[ Us::kingSquare(*this) ] & emptySquares;
+    addMoves( moves, Us::kingSquare(*this), wb );
 
-        if( (boardFlags & WhiteCastleQueen) &&
-            (board.piece[D1] == None) && (board.piece[C1] == None) && (board.piece[B1] == None) &&
-            !isSquareAttackedBy(D1,Black) && !isSquareAttackedBy(C1,Black) )
-        {
-            moves.add( whiteKingSquare, C1 );
-        }
-    }
+    // Castling
+    generateCastling<Side>( moves, emptySquares );
 }
 
 /*
@@ -456,25 +333,18 @@ void Position::generateNonTactical( MoveList & moves ) const
     however this function usually produces much less moves than the generic
     generation routine.
 */
+template<int Side>
 void Position::generateCheckEscapes( MoveList & moves ) const
 {
+    typedef SideTraits<Side>                Us;
+    typedef SideTraits<OppositeSide(Side)>  Them;
+
     BitBoard    bb, wb;
-    BitBoard    enemyOrEmpty;
-    BitBoard    attacks;
-    int         king;
+    BitBoard    enemyOrEmpty = ~Us::pieces(*this);
+    int         king = Us::kingSquare(*this);
+    BitBoard    attacks = getAttacksToSquare( king, OppositeSide(Side) );
     int         enPassantSquare = (boardFlags & EnPassantSquareMask) - EnPassantAvailable;
 
-    if( sideToPlay == Black ) {
-        enemyOrEmpty = ~blackPieces;
-        king = blackKingSquare;
-        attacks = getAttacksToSquare( king, White );
-    }
-    else {
-        enemyOrEmpty = ~whitePieces;
-        king = whiteKingSquare;
-        attacks = getAttacksToSquare( king, Black );
-    }
-
     int posAttacker1 = bitScanAndResetForward(attacks);
     int posAttacker2 = bitScanAndResetForward(attacks);
 
@@ -489,94 +359,49 @@ void Position::generateCheckEscapes( MoveList & moves ) const
 
         // Now we can use the standard move generation code, but the reduced 
         // set of valid destination squares should produce much less moves
-        if( sideToPlay == Black ) {
-            // Knights
-            wb = blackKnights;
-            while( wb.isNotZero() ) {
-                pos = bitSearchAndReset( wb );
-                bb = Attacks::Knight[pos] & validSquares;
-                addMoves( moves, pos, bb );
-            }
-
-            // Rooks and queen "rook movement"
-            wb = blackQueensRooks;
-            while( wb.isNotZero() ) {
-                pos = bitSearchAndReset( wb );
-                bb  = rookAttacks( pos ) & validSquares;
-                addMoves( moves, pos, bb );
-            }
-
-            // Bishops and queen "bishop movement"
-            wb = blackQueensBishops;
-            while( wb.isNotZero() ) {
-                pos = bitSearchAndReset( wb );
-                bb = bishopAttacks( pos ) & validSquares;
-                addMoves( moves, pos, bb );
-            }
-
-            // Pawns: advance
-            wb = (blackPawns >> 8) & emptySquares;
-            bb = (((wb & Mask::Rank[5]) >> 8) & emptySquares) & validSquares;
-            wb &= validSquares;
-            addBlackPawnMoves( moves, wb, pos+8 );
-            addBlackPawnMovesNoPromotion( moves, bb, pos+16 );
-
-            // Pawns: captures
-            BitBoard    pp = whitePieces;
-            pp &= validSquares;
-            if( enPassantSquare >= 0 ) {
-                pp.setBit( enPassantSquare );
-            }
 
-            wb = ((blackPawns & Mask::NotFile[0]) >> 9) & pp;
-            addBlackPawnMoves( moves, wb, pos+9 );
-            wb = ((blackPawns & Mask::NotFile[7]) >> 7) & pp;
-            addBlackPawnMoves( moves, wb, pos+7 );
+        // Knights
+        wb = Us::knights(*this);
+        while( wb.isNotZero() ) {
+            pos = bitSearchAndReset( wb );
+            bb = Attacks::Knight[pos] & validSquares;
+            addMoves( moves, pos, bb );
         }
-        else {
-            // Knights
-            wb = whiteKnights;
-            while( wb.isNotZero() ) {
-                pos = bitSearchAndReset( wb );
-                bb = Attacks::Knight[pos] & validSquares;
-                addMoves( moves, pos, bb );
-            }
 
-            // Rooks and queen "rook movement"
-            wb = whiteQueensRooks;
-            while( wb.isNotZero() ) {
-                pos = bitSearchAndReset( wb );
-                bb  = rookAttacks( pos ) & validSquares;
-                addMoves( moves, pos, bb );
-            }
+        // Rooks and queen "rook movement"
+        wb = Us::queensRooks(*this);
+        while( wb.isNotZero() ) {
+            pos = bitSearchAndReset( wb );
+            bb  = rookAttacks( pos ) & validSquares;
+            addMoves( moves, pos, bb );
+        }
 
-            // Bishops and queen "bishop movement"
-            wb = whiteQueensBishops;
-            while( wb.isNotZero() ) {
-                pos = bitSearchAndReset( wb );
-                bb = bishopAttacks( pos ) & validSquares;
-                addMoves( moves, pos, bb );
-            }
+        // Bishops and queen "bishop movement"
+        wb = Us::queensBishops(*this);
+        while( wb.isNotZero() ) {
+            pos = bitSearchAndReset( wb );
+            bb = bishopAttacks( pos ) & validSquares;
+            addMoves( moves, pos, bb );
+        }
 
-            // Pawns: advance
-            wb = (whitePawns << 8) & emptySquares;
-            bb = (((wb & Mask::Rank[2]) << 8) & emptySquares) & validSquares;
-            wb &= validSquares;
-            addWhitePawnMoves( moves, wb, pos-8 );
-            addWhitePawnMovesNoPromotion( moves, bb, pos-16 );
-
-            // Pawns: captures
-            BitBoard    pp = blackPieces;
-            pp &= validSquares;
-            if( enPassantSquare >= 0 ) {
-                pp.setBit( enPassantSquare );
-            }
+        // Pawns: advance
+        wb = Us::pawnAdvance( Us::pawns(*this) ) & emptySquares;
+        bb = Us::pawnAdvance( wb & Mask::Rank[Us::DoubleStepRank] ) & emptySquares & validSquares;
+        wb &= validSquares;
+        addPawnMoves( moves, wb, Us::Forward, Us );
+        addPawnMovesNoPromotion( moves, bb, 2*Us::Forward );
 
-            wb = ((whitePawns & Mask::NotFile[7]) << 9) & pp;
-            addWhitePawnMoves( moves, wb, pos-9 );
-            wb = ((whitePawns & Mask::NotFile[0]) << 7) & pp;
-            addWhitePawnMoves( moves, wb, pos-7 );
+        // Pawns: captures
+        BitBoard    pp = Them::pieces(*this);
+        pp &= validSquares;
+        if( enPassantSquare >= 0 ) {
+            pp.setBit( enPassantSquare );
         }
+
+        wb = Us::pawnCapture1( Us::pawns(*this) ) & pp;
+        addPawnMoves( moves, wb, Us::Capture1, Us );
+        wb = Us::pawnCapture2( Us::pawns(*this) ) & pp;
+        addPawnMoves( moves, wb, Us::Capture2, Us );
     }
 
     // King moves must always be tried when under check
@@ -584,6 +409,17 @@ void Position::generateCheckEscapes( MoveList & moves ) const
     addMoves( moves, king, bb );
 }
 
+template void Position::generateCastling<White>( MoveList & moves, const BitBoard & targets ) const;
+template void Position::generateCastling<Black>( MoveList & moves, const BitBoard & targets ) const;
+template void Position::generateMoves<White>( MoveList & moves ) const;
+template void Position::generateMoves<Black>( MoveList & moves ) const;
+template void Position::generateTactical<White>( MoveList & moves ) const;
+template void Position::generateTactical<Black>( MoveList & moves ) const;
+template void Position::generateNonTactical<White>( MoveList & moves ) const;
+template void Position::generateNonTactical<Black>( MoveList & moves ) const;
+template void Position::generateCheckEscapes<White>( MoveList & moves ) const;
+template void Position::generateCheckEscapes<Black>( MoveList & moves ) const;
+
 /*
     Generates all the valid moves from the current position.
 
@@ -593,12 +429,17 @@ void Position::generateCheckEscapes( MoveList & moves ) const
 */
 void Position::generateValidMoves( MoveList & moves, int to ) const
 {
+    moves.reset();
+
+    if( useLegalMoveGenerator && to < 0 ) {
+        generateLegalMoves( moves );
+        return;
+    }
+
     Position pos( *this );
     UndoInfo ui( pos );
     MoveList all;
 
-    moves.reset();
-
     // Generate moves
     if( boardFlags & SideToPlayInCheck ) {
         generateCheckEscapes( all );
@@ -634,6 +475,20 @@ void Position::generateValidMoves( MoveList & moves, int to ) const
 */
 void Position::generateMovesToSquare( MoveList & moves, int to ) const
 {
+    if( sideToPlay == Black ) {
+        generateMovesToSquare<Black>( moves, to );
+    }
+    else {
+        generateMovesToSquare<White>( moves, to );
+    }
+}
+
+template<int Side>
+void Position::generateMovesToSquare( MoveList & moves, int to ) const
+{
+    typedef SideTraits<Side>                Us;
+    typedef SideTraits<OppositeSide(Side)>  Them;
+
     BitBoard    emptySquares    = ~allPieces;
     BitBoard    bb;
     BitBoard    wb;
@@ -643,136 +498,53 @@ void Position::generateMovesToSquare( MoveList & moves, int to ) const
 
     Counters::callsToGenMoves++;
 
-    if( sideToPlay == Black ) {
-        // Knights
-        wb = blackKnights & Attacks::Knight[to];
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            moves.add( pos, to );
-        }
-
-        // Rooks and queen "rook movement"
-        wb = blackQueensRooks & rookAttacks( to );
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            moves.add( pos, to );
-        }
-
-        // Bishops and queen "bishop movement"
-        wb = blackQueensBishops & bishopAttacks( to );
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            moves.add( pos, to );
-        }
-
-        // Pawns: advance
-        wb = (blackPawns >> 8) & emptySquares;
-        bb = ((wb & Mask::Rank[5]) >> 8) & emptySquares;
-
-        wb &= BitBoard::Set[ to ];
-        bb &= BitBoard::Set[ to ];
-
-        addBlackPawnMoves( moves, wb, pos+8 );
-        addBlackPawnMovesNoPromotion( moves, bb, pos+16 );
-
-        // Pawns: captures
-        BitBoard    pp = whitePieces;
-        if( enPassantSquare >= 0 ) pp.setBit( enPassantSquare );
-
-        pp &= BitBoard::Set[ to ];
-
-        wb = ((blackPawns & Mask::NotFile[0]) >> 9) & pp;
-        addBlackPawnMoves( moves, wb, pos+9 );
-        wb = ((blackPawns & Mask::NotFile[7]) >> 7) & pp;
-        addBlackPawnMoves( moves, wb, pos+7 );
-
-        // King
-        if( Attacks::King[ blackKingSquare ].getBit( to ) ) {
-            moves.add( blackKingSquare, to );
-        }
-
-        // Castling (note that there is no need to verify that the king is not in check,
-        // because that would be handled by a specific move-generation function
-        if( (to == G8) &&
-            (boardFlags & BlackCastleKing) && 
-            (board.piece[F8] == None) && (board.piece[G8] == None) &&
-            !isSquareAttackedBy(F8,White) && !isSquareAttackedBy(G8,White) )
-        {
-            moves.add( blackKingSquare, G8 );
-        }
-
-        if( (to == C8) &&
-            (boardFlags & BlackCastleQueen) && 
-            (board.piece[D8] == None) && (board.piece[C8] == None) && (board.piece[B8] == None) && 
-            !isSquareAttackedBy(D8,White) && !isSquareAttackedBy(C8,White) )
-        {
-            moves.add( blackKingSquare, C8 );
-        }
+    // Knights
+    wb = Us::knights(*this) & Attacks::Knight[to];
+    while( wb.isNotZero() ) {
+        pos = bitSearchAndReset( wb );
+        moves.add( pos, to );
     }
-    else { // White
-        // Knights
-        wb = whiteKnights & Attacks::Knight[to];
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            moves.add( pos, to );
-        }
 
-        // Rooks and queen "rook movement"
-        wb = whiteQueensRooks & rookAttacks( to );
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            moves.add( pos, to );
-        }
-
-        // Bishops and queen "bishop movement"
-        wb = whiteQueensBishops & bishopAttacks( to );
-        while( wb.isNotZero() ) {
-            pos = bitSearchAndReset( wb );
-            moves.add( pos, to );
-        }
+    // Rooks and queen "rook movement"
+    wb = Us::queensRooks(*this) & rookAttacks( to );
+    while( wb.isNotZero() ) {
+        pos = bitSearchAndReset( wb );
+        moves.add( pos, to );
+    }
 
-        // Pawns: advance
-        wb = (whitePawns << 8) & emptySquares;
-        bb = ((wb & Mask::Rank[2]) << 8) & emptySquares;
+    // Bishops and queen "bishop movement"
+    wb = Us::queensBishops(*this) & bishopAttacks( to );
+    while( wb.isNotZero() ) {
+        pos = bitSearchAndReset( wb );
+        moves.add( pos, to );
+    }
 
-        wb &= BitBoard::Set[ to ];
-        bb &= BitBoard::Set[ to ];
+    // Pawns: advance
+    wb = Us::pawnAdvance( Us::pawns(*this) ) & emptySquares;
+    bb = Us::pawnAdvance( wb & Mask::Rank[Us::DoubleStepRank] ) & emptySquares;
 
-        addWhitePawnMoves( moves, wb, pos-8 );
-        addWhitePawnMovesNoPromotion( moves, bb, pos-16 );
+    wb &= BitBoard::Set[ to ];
+    bb &= BitBoard::Set[ to ];
 
-        // Pawns: captures
-        BitBoard    pp = blackPieces;
-        if( enPassantSquare >= 0 ) pp.setBit( enPassantSquare );
+    addPawnMoves( moves, wb, Us::Forward, Us );
+    addPawnMovesNoPromotion( moves, bb, 2*Us::Forward );
 
-        pp &= BitBoard::Set[ to ];
+    // Pawns: captures
+    BitBoard    pp = Them::pieces(*this);
+    if( enPassantSquare >= 0 ) pp.setBit( enPassantSquare );
 
-        wb = ((whitePawns & Mask::NotFile[7]) << 9) & pp;
-        addWhitePawnMoves( moves, wb, pos-9 );
-        wb = ((whitePawns & Mask::NotFile[0]) << 7) & pp;
-        addWhitePawnMoves( moves, wb, pos-7 );
+    pp &= BitBoard::Set[ to ];
 
-        // King
-        if( Attacks::King[ whiteKingSquare ].getBit( to ) ) {
-            moves.add( whiteKingSquare, to );
-        }
+    wb = Us::pawnCapture1( Us::pawns(*this) ) & pp;
+    addPawnMoves( moves, wb, Us::Capture1, Us );
+    wb = Us::pawnCapture2( Us::pawns(*this) ) & pp;
+    addPawnMoves( moves, wb, Us::Capture2, Us );
 
-        // Castling (note that there is no need to verify that the king is not in check,
-        // because that would be handled by a specific move-generation function
-        if( (to == G1) &&
-            (boardFlags & WhiteCastleKing) && 
-            (board.piece[F1] == None) && (board.piece[G1] == None) &&
-            !isSquareAttackedBy(F1,Black) && !isSquareAttackedBy(G1,Black) )
-        {
-            moves.add( whiteKingSquare, G1 );
-        }
-
-        if( (to == C1) &&
-            (boardFlags & WhiteCastleQueen) && 
-            (board.piece[D1] == None) && (board.piece[C1] == None) && (board.piece[B1] == None) &&
-            !isSquareAttackedBy(D1,Black) && !isSquareAttackedBy(C1,Black) )
-        {
-            moves.add( whiteKingSquare, C1 );
-        }
+    // King
+    if( Attacks::King[ Us::kingSquare(*this) ].getBit( to ) ) {
+        moves.add( Us::kingSquare(*this), to );
     }
+
+    // Castling
+    generateCastling<Side>( moves, BitBoard::Set[ to ] );
 }
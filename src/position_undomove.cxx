@@ -25,6 +25,7 @@
 #include "movelist.h"
 #include "position.h"
 #include "score.h"
+#include "sidetraits.h"
 #include "undoinfo.h"
 
 /**
@@ -43,14 +44,29 @@
 */
 void Position::undoMove( const Move & m, const UndoInfo & info )
 {
+    // Note: the side to play is the opponent of the side that made the move
+    if( sideToPlay == Black ) {
+        undoMove<White>( m, info );
+    }
+    else {
+        undoMove<Black>( m, info );
+    }
+}
+
+/*
+    Undoes a move done by doMove() for the side "Side".
+*/
+template<int Side>
+void Position::undoMove( const Move & m, const UndoInfo & info )
+{
+    typedef SideTraits<Side>                Us;
+    typedef SideTraits<OppositeSide(Side)>  Them;
+
     int         from    = m.getFrom();
     int         to      = m.getTo();
 
     // Restore information common to all pieces
     allPieces       = info.allPieces;
-    allPiecesTA1H8  = info.allPiecesTA1H8;
-    allPiecesDA1H8  = info.allPiecesDA1H8;
-    allPiecesDA8H1  = info.allPiecesDA8H1;
 
     hashCode        = info.hashCode;
     pawnHashCode    = info.pawnHashCode;
@@ -58,10 +74,9 @@ void Position::undoMove( const Move & m, const UndoInfo & info )
     boardFlags      = info.boardFlags;
     materialSignature=info.matSignature;
 
-    pstScoreOpening = info.pstScoreOpening;
-    pstScoreEndgame = info.pstScoreEndgame;
+    pstScore        = info.pstScore;
 
-    sideToPlay      = OppositeSide( sideToPlay );
+    sideToPlay      = Side;
 
     // Restore information specific to the moved piece
     int movedPiece;
@@ -69,63 +84,31 @@ void Position::undoMove( const Move & m, const UndoInfo & info )
 
     if( promotedPiece != None ) {
         // Remove promoted piece and replace it with a pawn
-        if( (promotedPiece & PieceSideMask) == Black ) {
-            // Black
-            materialScore -= (Score::Piece[promotedPiece]+Score::Pawn);
-
-            blackPawns.setBit(to);  // To emulate a simple pawn move
-            movedPiece = BlackPawn;
-
-            blackPieceCount += AllPawns_Unit;
-
-            switch( promotedPiece ) {
-            case BlackKnight:
-                blackPieceCount -= AllPieces_Unit | MinorPieces_Unit | AllKnights_Unit;
-                blackKnights.clrBit(to);
-                break;
-            case BlackBishop:
-                blackPieceCount -= AllPieces_Unit | MinorPieces_Unit | AllBishops_Unit;
-                blackQueensBishops.clrBit(to);
-                break;
-            case BlackRook:
-                blackPieceCount -= AllPieces_Unit | MajorPieces_Unit | AllRooks_Unit;
-                blackQueensRooks.clrBit(to);
-                break;
-            case BlackQueen:
-                blackPieceCount -= AllPieces_Unit | MajorPieces_Unit | AllQueens_Unit;
-                blackQueensBishops.clrBit(to);
-                blackQueensRooks.clrBit(to);
-                break;
-            }
-        }
-        else {
-            // White
-            materialScore -= (Score::Piece[promotedPiece]-Score::Pawn);
-
-            whitePawns.setBit(to);  // To emulate a simple pawn move
-            movedPiece = WhitePawn;
-
-            whitePieceCount += AllPawns_Unit;
-
-            switch( promotedPiece ) {
-            case WhiteKnight:
-                whitePieceCount -= AllPieces_Unit | MinorPieces_Unit | AllKnights_Unit;
-                whiteKnights.clrBit(to);
-                break;
-            case WhiteBishop:
-                whitePieceCount -= AllPieces_Unit | MinorPieces_Unit | AllBishops_Unit;
-                whiteQueensBishops.clrBit(to);
-                break;
-            case WhiteRook:
-                whitePieceCount -= AllPieces_Unit | MajorPieces_Unit | AllRooks_Unit;
-                whiteQueensRooks.clrBit(to);
-                break;
-            case WhiteQueen:
-                whitePieceCount -= AllPieces_Unit | MajorPieces_Unit | AllQueens_Unit;
-                whiteQueensBishops.clrBit(to);
-                whiteQueensRooks.clrBit(to);
-                break;
-            }
+        materialScore -= (Score::Piece[promotedPiece]-Score::Piece[Us::Pawn]);
+
+        Us::pawns(*this).setBit(to);  // To emulate a simple pawn move
+        movedPiece = Us::Pawn;
+
+        Us::pieceCount(*this) += AllPawns_Unit;
+
+        switch( promotedPiece ) {
+        case Us::Knight:
+            Us::pieceCount(*this) -= AllPieces_Unit | MinorPieces_Unit | AllKnights_Unit;
+            Us::knights(*this).clrBit(to);
+            break;
+        case Us::Bishop:
+            Us::pieceCount(*this) -= AllPieces_Unit | MinorPieces_Unit | AllBishops_Unit;
+            Us::queensBishops(*this).clrBit(to);
+            break;
+        case Us::Rook:
+            Us::pieceCount(*this) -= AllPieces_Unit | MajorPieces_Unit | AllRooks_Unit;
+            Us::queensRooks(*this).clrBit(to);
+            break;
+        case Us::Queen:
+            Us::pieceCount(*this) -= AllPieces_Unit | MajorPieces_Unit | AllQueens_Unit;
+            Us::queensBishops(*this).clrBit(to);
+            Us::queensRooks(*this).clrBit(to);
+            break;
         }
     }
     else {
@@ -134,86 +117,41 @@ void Position::undoMove( const Move & m, const UndoInfo & info )
 
     BitBoard    fromTo  = BitBoard::Set[from] | BitBoard::Set[to];
 
+    Us::pieces(*this) ^= fromTo;
+
     switch( movedPiece ) {
-    case BlackPawn:
-        blackPieces ^= fromTo;
-        blackPawns ^= fromTo;
-        break;
-    case WhitePawn:
-        whitePieces ^= fromTo;
-        whitePawns ^= fromTo;
-        break;
-    case BlackKnight:
-        blackPieces ^= fromTo;
-        blackKnights ^= fromTo;
-        break;
-    case WhiteKnight:
-        whitePieces ^= fromTo;
-        whiteKnights ^= fromTo;
+    case Us::Pawn:
+        Us::pawns(*this) ^= fromTo;
         break;
-    case BlackBishop:
-        blackPieces ^= fromTo;
-        blackQueensBishops ^= fromTo;
+    case Us::Knight:
+        Us::knights(*this) ^= fromTo;
         break;
-    case WhiteBishop:
-        whitePieces ^= fromTo;
-        whiteQueensBishops ^= fromTo;
+    case Us::Bishop:
+        Us::queensBishops(*this) ^= fromTo;
         break;
-    case BlackRook:
-        blackPieces ^= fromTo;
-        blackQueensRooks ^= fromTo;
+    case Us::Rook:
+        Us::queensRooks(*this) ^= fromTo;
         break;
-    case WhiteRook:
-        whitePieces ^= fromTo;
-        whiteQueensRooks ^= fromTo;
-        break;
-    case BlackQueen:
-        blackPieces ^= fromTo;
-        blackQueensBishops ^= fromTo;
-        blackQueensRooks ^= fromTo;
-        break;
-    case WhiteQueen:
-        whitePieces ^= fromTo;
-        whiteQueensBishops ^= fromTo;
-        whiteQueensRooks ^= fromTo;
-        break;
-    case BlackKing:
-        blackPieces     ^= fromTo;
-        blackKingSquare = from;
-        if( from == E8 ) {
-            if( to == G8 ) {        // Kingside castle: restore rook position
-                fromTo = BitBoard::Set[H8] | BitBoard::Set[F8];
-                blackPieces         ^= fromTo;
-                blackQueensRooks    ^= fromTo;
-                board.piece[H8]     = BlackRook;
-                board.piece[F8]     = None;
-            }
-            else if( to == C8 ) {   // Queenside castle: restore rook position
-                fromTo = BitBoard::Set[A8] | BitBoard::Set[D8];
-                blackPieces         ^= fromTo;
-                blackQueensRooks    ^= fromTo;
-                board.piece[A8]     = BlackRook;
-                board.piece[D8]     = None;
-            }
-        }
+    case Us::Queen:
+        Us::queensBishops(*this) ^= fromTo;
+        Us::queensRooks(*this) ^= fromTo;
         break;
-    case WhiteKing:
-        whitePieces ^= fromTo;
-        whiteKingSquare = from;
-        if( from == E1 ) {
-            if( to == G1 ) {        // Kingside castle: restore rook position
-                fromTo = BitBoard::Set[H1] | BitBoard::Set[F1];
-                whitePieces         ^= fromTo;
-                whiteQueensRooks    ^= fromTo;
-                board.piece[H1]     = WhiteRook;
-                board.piece[F1]     = None;
+    case Us::King:
+        Us::kingSquare(*this) = from;
+        if( from == Us::KingStart ) {
+            if( to == Us::KingCastleTo ) {          // Kingside castle: restore rook position
+                fromTo = BitBoard::Set[Us::KingRook] | BitBoard::Set[Us::KingRookTo];
+                Us::pieces(*this)           ^= fromTo;
+                Us::queensRooks(*this)      ^= fromTo;
+                board.piece[Us::KingRook]   = Us::Rook;
+                board.piece[Us::KingRookTo] = None;
             }
-            else if( to == C1 ) {   // Queenside castle: restore rook position
-                fromTo = BitBoard::Set[A1] | BitBoard::Set[D1];
-                whitePieces         ^= fromTo;
-                whiteQueensRooks    ^= fromTo;
-                board.piece[A1]     = WhiteRook;
-                board.piece[D1]     = None;
+            else if( to == Us::QueenCastleTo ) {    // Queenside castle: restore rook position
+                fromTo = BitBoard::Set[Us::QueenRook] | BitBoard::Set[Us::QueenRookTo];
+                Us::pieces(*this)           ^= fromTo;
+                Us::queensRooks(*this)      ^= fromTo;
+                board.piece[Us::QueenRook]  = Us::Rook;
+                board.piece[Us::QueenRookTo]= None;
             }
         }
         break;
@@ -230,16 +168,8 @@ void Position::undoMove( const Move & m, const UndoInfo & info )
         // Undo en-passant capture
         board.piece[to] = None;
 
-        if( to <= H3 ) {
-            // This is a black pawn capturing on the 3rd rank
-            pieceCaptured = WhitePawn;
-            pieceCapturedPos = to+8;
-        }
-        else {
-            // White pawn capturing on the 6th rank
-            pieceCaptured = BlackPawn;
-            pieceCapturedPos = to-8;
-        }
+        pieceCaptured = Them::Pawn;
+        pieceCapturedPos = to - Us::Forward;
     }
 
     // Restore captured piece (or empty square)
@@ -249,63 +179,37 @@ void Position::undoMove( const Move & m, const UndoInfo & info )
     if( pieceCaptured != None ) {
         materialScore += Score::Piece[ pieceCaptured ];
 
+        Them::pieces(*this).setBit(pieceCapturedPos);
+
         switch( pieceCaptured ) {
-        case BlackPawn:
-            blackPieceCount += AllPawns_Unit;
-            blackPieces.setBit(pieceCapturedPos);
-            blackPawns.setBit(pieceCapturedPos);
-            break;
-        case WhitePawn:
-            whitePieceCount += AllPawns_Unit;
-            whitePieces.setBit(pieceCapturedPos);
-            whitePawns.setBit(pieceCapturedPos);
+        case Them::Pawn:
+            Them::pieceCount(*this) += AllPawns_Unit;
+            Them::pawns(*this).setBit(pieceCapturedPos);
             break;
-        case BlackKnight:
-            blackPieceCount += AllPieces_Unit | MinorPieces_Unit | AllKnights_Unit;
-            blackPieces.setBit(pieceCapturedPos);
-            blackKnights.setBit(pieceCapturedPos);
+        case Them::Knight:
+            Them::pieceCount(*this) += AllPieces_Unit | MinorPieces_Unit | AllKnights_Unit;
+            Them::knights(*this).setBit(pieceCapturedPos);
             break;
-        case WhiteKnight:
-            whitePieceCount += AllPieces_Unit | MinorPieces_Unit | AllKnights_Unit;
-            whitePieces.setBit(pieceCapturedPos);
-            whiteKnights.setBit(pieceCapturedPos);
+        case Them::Bishop:
+            Them::pieceCount(*this) += AllPieces_Unit | MinorPieces_Unit | AllBishops_Unit;
+            Them::queensBishops(*this).setBit(pieceCapturedPos);
             break;
-        case BlackBishop:
-            blackPieceCount += AllPieces_Unit | MinorPieces_Unit | AllBishops_Unit;
-            blackPieces.setBit(pieceCapturedPos);
-            blackQueensBishops.setBit(pieceCapturedPos);
+        case Them::Rook:
+            Them::pieceCount(*this) += AllPieces_Unit | MajorPieces_Unit | AllRooks_Unit;
+            Them::queensRooks(*this).setBit(pieceCapturedPos);
             break;
-        case WhiteBishop:
-            whitePieceCount += AllPieces_Unit | MinorPieces_Unit | AllBishops_Unit;
-            whitePieces.setBit(pieceCapturedPos);
-            whiteQueensBishops.setBit(pieceCapturedPos);
-            break;
-        case BlackRook:
-            blackPieceCount += AllPieces_Unit | MajorPieces_Unit | AllRooks_Unit;
-            blackPieces.setBit(pieceCapturedPos);
-            blackQueensRooks.setBit(pieceCapturedPos);
-            break;
-        case WhiteRook:
-            whitePieceCount += AllPieces_Unit | MajorPieces_Unit | AllRooks_Unit;
-            whitePieces.setBit(pieceCapturedPos);
-            whiteQueensRooks.setBit(pieceCapturedPos);
-            break;
-        case BlackQueen:
-            blackPieceCount += AllPieces_Unit | MajorPieces_Unit | AllQueens_Unit;
-            blackPieces.setBit(pieceCapturedPos);
-            blackQueensBishops.setBit(pieceCapturedPos);
-            blackQueensRooks.setBit(pieceCapturedPos);
-            break;
-        case WhiteQueen:
-            whitePieceCount += AllPieces_Unit | MajorPieces_Unit | AllQueens_Unit;
-            whitePieces.setBit(pieceCapturedPos);
-            whiteQueensBishops.setBit(pieceCapturedPos);
-            whiteQueensRooks.setBit(pieceCapturedPos);
+        case Them::Queen:
+            Them::pieceCount(*this) += AllPieces_Unit | MajorPieces_Unit | AllQueens_Unit;
+            Them::queensBishops(*this).setBit(pieceCapturedPos);
+            Them::queensRooks(*this).setBit(pieceCapturedPos);
             break;
         }
     }
 }
 
+template void Position::undoMove<White>( const Move & m, const UndoInfo & info );
+template void Position::undoMove<Black>( const Move & m, const UndoInfo & info );
+
 void Position::undoNullMove( const UndoInfo & info ) 
 { 
     hashCode        = info.hashCode;
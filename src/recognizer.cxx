@@ -23,6 +23,7 @@
 #include "bitbase.h"
 #include "metrics.h"
 #include "log.h"
+#include "material.h"
 #include "packed_array.h"
 #include "recognizer.h"
 #include "score.h"
@@ -666,11 +667,13 @@ static bool recognizerForKNK_White( const Position & pos, RecognizerInfo & resul
 {
     bool handled = false;
 
-    switch( pos.numOfWhiteKnights() ) {
-    case 1:
+    if( Material::probe( pos ).isDraw() ) {
+        // A lone minor piece cannot win
         result.set( 0, rtExact );
-        handled = true;
-        break;
+        return true;
+    }
+
+    switch( pos.numOfWhiteKnights() ) {
     case 2:
         handled = evaluatorForKNNK( pos.whiteKingSquare, pos.blackKingSquare, pos.whiteKnights, pos.whiteToMove(), result );
         break;
@@ -686,11 +689,13 @@ static bool recognizerForKNK_Black( const Position & pos, RecognizerInfo & resul
 {
     bool handled = false;
 
-    switch( pos.numOfBlackKnights() ) {
-    case 1:
+    if( Material::probe( pos ).isDraw() ) {
+        // A lone minor piece cannot win
         result.set( 0, rtExact );
-        handled = true;
-        break;
+        return true;
+    }
+
+    switch( pos.numOfBlackKnights() ) {
     case 2:
         handled = evaluatorForKNNK( pos.blackKingSquare, pos.whiteKingSquare, pos.blackKnights, pos.blackToMove(), result );
         break;
@@ -812,11 +817,13 @@ static bool recognizerForKBK_White( const Position & pos, RecognizerInfo & resul
 {
     bool handled = false;
 
-    switch( pos.numOfWhiteBishops() ) {
-    case 1:
+    if( Material::probe( pos ).isDraw() ) {
+        // A lone minor piece cannot win
         result.set( 0, rtExact );
-        handled = true;
-        break;
+        return true;
+    }
+
+    switch( pos.numOfWhiteBishops() ) {
     case 2:
         handled = evaluatorForKBBK( pos.whiteKingSquare, pos.blackKingSquare, pos.whiteQueensBishops, pos.whiteToMove(), result );
         break;
@@ -831,11 +838,13 @@ static bool recognizerForKBK_Black( const Position & pos, RecognizerInfo & resul
 {
     bool handled = false;
 
-    switch( pos.numOfBlackBishops() ) {
-    case 1:
+    if( Material::probe( pos ).isDraw() ) {
+        // A lone minor piece cannot win
         result.set( 0, rtExact );
-        handled = true;
-        break;
+        return true;
+    }
+
+    switch( pos.numOfBlackBishops() ) {
     case 2:
         handled = evaluatorForKBBK( pos.blackKingSquare, pos.whiteKingSquare, pos.blackQueensBishops, pos.blackToMove(), result );
         break;
@@ -198,6 +198,18 @@ char Score::WhiteQueen_Endgame[64];
 char Score::WhiteKing_Opening[64];
 char Score::WhiteKing_Endgame[64];
 
+PackedScore Score::BlackKnight_Packed[64];
+PackedScore Score::BlackBishop_Packed[64];
+PackedScore Score::BlackRook_Packed[64];
+PackedScore Score::BlackQueen_Packed[64];
+PackedScore Score::BlackKing_Packed[64];
+
+PackedScore Score::WhiteKnight_Packed[64];
+PackedScore Score::WhiteBishop_Packed[64];
+PackedScore Score::WhiteRook_Packed[64];
+PackedScore Score::WhiteQueen_Packed[64];
+PackedScore Score::WhiteKing_Packed[64];
+
 int Score::WhiteKnightOutpost[64];
 
 int Score::RookOnOpenFile[8]        = { 15, 15, 17, 20, 20, 17, 15, 15 };
@@ -212,6 +224,13 @@ static void getSymmetricSquareValueTableCh( char * dst, const char * src )
 
         dst[symmetric_square] = src[square];
     }
+}
+
+static void getPackedSquareValueTable( PackedScore * dst, const char * opening, const char * endgame )
+{
+    for( int square=0; square<64; square++ ) {
+        dst[square] = MakePackedScore( opening[square], endgame[square] );
+    }
 }
 
 void Score::initialize()
@@ -229,6 +248,17 @@ void Score::initialize()
     getSymmetricSquareValueTableCh( WhiteKing_Opening, BlackKing_Opening );
     getSymmetricSquareValueTableCh( WhiteKing_Endgame, BlackKing_Endgame );
 
+    getPackedSquareValueTable( BlackKnight_Packed, BlackKnight_Opening, BlackKnight_Endgame );
+    getPackedSquareValueTable( BlackBishop_Packed, BlackBishop_Opening, BlackBishop_Endgame );
+    getPackedSquareValueTable( BlackRook_Packed, BlackRook_Opening, BlackRook_Endgame );
+    getPackedSquareValueTable( BlackQueen_Packed, BlackQueen_Opening, BlackQueen_Endgame );
+    getPackedSquareValueTable( BlackKing_Packed, BlackKing_Opening, BlackKing_Endgame );
+    getPackedSquareValueTable( WhiteKnight_Packed, WhiteKnight_Opening, WhiteKnight_Endgame );
+    getPackedSquareValueTable( WhiteBishop_Packed, WhiteBishop_Opening, WhiteBishop_Endgame );
+    getPackedSquareValueTable( WhiteRook_Packed, WhiteRook_Opening, WhiteRook_Endgame );
+    getPackedSquareValueTable( WhiteQueen_Packed, WhiteQueen_Opening, WhiteQueen_Endgame );
+    getPackedSquareValueTable( WhiteKing_Packed, WhiteKing_Opening, WhiteKing_Endgame );
+
     getSymmetricSquareValueTable( WhiteKnightOutpost, BlackKnightOutpost );
 
     // Piece values: these tables must always be constructed dynamically,
@@ -32,6 +32,33 @@ const int Stage_EarlyEndgame    = 3;
 const int Stage_Endgame         = 0;
 const int Stage_Count           = Stage_Max - Stage_Min + 1;
 
+/*
+    A packed score holds an opening and an endgame value in a single integer, the
+    opening value in the high 16 bits and the endgame value in the low 16 bits, so
+    that one addition (or subtraction, or multiplication by a small integer) updates
+    both. The endgame value is signed, so it borrows from the opening value when
+    negative: GetOpeningScore() takes that into account.
+*/
+typedef int PackedScore;
+
+#define MakePackedScore( opening, endgame ) ((opening) * 0x10000 + (endgame))
+
+inline int GetOpeningScore( PackedScore s )
+{
+    return (s + 0x8000) >> 16;
+}
+
+inline int GetEndgameScore( PackedScore s )
+{
+    return (short) (s & 0xFFFF);
+}
+
+// Interpolates between the opening and the endgame value according to the stage (sum of both sides)
+inline int GetStageScore( PackedScore s, int stage )
+{
+    return (GetOpeningScore( s )*stage + GetEndgameScore( s )*(2*Stage_Max-stage)) / (2*Stage_Max);
+}
+
 struct Score
 {
     // Piece values
@@ -71,6 +98,19 @@ struct Score
     static char WhiteKing_Opening[64];
     static char WhiteKing_Endgame[64];
 
+    // Same as above, with opening and endgame packed together (built from the tables above)
+    static PackedScore BlackKnight_Packed[64];
+    static PackedScore BlackBishop_Packed[64];
+    static PackedScore BlackRook_Packed[64];
+    static PackedScore BlackQueen_Packed[64];
+    static PackedScore BlackKing_Packed[64];
+
+    static PackedScore WhiteKnight_Packed[64];
+    static PackedScore WhiteBishop_Packed[64];
+    static PackedScore WhiteRook_Packed[64];
+    static PackedScore WhiteQueen_Packed[64];
+    static PackedScore WhiteKing_Packed[64];
+
     static int  BlackKnightOutpost[64];
     static int  WhiteKnightOutpost[64];
 
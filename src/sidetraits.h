@@ -0,0 +1,227 @@
+/*
+    Kiwi
+    Side traits for move generation and make/unmake
+
+    Copyright (c) 1999-2004,2005 Alessandro Scotti
+    http://www.ascotti.org/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#ifndef SIDE_TRAITS_H_
+#define SIDE_TRAITS_H_
+
+#include "attacks.h"
+#include "bitboard.h"
+#include "board.h"
+#include "mask.h"
+#include "position.h"
+#include "score.h"
+#include "zobrist.h"
+
+/*
+    Describes everything that depends on the color of a side: pieces, bitboards,
+    tables and special squares. Move generation and make/unmake are written once
+    as templates on the side, and SideTraits<Side> resolves all of that at compile
+    time, so the generated code has no tests on the side to move.
+*/
+template<int Side> struct SideTraits;
+
+// Gives access to a member of Position that exists for both sides
+#define SideMember( type, name, member )                                \
+    static type & name( Position & p ) { return p.member; }             \
+    static const type & name( const Position & p ) { return p.member; }
+
+template<>
+struct SideTraits<White>
+{
+    enum {
+        Pawn            = WhitePawn,
+        Knight          = WhiteKnight,
+        Bishop          = WhiteBishop,
+        Rook            = WhiteRook,
+        Queen           = WhiteQueen,
+        King            = WhiteKing,
+
+        Sign            = +1,       // Sign of the piece/square scores of this side
+
+        Forward         = +8,       // Square delta of a pawn advance
+        Capture1        = +9,       // Square delta of a pawn capture toward the h-file...
+        Capture2        = +7,       // ...and toward the a-file
+        PromotionRank   = 7,
+        PrePromotionRank= 6,
+        DoubleStepRank  = 2,        // Rank a pawn must reach in one step to advance again
+
+        KingStart       = E1,
+        KingCastleTo    = G1,
+        QueenCastleTo   = C1,
+        KingRook        = H1,
+        KingRookTo      = F1,
+        QueenRook       = A1,
+        QueenRookTo     = D1,
+        QueenKnight     = B1,
+
+        CastleKing      = Position::WhiteCastleKing,
+        CastleQueen     = Position::WhiteCastleQueen,
+        HasCastled      = Position::WhiteHasCastled,
+
+        SignatureMaterialPawn   = SignatureMaterialWhitePawn,
+        SignatureMaterialKnight = SignatureMaterialWhiteKnight,
+        SignatureMaterialBishop = SignatureMaterialWhiteBishop,
+        SignatureMaterialRook   = SignatureMaterialWhiteRook,
+        SignatureMaterialQueen  = SignatureMaterialWhiteQueen,
+
+        SignaturePawn   = SignatureWhitePawn,
+        SignatureKnight = SignatureWhiteKnight,
+        SignatureBishop = SignatureWhiteBishop,
+        SignatureRook   = SignatureWhiteRook,
+        SignatureQueen  = SignatureWhiteQueen,
+    };
+
+    SideMember( unsigned, pieceCount, whitePieceCount )
+    SideMember( BitBoard, pieces, whitePieces )
+    SideMember( BitBoard, pawns, whitePawns )
+    SideMember( BitBoard, knights, whiteKnights )
+    SideMember( BitBoard, queensBishops, whiteQueensBishops )
+    SideMember( BitBoard, queensRooks, whiteQueensRooks )
+    SideMember( int, kingSquare, whiteKingSquare )
+
+    // Pawns advanced by one step or by a capture (pawns that would leave the board are dropped)
+    static BitBoard pawnAdvance( const BitBoard & b ) {
+        return b << 8;
+    }
+
+    static BitBoard pawnCapture1( const BitBoard & b ) {
+        return (b & Mask::NotFile[7]) << 9;
+    }
+
+    static BitBoard pawnCapture2( const BitBoard & b ) {
+        return (b & Mask::NotFile[0]) << 7;
+    }
+
+    // Squares attacked by a pawn of this side
+    static const BitBoard * pawnAttacks() { return Attacks::WhitePawn; }
+
+    static const BitBoard * zobristPawn()   { return Zobrist::WhitePawn; }
+    static const BitBoard * zobristKnight() { return Zobrist::WhiteKnight; }
+    static const BitBoard * zobristBishop() { return Zobrist::WhiteBishop; }
+    static const BitBoard * zobristRook()   { return Zobrist::WhiteRook; }
+    static const BitBoard * zobristQueen()  { return Zobrist::WhiteQueen; }
+    static const BitBoard * zobristKing()   { return Zobrist::WhiteKing; }
+    static const BitBoard & zobristCastleKing()  { return Zobrist::WhiteCastleKing; }
+    static const BitBoard & zobristCastleQueen() { return Zobrist::WhiteCastleQueen; }
+
+    static const PackedScore * knightScore() { return Score::WhiteKnight_Packed; }
+    static const PackedScore * bishopScore() { return Score::WhiteBishop_Packed; }
+    static const PackedScore * rookScore()   { return Score::WhiteRook_Packed; }
+    static const PackedScore * queenScore()  { return Score::WhiteQueen_Packed; }
+    static const PackedScore * kingScore()   { return Score::WhiteKing_Packed; }
+};
+
+template<>
+struct SideTraits<Black>
+{
+    enum {
+        Pawn            = BlackPawn,
+        Knight          = BlackKnight,
+        Bishop          = BlackBishop,
+        Rook            = BlackRook,
+        Queen           = BlackQueen,
+        King            = BlackKing,
+
+        Sign            = -1,
+
+        Forward         = -8,
+        Capture1        = -9,       // Toward the a-file...
+        Capture2        = -7,       // ...and toward the h-file
+        PromotionRank   = 0,
+        PrePromotionRank= 1,
+        DoubleStepRank  = 5,
+
+        KingStart       = E8,
+        KingCastleTo    = G8,
+        QueenCastleTo   = C8,
+        KingRook        = H8,
+        KingRookTo      = F8,
+        QueenRook       = A8,
+        QueenRookTo     = D8,
+        QueenKnight     = B8,
+
+        CastleKing      = Position::BlackCastleKing,
+        CastleQueen     = Position::BlackCastleQueen,
+        HasCastled      = Position::BlackHasCastled,
+
+        SignatureMaterialPawn   = SignatureMaterialBlackPawn,
+        SignatureMaterialKnight = SignatureMaterialBlackKnight,
+        SignatureMaterialBishop = SignatureMaterialBlackBishop,
+        SignatureMaterialRook   = SignatureMaterialBlackRook,
+        SignatureMaterialQueen  = SignatureMaterialBlackQueen,
+
+        SignaturePawn   = SignatureBlackPawn,
+        SignatureKnight = SignatureBlackKnight,
+        SignatureBishop = SignatureBlackBishop,
+        SignatureRook   = SignatureBlackRook,
+        SignatureQueen  = SignatureBlackQueen,
+    };
+
+    SideMember( unsigned, pieceCount, blackPieceCount )
+    SideMember( BitBoard, pieces, blackPieces )
+    SideMember( BitBoard, pawns, blackPawns )
+    SideMember( BitBoard, knights, blackKnights )
+    SideMember( BitBoard, queensBishops, blackQueensBishops )
+    SideMember( BitBoard, queensRooks, blackQueensRooks )
+    SideMember( int, kingSquare, blackKingSquare )
+
+    static BitBoard pawnAdvance( const BitBoard & b ) {
+        return b >> 8;
+    }
+
+    static BitBoard pawnCapture1( const BitBoard & b ) {
+        return (b & Mask::NotFile[0]) >> 9;
+    }
+
+    static BitBoard pawnCapture2( const BitBoard & b ) {
+        return (b & Mask::NotFile[7]) >> 7;
+    }
+
+    static const BitBoard * pawnAttacks() { return Attacks::BlackPawn; }
+
+    static const BitBoard * zobristPawn()   { return Zobrist::BlackPawn; }
+    static const BitBoard * zobristKnight() { return Zobrist::BlackKnight; }
+    static const BitBoard * zobristBishop() { return Zobrist::BlackBishop; }
+    static const BitBoard * zobristRook()   { return Zobrist::BlackRook; }
+    static const BitBoard * zobristQueen()  { return Zobrist::BlackQueen; }
+    static const BitBoard * zobristKing()   { return Zobrist::BlackKing; }
+    static const BitBoard & zobristCastleKing()  { return Zobrist::BlackCastleKing; }
+    static const BitBoard & zobristCastleQueen() { return Zobrist::BlackCastleQueen; }
+
+    static const PackedScore * knightScore() { return Score::BlackKnight_Packed; }
+    static const PackedScore * bishopScore() { return Score::BlackBishop_Packed; }
+    static const PackedScore * rookScore()   { return Score::BlackRook_Packed; }
+    static const PackedScore * queenScore()  { return Score::BlackQueen_Packed; }
+    static const PackedScore * kingScore()   { return Score::BlackKing_Packed; }
+};
+
+#undef SideMember
+
+// Same as updateSignatureAdd() and updateSignatureRemove(), for the side described by "S"
+#define updateSideSignatureAdd( S, piece ) \
+    materialSignature += S::SignatureMaterial##piece; \
+    materialSignature |= S::Signature##piece;
+
+#define updateSideSignatureRemove( S, piece ) \
+    materialSignature -= S::SignatureMaterial##piece; \
+    if( (S::pieceCount(*this) & All##piece##s_Mask) == 0 ) materialSignature &= ~S::Signature##piece;
+
+#endif // SIDE_TRAITS_H_
@@ -446,3 +446,364 @@ void System::sleep( unsigned ms )
     pthread_mutex_destroy( &mutex );
 #endif
 }
+
+/*
+    Threads
+*/
+struct ThreadInfo
+{
+    System::ThreadProc  proc;
+    void *              param;
+#ifdef WIN32
+    HANDLE              handle;
+#else
+    pthread_t           handle;
+#endif
+};
+
+#ifdef WIN32
+static DWORD WINAPI ThreadEntry( LPVOID param )
+#else
+static void * ThreadEntry( void * param )
+#endif
+{
+    ThreadInfo * info = (ThreadInfo *) param;
+
+    info->proc( info->param );
+
+    return 0;
+}
+
+void * System::startThread( ThreadProc proc, void * param )
+{
+    ThreadInfo * info = new ThreadInfo;
+
+    info->proc = proc;
+    info->param = param;
+
+#ifdef WIN32
+    DWORD dwThreadId;
+
+    info->handle = CreateThread( 0, 0, ThreadEntry, info, 0, &dwThreadId );
+
+    if( info->handle == 0 ) {
+        delete info;
+        info = 0;
+    }
+#else // POSIX
+    if( pthread_create( &info->handle, 0, ThreadEntry, info ) != 0 ) {
+        delete info;
+        info = 0;
+    }
+#endif
+
+    return info;
+}
+
+void System::waitThread( void * handle )
+{
+    ThreadInfo * info = (ThreadInfo *) handle;
+
+    if( info != 0 ) {
+#ifdef WIN32
+        WaitForSingleObject( info->handle, INFINITE );
+        CloseHandle( info->handle );
+#else // POSIX
+        pthread_join( info->handle, 0 );
+#endif
+
+        delete info;
+    }
+}
+
+int System::getNumberOfProcessors()
+{
+    int result = 1;
+
+#ifdef WIN32
+    SYSTEM_INFO si;
+
+    GetSystemInfo( &si );
+
+    result = (int) si.dwNumberOfProcessors;
+#else // POSIX
+    long n = sysconf( _SC_NPROCESSORS_ONLN );
+
+    if( n > 0 ) {
+        result = (int) n;
+    }
+#endif
+
+    return result < 1 ? 1 : result;
+}
+
+/*
+    Locks
+*/
+void * System::createLock()
+{
+#ifdef WIN32
+    CRITICAL_SECTION * cs = new CRITICAL_SECTION;
+
+    InitializeCriticalSection( cs );
+
+    return cs;
+#else // POSIX
+    pthread_mutex_t * mutex = new pthread_mutex_t;
+
+    pthread_mutex_init( mutex, 0 );
+
+    return mutex;
+#endif
+}
+
+void System::destroyLock( void * lock )
+{
+#ifdef WIN32
+    DeleteCriticalSection( (CRITICAL_SECTION *) lock );
+
+    delete (CRITICAL_SECTION *) lock;
+#else // POSIX
+    pthread_mutex_destroy( (pthread_mutex_t *) lock );
+
+    delete (pthread_mutex_t *) lock;
+#endif
+}
+
+void System::acquireLock( void * lock )
+{
+#ifdef WIN32
+    EnterCriticalSection( (CRITICAL_SECTION *) lock );
+#else // POSIX
+    pthread_mutex_lock( (pthread_mutex_t *) lock );
+#endif
+}
+
+void System::releaseLock( void * lock )
+{
+#ifdef WIN32
+    LeaveCriticalSection( (CRITICAL_SECTION *) lock );
+#else // POSIX
+    pthread_mutex_unlock( (pthread_mutex_t *) lock );
+#endif
+}
+
+void * System::createCondition()
+{
+#ifdef WIN32
+    CONDITION_VARIABLE * cv = new CONDITION_VARIABLE;
+
+    InitializeConditionVariable( cv );
+
+    return cv;
+#else // POSIX
+    pthread_cond_t * cond = new pthread_cond_t;
+
+    pthread_cond_init( cond, 0 );
+
+    return cond;
+#endif
+}
+
+void System::destroyCondition( void * cond )
+{
+#ifdef WIN32
+    delete (CONDITION_VARIABLE *) cond;
+#else // POSIX
+    pthread_cond_destroy( (pthread_cond_t *) cond );
+
+    delete (pthread_cond_t *) cond;
+#endif
+}
+
+void System::waitCondition( void * cond, void * lock )
+{
+#ifdef WIN32
+    SleepConditionVariableCS( (CONDITION_VARIABLE *) cond, (CRITICAL_SECTION *) lock, INFINITE );
+#else // POSIX
+    pthread_cond_wait( (pthread_cond_t *) cond, (pthread_mutex_t *) lock );
+#endif
+}
+
+void System::signalCondition( void * cond )
+{
+#ifdef WIN32
+    WakeAllConditionVariable( (CONDITION_VARIABLE *) cond );
+#else // POSIX
+    pthread_cond_broadcast( (pthread_cond_t *) cond );
+#endif
+}
+
+/*
+    Memory
+*/
+#ifndef WIN32
+#include <sys/mman.h>
+
+static const size_t HugePageSize = 2*1024*1024;
+#endif
+
+void * System::allocateLargeBlock( size_t size, const char ** backing )
+{
+    const char *    type = "none";
+    void *          block = 0;
+
+#ifdef WIN32
+    // Large pages need the "lock pages in memory" privilege, which is seldom granted
+    SIZE_T largePageSize = GetLargePageMinimum();
+
+    if( largePageSize > 0 ) {
+        size_t n = (size + largePageSize - 1) & ~(largePageSize - 1);
+
+        block = VirtualAlloc( 0, n, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE );
+
+        type = "large pages";
+    }
+
+    if( block == 0 ) {
+        // Memory returned by VirtualAlloc() is aligned to 64K
+        block = VirtualAlloc( 0, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE );
+
+        type = "default pages";
+    }
+#else // POSIX
+    size_t n = (size + HugePageSize - 1) & ~(HugePageSize - 1);
+
+#ifdef MAP_HUGETLB
+    // Explicit huge pages are only available if reserved by the administrator
+    block = mmap( 0, n, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+
+    if( block == MAP_FAILED ) {
+        block = 0;
+    }
+    else {
+        type = "explicit huge pages";
+    }
+#endif
+
+    if( block == 0 ) {
+        // Map a bit more memory so that the block can be aligned to
+        // a huge page boundary, then release the excess
+        char * p = (char *) mmap( 0, n + HugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+
+        if( p != MAP_FAILED ) {
+            char * q = (char *) (((size_t) p + HugePageSize - 1) & ~(HugePageSize - 1));
+
+            if( q > p ) {
+                munmap( p, q - p );
+            }
+
+            munmap( q + n, (p + HugePageSize) - q );
+
+            block = q;
+
+            type = "default pages";
+
+#ifdef MADV_HUGEPAGE
+            if( madvise( block, n, MADV_HUGEPAGE ) == 0 ) {
+                type = "transparent huge pages";
+            }
+#endif
+        }
+    }
+#endif
+
+    if( backing != 0 ) {
+        *backing = type;
+    }
+
+    return block;
+}
+
+void * System::allocateLargestBlock( size_t & size, size_t minSize, const char ** backing )
+{
+    while( size >= minSize && size > 0 ) {
+        void * block = allocateLargeBlock( size, backing );
+
+        if( block != 0 ) {
+            return block;
+        }
+
+        size /= 2;
+    }
+
+    return 0;
+}
+
+void System::freeLargeBlock( void * block, size_t size )
+{
+    if( block != 0 ) {
+#ifdef WIN32
+        VirtualFree( block, 0, MEM_RELEASE );
+#else // POSIX
+        munmap( block, (size + HugePageSize - 1) & ~(HugePageSize - 1) );
+#endif
+    }
+}
+
+/*
+    Memory mapped files
+*/
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+const void * System::mapFile( const char * name, size_t * size )
+{
+    const void * result = 0;
+
+#ifdef WIN32
+    HANDLE hFile = CreateFile( name, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0 );
+
+    if( hFile != INVALID_HANDLE_VALUE ) {
+        LARGE_INTEGER length;
+
+        if( GetFileSizeEx( hFile, &length ) && length.QuadPart > 0 ) {
+            HANDLE hMapping = CreateFileMapping( hFile, 0, PAGE_READONLY, 0, 0, 0 );
+
+            if( hMapping != 0 ) {
+                // Note: the view is still valid after the handles have been closed
+                result = MapViewOfFile( hMapping, FILE_MAP_READ, 0, 0, 0 );
+
+                *size = (size_t) length.QuadPart;
+
+                CloseHandle( hMapping );
+            }
+        }
+
+        CloseHandle( hFile );
+    }
+#else // POSIX
+    int fd = open( name, O_RDONLY );
+
+    if( fd >= 0 ) {
+        struct stat st;
+
+        if( fstat( fd, &st ) == 0 && st.st_size > 0 ) {
+            void * p = mmap( 0, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+            if( p != MAP_FAILED ) {
+                result = p;
+
+                *size = (size_t) st.st_size;
+            }
+        }
+
+        close( fd );
+    }
+#endif
+
+    return result;
+}
+
+void System::unmapFile( const void * data, size_t size )
+{
+    if( data != 0 ) {
+#ifdef WIN32
+        UnmapViewOfFile( data );
+#else // POSIX
+        munmap( (void *) data, size );
+#endif
+    }
+}
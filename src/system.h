@@ -18,6 +18,8 @@
 #ifndef SYSTEM_H_
 #define SYSTEM_H_
 
+#include <stddef.h>
+
 /**
     System dependent functions.
 
@@ -41,6 +43,96 @@ public:
     /** Puts current thread to sleep for (approximately) the specified time in milliseconds. */
     static void sleep( unsigned ms );
 
+    /** Thread entry point. */
+    typedef void (* ThreadProc)( void * param );
+
+    /**
+        Starts a new thread that runs the specified procedure.
+
+        @return a handle to the new thread, or 0 if the thread cannot be created
+    */
+    static void * startThread( ThreadProc proc, void * param );
+
+    /**
+        Waits for a thread started with startThread() to terminate,
+        then releases the thread handle.
+    */
+    static void waitThread( void * handle );
+
+    /** Returns the number of processors available to the program (at least one). */
+    static int getNumberOfProcessors();
+
+    /** Creates a lock (mutex) for synchronizing threads. */
+    static void * createLock();
+
+    /** Destroys a lock created with createLock(). */
+    static void destroyLock( void * lock );
+
+    /** Acquires the specified lock, waiting if it is owned by another thread. */
+    static void acquireLock( void * lock );
+
+    /** Releases a lock acquired with acquireLock(). */
+    static void releaseLock( void * lock );
+
+    /** Creates a condition variable, that threads can wait on until another thread signals it. */
+    static void * createCondition();
+
+    /** Destroys a condition variable created with createCondition(). */
+    static void destroyCondition( void * cond );
+
+    /**
+        Releases the specified lock (which must be owned by the calling thread), waits
+        until the condition is signaled and then acquires the lock again.
+
+        Note: the thread may also wake up spuriously, so the caller must check again
+        whatever it was waiting for.
+    */
+    static void waitCondition( void * cond, void * lock );
+
+    /** Wakes up all the threads waiting on the specified condition. */
+    static void signalCondition( void * cond );
+
+    /**
+        Allocates a large block of memory, using huge (large) pages if possible.
+
+        The block is always aligned to a cache line (at least) and its contents
+        are initially zero.
+
+        @param  size size of the block in bytes
+        @param  backing (out) if not null, receives a description of the pages used
+
+        @return a pointer to the block, or 0 if memory cannot be allocated
+    */
+    static void * allocateLargeBlock( size_t size, const char ** backing = 0 );
+
+    /**
+        Same as allocateLargeBlock(), but if there is not enough memory the size
+        is halved until the allocation succeeds or it gets below the minimum.
+
+        @param  size (in/out) requested size of the block, receives the allocated size
+        @param  minSize smallest acceptable size
+        @param  backing (out) if not null, receives a description of the pages used
+
+        @return a pointer to the block, or 0 if not even the minimum size can be allocated
+    */
+    static void * allocateLargestBlock( size_t & size, size_t minSize, const char ** backing = 0 );
+
+    /** Releases a block allocated with allocateLargeBlock(). */
+    static void freeLargeBlock( void * block, size_t size );
+
+    /**
+        Maps the specified file into memory, for reading only.
+
+        @param  name name of the file
+        @param  size (out) size of the file in bytes
+
+        @return a pointer to the file contents, or 0 if the file cannot be mapped
+    */
+    static const void * mapFile( const char * name, size_t * size );
+
+    /** Releases a file mapped with mapFile(). */
+    static void unmapFile( const void * data, size_t size );
+
     /** 
         Returns true if there is input pending, false otherwise.
 
@@ -29,29 +29,28 @@
 */
 struct UndoInfo 
 {
+    UndoInfo() {
+    }
+
     UndoInfo( const Position & p ) {
+        save( p );
+    }
+
+    void save( const Position & p ) {
         allPieces       = p.allPieces;
-        allPiecesTA1H8  = p.allPiecesTA1H8;
-        allPiecesDA1H8  = p.allPiecesDA1H8;
-        allPiecesDA8H1  = p.allPiecesDA8H1;
         hashCode        = p.hashCode;
         pawnHashCode    = p.pawnHashCode;
         boardFlags      = p.boardFlags;
         matSignature    = p.materialSignature;
-        pstScoreOpening = p.pstScoreOpening;
-        pstScoreEndgame = p.pstScoreEndgame;
+        pstScore        = p.pstScore;
     }
 
     BitBoard    allPieces;
-    BitBoard    allPiecesTA1H8;
-    BitBoard    allPiecesDA1H8;
-    BitBoard    allPiecesDA8H1;
     BitBoard    hashCode;
     BitBoard    pawnHashCode;
     unsigned    boardFlags;
     unsigned    matSignature;
-    int         pstScoreOpening;
-    int         pstScoreEndgame;
+    PackedScore pstScore;
 };
 
 #endif // UNDOINFO_H_
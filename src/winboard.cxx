@@ -102,6 +102,17 @@ bool handleKiwiBookSave( StringTokenizer & args, Command & command )
     return result;
 }
 
+bool handleOptionalInteger( StringTokenizer & args, Command & command )
+{
+    bool result = true;
+
+    if( args.hasMoreTokens() ) {
+        result = handleInteger( args, command );
+    }
+
+    return result;
+}
+
 bool handleKiwiRunSuite( StringTokenizer & args, Command & command )
 {
     bool result = true;
@@ -116,6 +127,20 @@ bool handleKiwiRunSuite( StringTokenizer & args, Command & command )
     return result;
 }
 
+bool handleKiwiPerftSuite( StringTokenizer & args, Command & command )
+{
+    bool result = true;
+
+    result &= handleString( args, command );    // Suite filename
+    result &= handleInteger( args, command );   // Max depth
+
+    if( args.hasMoreTokens() ) {
+        result &= handleString( args, command );    // Optional: output file (JSON or CSV)
+    }
+
+    return result;
+}
+
 bool handleKiwiSetOption( StringTokenizer & args, Command & command )
 {
     bool result = true;
@@ -182,7 +207,7 @@ bool handleXBoardProtover( StringTokenizer & args, Command & command )
 
         if( protocolVersion >= 2 ) {
             printf( "feature myname=\"%s\"\n", Engine::myName );
-            printf( "feature colors=0 ping=1 playother=1 setboard=1 sigint=0 sigterm=0 usermove=1\n" );
+            printf( "feature colors=0 ping=1 playother=1 setboard=1 sigint=0 sigterm=0 usermove=1 smp=1 memory=1\n" );
             printf( "feature done=1\n" );
         }
     }
@@ -233,12 +258,15 @@ CommandInfo commandInfo[] = {
     "accepted",     cmd_Null,                   0,  // Ignore
     "an",           cmd_KiwiAnalyze,            handleXBoardSetBoard,
     "analyze",      cmd_EnterAnalyzeMode,       0,
+    "bench",        cmd_KiwiBenchmark,          handleOptionalInteger,
     "bestm",        cmd_KiwiBestMove,           0,
     "bk",           cmd_ShowBook,               0,
     "bookadd",      cmd_KiwiAddToBookTree,      handleKiwiBookAdd,
     "bookload",     cmd_KiwiLoadBook,           handleString,
     "booksave",     cmd_KiwiExportBookTree,     handleKiwiBookSave,
     "computer",     cmd_SetOpponentIsComputer,  0,
+    "cores",        cmd_SetCores,               handleInteger,
+    "divide",       cmd_KiwiPerftDivide,        handleInteger,
     "draw",         cmd_OpponentOffersDraw,     0,
     "easy",         cmd_SetPonderingOff,        0,
     "evalt",        cmd_KiwiEvaluateSuite,      handleString,
@@ -247,13 +275,16 @@ CommandInfo commandInfo[] = {
     "genbb",        cmd_KiwiGenBB,              0,
     "go",           cmd_Go,                     0,
     "hard",         cmd_SetPonderingOn,         0,
+    "hashtest",     cmd_KiwiHashTest,           handleOptionalInteger,
     "help",         cmd_KiwiHelp,               0,
     "hint",         cmd_ShowHint,               0,
     "level",        cmd_SetLevel,               handleXBoardLevel,
+    "memory",       cmd_SetMemory,              handleInteger,
     "new",          cmd_New,                    0,
     "nopost",       cmd_HideThinking,           0,
     "otim",         cmd_SetOpponentClock,       handleInteger,
     "perft",        cmd_KiwiPerft,              handleInteger,
+    "perftsuite",   cmd_KiwiPerftSuite,         handleKiwiPerftSuite,
     "ping",         cmd_Ping,                   handleInteger,
     "playother",    cmd_GoPlayOther,            0,
     "post",         cmd_ShowThinking,           0,
@@ -270,6 +301,8 @@ CommandInfo commandInfo[] = {
     "suite",        cmd_KiwiRunSuite,           handleKiwiRunSuite,
     "test",         cmd_KiwiTest,               0,
     "time",         cmd_SetClock,               handleInteger,
+    "ttload",       cmd_KiwiLoadHashTable,      handleString,
+    "ttsave",       cmd_KiwiSaveHashTable,      handleString,
     "undo",         cmd_UndoLastHalfMove,       0,
     "usermove",     cmd_OpponentMoves,          handleString,
     "xboard",       cmd_Null,                   0,
@@ -524,13 +557,15 @@ void WinBoardAdapter::showThinking( const Position & pos, const MoveInfo & move
         }
     }
 
-    Log::write( "%2d/%2d %6s  %02u:%02u %9u %s\n", 
+    // Hash table usage is not part of the protocol, so it only goes to the log
+    Log::write( "%2d/%2d %6s  %02u:%02u %9u %4u %s\n", 
         move.depth, 
         move.maxdepth,
         score,
         move.time / 60000, // Minutes
         (move.time % 60000) / 1000, // Seconds
         move.nodes,
+        move.hashfull,
         pv );
 }
 